@@ -17,10 +17,8 @@ void main() {
 
 #fragment
 uniform sampler2D u_Texture0;
-uniform vec4 u_Color;
 
 uniform bool u_UseTexture;
-uniform bool u_UseColor;
 
 in vec2 TexCoord;
 in vec4 Color;
@@ -34,9 +32,5 @@ void main() {
         final = texture(u_Texture0, TexCoord);
     }
 
-    if (u_UseColor) {
-        final *= u_Color;
-    }
-
-    FragColor = final;
+    FragColor = final * Color;
 }
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+
+// Headless benchmarks, run from the command line instead of the game and
+// report to stdout. They return a process exit code.
+
+// --bench-load: writes a synthetic world file with over 100k chunks, then
+// times loading and meshing it on one thread against the parallel pipeline.
+int runLoadBenchmark();
+
+// --bench-lines: times the integer line iterators against the old float
+// stepping on random segments, counting repeated and skipped voxels, and
+// capsule spans against a sphere per line voxel.
+int runLineBenchmark();
+
+// --bench-raycast: casts a 512 x 512 grid of rays at a synthetic terrain,
+// looking up the chunk per voxel against World::raycastBatch serially and
+// on the thread pool.
+int runRaycastBenchmark();
+
+// --bench-generate: generates the standard 512 x 128 x 512 benchmark world
+// with WorldGenerator on one thread and on the thread pool, and checks that
+// both come out the same.
+int runGenerateBenchmark();
+
+// --bench-csg: selects a shape built with every VoxelShape combinator at
+// growing radii on one thread and on the thread pool, and checks the
+// smallest against evaluating every voxel of its bounds.
+int runCsgBenchmark();
+
+// --bench-selection: grows and shrinks random voxels spanning several
+// chunks on every axis step by step and checks them against a per voxel
+// reference, then times grow, shrink and the set operations on 8.4M voxels.
+int runSelectionBenchmark();
+
+// --test-vox: round trips random worlds, one of them spanning several
+// models, through the .vox exporter and importer, imports a hand written
+// file to check palette mapping and voxels outside the model, and one
+// shifted partly below zero. Returns 1 on any mismatch.
+int runVoxTest();
+
+// runs the benchmark named by a command line flag, returns false for unknown flags
+bool runBenchmark(const std::string& flag, int& outExitCode);
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "world.hpp"
+#include "voxel_selection.hpp"
+#include "voxel_shape.hpp"
+
+enum class ToolShape {
+    SHAPE_SPHERE,
+    SHAPE_CUBE,
+    SHAPE_CYLINDER,
+    SHAPE_CONE,
+    SHAPE_TORUS
+};
+
+enum class BrushStrokeMode {
+    STROKE_PLACE,   // sets every voxel under the brush
+    STROKE_PAINT,   // recolors solid voxels only
+    STROKE_ERASE    // sets every voxel under the brush to air
+};
+
+// A brush dragged over the world while the mouse is held, or the Line tool.
+//
+// moveTo sweeps the brush from its last position to the new one, a capsule
+// for spheres and a thick line for cubes (see voxel_line.hpp), a Bresenham
+// line for brush size 0, other shapes are stamped along the Bresenham line,
+// so fast mouse movement leaves no gaps. Sweeps only
+// add x spans to a bitmap of pending voxels, overlaps cost nothing extra.
+// flush writes the pending voxels once per frame with one World::editChunk
+// per chunk, so each chunk is copied for the edit history, marks its
+// neighbours dirty and is remeshed at most once a frame. Voxels already
+// written earlier in the stroke are skipped. With a mask, only the voxels
+// in it are written, the mask is and-ed in word by word.
+class BrushStroke {
+public:
+    // mask must stay alive and unchanged until end
+    void begin(World& world, const glm::ivec3& position, int brushSize, ToolShape shape, BrushStrokeMode mode, unsigned char blockId, const VoxelSelection* mask = nullptr);
+    void moveTo(const glm::ivec3& position);
+    // writes the pending voxels, returns how many were written
+    size_t flush();
+    void end();
+
+    bool isActive() const { return _world != nullptr; }
+    const glm::ivec3& getPosition() const { return _position; }
+    // voxels written since begin
+    size_t getVoxelCount() const { return _written.getCount(); }
+
+    // adds the voxels of the brush swept from start to end to selection
+    static void sweep(VoxelSelection& selection, const glm::ivec3& start, const glm::ivec3& end, int brushSize, ToolShape shape);
+    // the brush as a shape around center, for the shapes that are not swept exactly
+    static VoxelShape getShape(const glm::vec3& center, int brushSize, ToolShape shape);
+
+private:
+    World* _world = nullptr;
+    glm::ivec3 _position = glm::ivec3(0);
+    int _brushSize = 0;
+    ToolShape _shape = ToolShape::SHAPE_SPHERE;
+    BrushStrokeMode _mode = BrushStrokeMode::STROKE_PLACE;
+    unsigned char _blockId = 0;
+    const VoxelSelection* _mask = nullptr;
+
+    VoxelSelection _pending;
+    VoxelSelection _written;
+};
@@ -1,70 +1,97 @@
 #pragma once
 
 #include <array>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <memory>
 #include <glm/glm.hpp>
 
 #include "engine/engine.hpp"
 
 #define CHUNK_SIZE 16
-// macro function to perform 3D DDA algorithm
-#define PERFORM_DDA(origin, direction, maxDistance, action) { \
-    glm::ivec3 voxel( \
-        static_cast<int>(std::floor(origin.x)), \
-        static_cast<int>(std::floor(origin.y)), \
-        static_cast<int>(std::floor(origin.z)) \
-    ); \
-    glm::ivec3 side(0, 0, 0); \
-    \
-    int stepX = (direction.x > 0) ? 1 : -1; \
-    int stepY = (direction.y > 0) ? 1 : -1; \
-    int stepZ = (direction.z > 0) ? 1 : -1; \
-    \
-    auto intbound = [](float s, float ds) { \
-        if(ds > 0) { \
-            return (glm::ceil(s) - s) / ds; \
-        } else if(ds < 0) { \
-            return (s - glm::floor(s)) / -ds; \
-        } else { \
-            return std::numeric_limits<float>::infinity(); \
-        } \
-    }; \
-    \
-    float tMaxX = intbound(origin.x, direction.x); \
-    float tMaxY = intbound(origin.y, direction.y); \
-    float tMaxZ = intbound(origin.z, direction.z); \
-    \
-    float tDeltaX = direction.x != 0 ? static_cast<float>(stepX) / direction.x : std::numeric_limits<float>::infinity(); \
-    float tDeltaY = direction.y != 0 ? static_cast<float>(stepY) / direction.y : std::numeric_limits<float>::infinity(); \
-    float tDeltaZ = direction.z != 0 ? static_cast<float>(stepZ) / direction.z : std::numeric_limits<float>::infinity(); \
-    \
-    float distance = 0.0f; \
-    \
-    while(distance < maxDistance) { \
-        if((voxel.x < 0 && stepX < 0) || \
-           (voxel.y < 0 && stepY < 0) || \
-           (voxel.z < 0 && stepZ < 0)) { \
-            break; \
-        } \
-        \
-        action \
-        \
-        if(tMaxX < tMaxY && tMaxX < tMaxZ) { \
-            voxel.x += stepX; \
-            distance = tMaxX; \
-            tMaxX += tDeltaX; \
-            side = glm::ivec3(-stepX, 0, 0); \
-        } else if(tMaxY < tMaxZ) { \
-            voxel.y += stepY; \
-            distance = tMaxY; \
-            tMaxY += tDeltaY; \
-            side = glm::ivec3(0, -stepY, 0); \
-        } else { \
-            voxel.z += stepZ; \
-            distance = tMaxZ; \
-            tMaxZ += tDeltaZ; \
-            side = glm::ivec3(0, 0, -stepZ); \
-        } \
-    } \
+#define CHUNK_VOLUME (CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE)
+
+typedef std::array<unsigned char, CHUNK_VOLUME> ChunkBlocks;
+
+// unit offsets in face order: front, back, left, right, top, bottom
+extern const glm::ivec3 FACE_DIRECTIONS[6];
+
+// number of non-zero bytes, counted 8 bytes at a time
+size_t countSolidBlocks(const unsigned char* blocks, size_t count);
+// Fast 64-bit hash, 8 bytes at a time. Not collision resistant, compare the
+// bytes as well before treating two arrays as equal.
+uint64_t hashBytes(const unsigned char* data, size_t size);
+
+// ray length from s to the first voxel boundary along one axis
+inline float getDDABoundary(float s, float ds) {
+    if(ds > 0) {
+        return (glm::ceil(s) - s) / ds;
+    } else if(ds < 0) {
+        return (s - glm::floor(s)) / -ds;
+    } else {
+        return std::numeric_limits<float>::infinity();
+    }
+}
+
+// 3D DDA through the voxels a ray passes, starting with the one holding
+// origin. Calls visit(voxel, side, distance) for each, side is the face the
+// ray entered through and distance the ray length there. Stops once visit
+// returns true, the distance reaches maxDistance or the ray heads off into
+// negative coordinates. Returns true if visit stopped it.
+template<typename Visit>
+inline bool performDDA(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, Visit&& visit) {
+    glm::ivec3 voxel(
+        static_cast<int>(std::floor(origin.x)),
+        static_cast<int>(std::floor(origin.y)),
+        static_cast<int>(std::floor(origin.z))
+    );
+    glm::ivec3 side(0, 0, 0);
+
+    int stepX = (direction.x > 0) ? 1 : -1;
+    int stepY = (direction.y > 0) ? 1 : -1;
+    int stepZ = (direction.z > 0) ? 1 : -1;
+
+    float tMaxX = getDDABoundary(origin.x, direction.x);
+    float tMaxY = getDDABoundary(origin.y, direction.y);
+    float tMaxZ = getDDABoundary(origin.z, direction.z);
+
+    float tDeltaX = direction.x != 0 ? static_cast<float>(stepX) / direction.x : std::numeric_limits<float>::infinity();
+    float tDeltaY = direction.y != 0 ? static_cast<float>(stepY) / direction.y : std::numeric_limits<float>::infinity();
+    float tDeltaZ = direction.z != 0 ? static_cast<float>(stepZ) / direction.z : std::numeric_limits<float>::infinity();
+
+    float distance = 0.0f;
+
+    while(distance < maxDistance) {
+        if((voxel.x < 0 && stepX < 0) ||
+           (voxel.y < 0 && stepY < 0) ||
+           (voxel.z < 0 && stepZ < 0)) {
+            break;
+        }
+
+        if(visit(voxel, side, distance)) {
+            return true;
+        }
+
+        if(tMaxX < tMaxY && tMaxX < tMaxZ) {
+            voxel.x += stepX;
+            distance = tMaxX;
+            tMaxX += tDeltaX;
+            side = glm::ivec3(-stepX, 0, 0);
+        } else if(tMaxY < tMaxZ) {
+            voxel.y += stepY;
+            distance = tMaxY;
+            tMaxY += tDeltaY;
+            side = glm::ivec3(0, -stepY, 0);
+        } else {
+            voxel.z += stepZ;
+            distance = tMaxZ;
+            tMaxZ += tDeltaZ;
+            side = glm::ivec3(0, 0, -stepZ);
+        }
+    }
+
+    return false;
 }
 
 class World;
@@ -75,11 +102,37 @@ public:
 
     unsigned char getBlock(int x, int y, int z) const;
     void setBlock(int x, int y, int z, unsigned char type);
+    // replaces all CHUNK_VOLUME blocks at once, in z, y, x order
+    void assignBlocks(const unsigned char* blocks);
+    // lets fill write all CHUNK_VOLUME blocks in place, e.g. to decode straight into the chunk
+    void fillBlocks(const std::function<void(unsigned char* blocks)>& fill);
+
+    const ChunkBlocks& getBlocks() const {
+        return *_data;
+    }
 
-    const std::array<unsigned char, CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE>& getBlocks() const {
+    // Shares the block array without copying it. The array is copied on the
+    // next write while the returned pointer is alive, so it stays unchanged
+    // and can be read from other threads.
+    std::shared_ptr<const ChunkBlocks> shareBlocks() const {
         return _data;
     }
 
+    // Replaces the block array with blocks if they hold the same blocks,
+    // e.g. to let identical chunks share one array. Returns false without
+    // changing anything otherwise. Shared arrays are copied on the next write.
+    bool adoptBlocks(const std::shared_ptr<const ChunkBlocks>& blocks);
+
+    // hashBytes of the block array, cached until the next edit
+    uint64_t getBlocksHash() const;
+
+    // changes on every edit, unique across all chunks
+    uint64_t getRevision() const { return _revision; }
+
+    // edited since the last markSaved, either on disk or in the journal
+    bool isModified() const { return _revision != _savedRevision; }
+    void markSaved() { _savedRevision = _revision; }
+
     void setDirty(bool dirty) { _dirty = dirty; }
     bool isDirty() const { return _dirty; }
 
@@ -92,7 +145,15 @@ public:
     int getBlockCount() const { return _blockCount; }
     
 private:
-    std::array<unsigned char, CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE> _data;
+    void detachBlocks();
+
+    std::shared_ptr<ChunkBlocks> _data;
+    uint64_t _revision;
+    uint64_t _savedRevision = 0;
+
+    // revisions start at 1, so the hash is computed on first use
+    mutable uint64_t _blocksHash = 0;
+    mutable uint64_t _blocksHashRevision = 0;
     
     int _x, _y, _z;
     World* _world;
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "chunk.hpp"
+
+#include <string>
+
+// How a chunk's blocks are stored on disk. Values are part of the world file
+// format, never renumber them.
+enum class ChunkEncoding : uint8_t {
+    RAW = 0,     // CHUNK_VOLUME bytes as is
+    UNIFORM = 1, // a single block id filling the whole chunk
+    RLE = 2      // (run length - 1, block id) byte pairs
+};
+
+// Appends the smallest encoding of blocks to outPayload and returns it.
+ChunkEncoding encodeChunkBlocks(const unsigned char* blocks, std::string& outPayload);
+// Throws if the payload does not decode to exactly CHUNK_VOLUME blocks.
+void decodeChunkBlocks(ChunkEncoding encoding, const char* payload, size_t size, unsigned char* outBlocks);
+
+void rleEncode(const unsigned char* data, size_t size, std::string& out);
+void rleDecode(const char* data, size_t size, unsigned char* out, size_t outSize);
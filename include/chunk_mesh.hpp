@@ -2,22 +2,114 @@
 
 #include "chunk.hpp"
 
+#include <vector>
+
+// level 0 is full resolution, every further level halves it
+#define CHUNK_LOD_COUNT 3
+
+// Block data of a chunk and its six face neighbours (in face order), missing
+// neighbours are null and count as air.
+struct ChunkBlocksView {
+    const unsigned char* blocks = nullptr;
+    std::array<const unsigned char*, 6> neighbors {};
+};
+
+// Owned copy of a chunk and its neighbours, safe to mesh on a worker thread.
+struct ChunkSnapshot {
+    ChunkBlocks blocks;
+    std::array<ChunkBlocks, 6> neighbors;
+    std::array<bool, 6> hasNeighbor {};
+
+    ChunkBlocksView view() const;
+};
+
+// CPU side mesh. Border faces that are hidden only by the neighbouring chunk
+// are stored after skirtIndexStart, they get drawn when that neighbour is
+// rendered at a different LOD so no cracks open up between levels.
+struct ChunkMeshData {
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+    uint32_t skirtIndexStart = 0;
+
+    void clear() {
+        vertices.clear();
+        indices.clear();
+        skirtIndexStart = 0;
+    }
+};
+
+ChunkBlocksView getChunkBlocksView(const Chunk& chunk);
+ChunkSnapshot takeChunkSnapshot(const Chunk& chunk);
+
+void buildChunkMeshData(const ChunkBlocksView& view, int lod, ChunkMeshData& outData);
+void downsampleChunkBlocks(const unsigned char* blocks, int factor, unsigned char* outCells);
+
 class ChunkMesh {
 public:
     ChunkMesh(Chunk* chunk);
-    ~ChunkMesh();
+    ~ChunkMesh() = default;
+
+    // rebuilds the full resolution mesh, coarser levels become stale
+    void updateMesh();
+    // same with a full resolution mesh built elsewhere, e.g. on worker threads
+    void updateMesh(const ChunkMeshData& data);
+    // rebuilds an evicted full resolution mesh, the chunk itself is unchanged
+    void restoreMesh();
+    void uploadLod(int lod, const ChunkMeshData& data, uint64_t revision);
+    // frees the GPU buffers of a level, returns the bytes released
+    size_t releaseLod(int lod);
+
+    bool isLodResident(int lod) const { return _levels[lod].vao != nullptr; }
+    bool isLodCurrent(int lod) const { return _levels[lod].vao && _levels[lod].revision == _revision; }
+    bool isLodPending(int lod) const { return _levels[lod].pendingRevision == _revision; }
+    void setLodPending(int lod) { _levels[lod].pendingRevision = _revision; }
+    void clearLodPending(int lod) { _levels[lod].pendingRevision = 0; }
+
+    size_t getLodBytes(int lod) const { return _levels[lod].bytes; }
+    void markLodUsed(int lod, uint64_t frame) { _levels[lod].lastUsedFrame = frame; }
+    uint64_t getLodLastUsedFrame(int lod) const { return _levels[lod].lastUsedFrame; }
+
+    const gfx::VertexArray& getVertexArray(int lod = 0) const { return *_levels[lod].vao; }
+    uint32_t getIndexCount(int lod, bool withSkirts) const;
+
+    void setDrawLod(int lod, bool drawSkirts) { _drawLod = lod; _drawSkirts = drawSkirts; }
+    int getDrawLod() const { return _drawLod; }
+    uint32_t getDrawIndexCount() const { return _visible ? getIndexCount(_drawLod, _drawSkirts) : 0; }
+
+    void setVisible(bool visible) { _visible = visible; }
+    bool isVisible() const { return _visible; }
 
-    void updateMesh() const;
-    const gfx::VertexArray& getVertexArray() const { return _vao; }
     Chunk* getChunk() const { return _chunk; }
+    uint64_t getRevision() const { return _revision; }
 
 private:
+    struct Level {
+        unique<gfx::VertexArray> vao;
+        uint32_t indexCount = 0;
+        uint32_t skirtIndexStart = 0;
+        size_t bytes = 0;
+
+        uint64_t revision = 0;
+        uint64_t pendingRevision = 0;
+        uint64_t lastUsedFrame = 0;
+    };
+
+    void buildFullResolution();
+
     Chunk* _chunk;
-    gfx::VertexArray _vao;
+    std::array<Level, CHUNK_LOD_COUNT> _levels;
+    uint64_t _revision = 0;
 
-    float* _vertex_buffer;
-    unsigned int* _index_buffer;
+    int _drawLod = 0;
+    bool _drawSkirts = false;
+    bool _visible = true;
 };
 
+void emitFace(
+    float* vertices, unsigned int* indices,
+    unsigned int& vertex_count, unsigned int& index_count,
+    int face, float textureID, float fx, float fy, float fz, float size = 1.0f
+);
+
 std::unique_ptr<gfx::VertexArray> createCubeMeshVAO(int textureID);
-void renderCubeMesh(gfx::VertexArray& vao, int textureID);
\ No newline at end of file
+void renderCubeMesh(gfx::VertexArray& vao, int textureID);
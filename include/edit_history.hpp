@@ -0,0 +1,99 @@
+#pragma once
+
+#include "world.hpp"
+
+#include <deque>
+
+// default limit of EditHistory::getMemoryUsage
+#define EDIT_HISTORY_MEMORY_LIMIT (64 * 1024 * 1024)
+
+// Undo and redo of world edits.
+//
+// Edits between begin() and commit() form one step. While recording, the
+// first write to each chunk shares its block array as it was (see
+// World::setChunkEditCallback), the chunk copies it on that write. commit()
+// keeps only the XOR of the chunk before and after the step, run length
+// encoded, so unchanged cells cost next to nothing. The same delta turns
+// the chunk into either state, undo and redo write it back with one
+// World::editChunk per chunk.
+//
+// Deltas are a sequence of u16 tokens: with the high bit set, the next byte
+// repeated (token & 0x7FFF) times, otherwise token literal bytes.
+//
+// The oldest steps are dropped once the history uses more than its memory
+// limit, the newest step is always kept.
+class EditHistory {
+public:
+    explicit EditHistory(size_t memoryLimit = EDIT_HISTORY_MEMORY_LIMIT);
+    ~EditHistory();
+
+    EditHistory(const EditHistory&) = delete;
+    EditHistory& operator=(const EditHistory&) = delete;
+
+    // Starts recording edits to world. Nested calls are part of the step of
+    // the outermost one.
+    void begin(World& world);
+    // Ends the step, returns false if it changed nothing. Clears the redo
+    // steps otherwise.
+    bool commit();
+    bool isRecording() const { return _depth > 0; }
+
+    // return false when there is nothing to undo or redo
+    bool undo(World& world);
+    bool redo(World& world);
+
+    bool canUndo() const { return !_undoSteps.empty(); }
+    bool canRedo() const { return !_redoSteps.empty(); }
+    size_t getUndoCount() const { return _undoSteps.size(); }
+    size_t getRedoCount() const { return _redoSteps.size(); }
+
+    // bytes held by the deltas of all undo and redo steps
+    size_t getMemoryUsage() const { return _memoryUsage; }
+    void setMemoryLimit(size_t memoryLimit);
+
+    void clear();
+
+private:
+    struct ChunkDelta {
+        glm::ivec3 coords;
+        bool existedBefore;
+        bool existsAfter;
+        std::vector<uint8_t> delta;
+    };
+
+    struct Step {
+        std::vector<ChunkDelta> chunks;
+        size_t memoryUsage = 0;
+    };
+
+    // a chunk written to during the current step, as it was before
+    struct RecordedChunk {
+        glm::ivec3 coords;
+        // null if the chunk didn't exist
+        std::shared_ptr<const ChunkBlocks> blocks;
+    };
+
+    void recordChunk(const glm::ivec3& coords, const Chunk* chunk);
+    // sets every chunk of the step to the state before it or after it
+    void apply(World& world, const Step& step, bool before) const;
+    void trim();
+
+    World* _world = nullptr;
+    int _depth = 0;
+
+    std::unordered_map<uint64_t, RecordedChunk> _recordedChunks;
+    // most chunk writes in a row hit the same chunk
+    uint64_t _lastRecordedKey = 0;
+    bool _hasLastRecordedKey = false;
+
+    std::deque<Step> _undoSteps;
+    std::vector<Step> _redoSteps;
+
+    size_t _memoryUsage = 0;
+    size_t _memoryLimit;
+};
+
+// XOR of two block arrays in the delta format above, either may be null for air
+void encodeChunkDelta(const unsigned char* before, const unsigned char* after, std::vector<uint8_t>& out);
+// XORs blocks with the delta, applying it twice restores the blocks
+void applyChunkDelta(const uint8_t* delta, size_t size, unsigned char* blocks);
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <memory>
 #include <map>
 
@@ -31,7 +32,13 @@ namespace assets {
             int width = 0;
             int height = 0;
 
-            std::unordered_map<char, Glyph> glyphs;
+            // ASCII only, indexed directly by character code
+            std::array<Glyph, 128> glyphs {};
+
+            const Glyph* getGlyph(char c) const {
+                auto index = static_cast<unsigned char>(c);
+                return index < glyphs.size() ? &glyphs[index] : nullptr;
+            }
         };
 
         ~Font();
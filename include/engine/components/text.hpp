@@ -14,6 +14,10 @@ public:
         : _content(content), _font(font), _fontSize(fontSize) {}
 
     void setContent(const std::string& content) {
+        if(_content == content) {
+            return;
+        }
+
         _content = content;
         _dirty = true;
     }
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "engine/core/core.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+namespace core {
+    // Appends little-endian values to a byte string, independent of the host byte order.
+    class BinaryWriter {
+    public:
+        BinaryWriter(std::string& buffer) : _buffer(buffer) {}
+
+        template<typename T>
+        void write(T value) {
+            static_assert(std::is_integral<T>::value, "BinaryWriter only writes integers");
+
+            using U = typename std::make_unsigned<T>::type;
+            U bits = static_cast<U>(value);
+
+            for(size_t i = 0; i < sizeof(T); ++i) {
+                _buffer.push_back(static_cast<char>((bits >> (i * 8)) & 0xFF));
+            }
+        }
+
+        void writeBytes(const void* data, size_t size) {
+            _buffer.append(static_cast<const char*>(data), size);
+        }
+
+        void writeString(const std::string& value) {
+            write<uint32_t>(static_cast<uint32_t>(value.size()));
+            writeBytes(value.data(), value.size());
+        }
+
+        // overwrites a value written earlier, used to patch offsets
+        template<typename T>
+        void writeAt(size_t offset, T value) {
+            std::string bytes;
+            BinaryWriter(bytes).write(value);
+
+            if(offset + bytes.size() > _buffer.size()) {
+                throw std::runtime_error("BinaryWriter: patch outside of buffer.");
+            }
+
+            _buffer.replace(offset, bytes.size(), bytes);
+        }
+
+        size_t getPosition() const { return _buffer.size(); }
+
+    private:
+        std::string& _buffer;
+    };
+
+    // Reads little-endian values from a byte range, every read is bounds checked.
+    class BinaryReader {
+    public:
+        BinaryReader(const char* data, size_t size) : _data(data), _size(size) {}
+        BinaryReader(const std::string& buffer) : _data(buffer.data()), _size(buffer.size()) {}
+
+        template<typename T>
+        T read() {
+            static_assert(std::is_integral<T>::value, "BinaryReader only reads integers");
+
+            require(sizeof(T));
+
+            using U = typename std::make_unsigned<T>::type;
+            U bits = 0;
+
+            for(size_t i = 0; i < sizeof(T); ++i) {
+                bits |= static_cast<U>(static_cast<unsigned char>(_data[_position + i])) << (i * 8);
+            }
+
+            _position += sizeof(T);
+            return static_cast<T>(bits);
+        }
+
+        void readBytes(void* out, size_t size) {
+            require(size);
+
+            std::memcpy(out, _data + _position, size);
+            _position += size;
+        }
+
+        std::string readString() {
+            uint32_t length = read<uint32_t>();
+            require(length);
+
+            std::string value(_data + _position, length);
+            _position += length;
+
+            return value;
+        }
+
+        const char* skip(size_t size) {
+            require(size);
+
+            const char* start = _data + _position;
+            _position += size;
+
+            return start;
+        }
+
+        void seek(size_t position) {
+            if(position > _size) {
+                throw std::runtime_error("BinaryReader: seek past end of data.");
+            }
+
+            _position = position;
+        }
+
+        size_t getPosition() const { return _position; }
+        size_t getSize() const { return _size; }
+        size_t getRemaining() const { return _size - _position; }
+
+    private:
+        void require(size_t size) const {
+            if(size > _size - _position) {
+                throw std::runtime_error("BinaryReader: unexpected end of data.");
+            }
+        }
+
+        const char* _data;
+        size_t _size;
+        size_t _position = 0;
+    };
+}
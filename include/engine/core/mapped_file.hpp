@@ -0,0 +1,30 @@
+#pragma once
+
+#include "engine/core/core.hpp"
+
+namespace core {
+    // Read-only view of a whole file. Uses mmap where available so pages are
+    // only read when touched, other platforms read the file into memory.
+    class MappedFile {
+    public:
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        // throws if the file can't be opened
+        static unique<MappedFile> open(const std::string& path);
+
+        const char* getData() const { return _data; }
+        size_t getSize() const { return _size; }
+
+    private:
+        MappedFile() = default;
+
+        const char* _data = nullptr;
+        size_t _size = 0;
+
+        void* _mapping = nullptr;
+        std::string _buffer;
+    };
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "engine/core/core.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace core {
+    // Fixed set of worker threads pulling jobs from a single queue. A pool
+    // without workers (Emscripten builds have no pthreads) runs every job
+    // inline on the calling thread.
+    class ThreadPool {
+    public:
+        explicit ThreadPool(size_t workerCount);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        void submit(std::function<void()> job);
+
+        // Splits [0, count) into ranges and blocks until all of them ran. The
+        // calling thread takes ranges as well, so this is safe to call from a job.
+        // If job throws, the remaining ranges are skipped and the first exception
+        // is rethrown once every range is accounted for.
+        void parallelFor(size_t count, const std::function<void(size_t begin, size_t end)>& job);
+
+        size_t getWorkerCount() const { return _workers.size(); }
+
+        static ThreadPool& getDefault();
+
+    private:
+        void workerLoop();
+
+        std::vector<std::thread> _workers;
+        std::deque<std::function<void()>> _jobs;
+
+        std::mutex _mutex;
+        std::condition_variable _condition;
+        bool _stopping = false;
+    };
+}
@@ -16,6 +16,8 @@ namespace gfx {
 
         void setVertexBuffer(std::unique_ptr<VertexBuffer> vertexBuffer);
         void setIndexBuffer(std::unique_ptr<IndexBuffer> indexBuffer);
+        // attributes advance once per instance and follow the vertex buffer attributes
+        void setInstanceBuffer(std::unique_ptr<VertexBuffer> instanceBuffer);
 
         constexpr uint32_t getID() const { return _id; }
 
@@ -27,10 +29,17 @@ namespace gfx {
             return _indexBuffer;
         }
 
+        const std::unique_ptr<VertexBuffer>& getInstanceBuffer() const {
+            return _instanceBuffer;
+        }
+
     private:
         uint32_t _id;
         
         std::unique_ptr<VertexBuffer> _vertexBuffer;
         std::unique_ptr<IndexBuffer> _indexBuffer;
+        std::unique_ptr<VertexBuffer> _instanceBuffer;
+
+        uint32_t _vertexAttributeCount = 0;
     };
 }
\ No newline at end of file
@@ -28,6 +28,8 @@ namespace gfx {
         virtual void clear() = 0;
         virtual void clear(float r, float g, float b, float a) = 0;
         virtual void drawVAO(const VertexArray& vao, RenderMode mode) = 0;
+        virtual void drawVAO(const VertexArray& vao, RenderMode mode, uint32_t indexCount, uint32_t indexOffset) = 0;
+        virtual void drawVAOInstanced(const VertexArray& vao, uint32_t instanceCount, RenderMode mode) = 0;
         virtual void drawEmpty(int count) = 0;
 
         virtual void useShader(const Shader& shader) = 0;
@@ -11,6 +11,8 @@ namespace gfx {
         void clear() override;
         void clear(float r, float g, float b, float a) override;
         void drawVAO(const VertexArray& vao, RenderMode mode = RenderMode::TRIANGLES) override;
+        void drawVAO(const VertexArray& vao, RenderMode mode, uint32_t indexCount, uint32_t indexOffset) override;
+        void drawVAOInstanced(const VertexArray& vao, uint32_t instanceCount, RenderMode mode = RenderMode::TRIANGLES) override;
         void drawEmpty(int count) override;
         void useShader(const Shader& shader) override;
         void bindTexture(unsigned int slot, const Texture& texture) override;
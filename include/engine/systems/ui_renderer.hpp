@@ -1,5 +1,7 @@
 #pragma once
 
+#include <vector>
+
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -12,6 +14,10 @@
 #include "engine/components/transform2d.hpp"
 #include "engine/components/sprite.hpp"
 
+// Quads and sprites are transformed on the CPU and queued until flush(),
+// which uploads the whole batch once and issues one draw per texture.
+// Quads sharing a texture keep their submission order, quads with different
+// textures are not ordered relative to each other.
 class UIRenderer {
 public:
     UIRenderer() = delete;
@@ -22,10 +28,34 @@ public:
 
     void renderSprite(gfx::Shader& shader, const Sprite& sprite);
 
+    void flush();
+
 private:
+    struct QuadVertex {
+        glm::vec2 position;
+        glm::vec2 uv;
+        glm::vec4 color;
+    };
+
+    struct BatchQuad {
+        const gfx::Texture* texture;
+        QuadVertex vertices[4];
+    };
+
+    void submitQuad(
+        gfx::Shader& shader, const gfx::Texture& texture,
+        const glm::vec2& position, const glm::vec2& size, float angle,
+        const glm::vec4& uvs, const glm::vec4& color
+    );
+    void reserveIndices(uint32_t quadCount);
+
     gfx::Renderer& _renderer;
     const Camera& _camera;
 
-    std::unique_ptr<gfx::VertexArray> _quadVAO;
-    std::unique_ptr<gfx::VertexArray> _spriteVAO;
-};
\ No newline at end of file
+    gfx::Shader* _batchShader = nullptr;
+    std::vector<BatchQuad> _quads;
+    std::vector<QuadVertex> _vertices;
+
+    std::unique_ptr<gfx::VertexArray> _batchVAO;
+    uint32_t _indexCapacity = 0;
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+class Frustum {
+public:
+    Frustum() = default;
+
+    // planes are pulled straight from the combined matrix, so this works for
+    // both perspective and orthographic projections
+    explicit Frustum(const glm::mat4& viewProjection) {
+        glm::vec4 row0(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+        glm::vec4 row1(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+        glm::vec4 row2(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+        glm::vec4 row3(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+
+        planes[0] = row3 + row0; // left
+        planes[1] = row3 - row0; // right
+        planes[2] = row3 + row1; // bottom
+        planes[3] = row3 - row1; // top
+        planes[4] = row3 + row2; // near
+        planes[5] = row3 - row2; // far
+    }
+
+    bool intersectsAABB(const glm::vec3& min, const glm::vec3& max) const {
+        for(const auto& plane : planes) {
+            // corner furthest along the plane normal
+            glm::vec3 corner(
+                plane.x >= 0.0f ? max.x : min.x,
+                plane.y >= 0.0f ? max.y : min.y,
+                plane.z >= 0.0f ? max.z : min.z
+            );
+
+            if(plane.x * corner.x + plane.y * corner.y + plane.z * corner.z + plane.w < 0.0f) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    glm::vec4 planes[6];
+};
@@ -5,9 +5,19 @@
 #include "world.hpp"
 #include "text_renderer.hpp"
 #include "world_mesh.hpp"
+#include "world_saver.hpp"
+#include "world_streamer.hpp"
+#include "vox_format.hpp"
+#include "voxel_clipboard.hpp"
+#include "edit_history.hpp"
+#include "brush_stroke.hpp"
+#include "world_components.hpp"
+#include "tool_preview.hpp"
+#include "world_generator.hpp"
 #include "ray.hpp"
 
 #include <chrono>
+#include <filesystem>
 #include <iostream>
 
 #include <vector>
@@ -25,11 +35,6 @@ enum ToolType {
     TOOL_MOVE
 };
 
-enum class ToolShape {
-    SHAPE_SPHERE,
-    SHAPE_CUBE
-};
-
 enum AxisLock {
     AXIS_LOCK_NONE,
     AXIS_LOCK_X,
@@ -37,6 +42,31 @@ enum AxisLock {
     AXIS_LOCK_Z
 };
 
+struct ToolPreviewState {
+    ToolType tool = ToolType::TOOL_PLACE;
+    ToolShape shape = ToolShape::SHAPE_SPHERE;
+    int brushSize = 0;
+    unsigned char blockType = 0;
+
+    bool hasHit = false;
+    glm::ivec3 block = glm::ivec3(0, 0, 0);
+    glm::ivec3 side = glm::ivec3(0, 0, 0);
+
+    bool lineInProgress = false;
+    glm::ivec3 lineStart = glm::ivec3(0, 0, 0);
+
+    bool operator==(const ToolPreviewState& other) const {
+        return tool == other.tool && shape == other.shape &&
+               brushSize == other.brushSize && blockType == other.blockType &&
+               hasHit == other.hasHit && block == other.block && side == other.side &&
+               lineInProgress == other.lineInProgress && lineStart == other.lineStart;
+    }
+
+    bool operator!=(const ToolPreviewState& other) const {
+        return !(*this == other);
+    }
+};
+
 class Game {
 public:
     void init();
@@ -60,6 +90,7 @@ private:
     std::shared_ptr<assets::Font> font;
 
     gfx::Shader voxelShader;
+    gfx::Shader voxelInstancedShader;
     gfx::Shader textShader;
     gfx::Shader gridShader;
     gfx::Shader outlineShader;
@@ -79,10 +110,11 @@ private:
     std::unique_ptr<Text> brushSizeText;
     std::unique_ptr<Text> currentPaletteText;
     std::unique_ptr<Text> drawCallText;
+    std::unique_ptr<Text> meshMemoryText;
+    std::unique_ptr<Text> meshLodMemoryText;
     std::unique_ptr<Text> axisLockText;
 
     std::unique_ptr<gfx::VertexArray> outlineVAO;
-    std::unique_ptr<gfx::VertexArray> previewVAO;
 
     std::shared_ptr<gfx::Texture> paletteTexture;
     std::unique_ptr<Sprite> sprite;
@@ -90,12 +122,16 @@ private:
     std::unique_ptr<Sprite> uiBackgroundSprite;
 
     std::unique_ptr<WorldMesh> worldMesh;
+    std::unique_ptr<WorldStreamer> worldStreamer;
 
     std::unique_ptr<World> world;
+    std::unique_ptr<WorldSaver> worldSaver;
+    std::string worldSavePath;
     unsigned char blockType = 0;
 
-    std::unique_ptr<World> toolWorld;
-    std::unique_ptr<WorldMesh> toolWorldMesh;
+    std::unique_ptr<ToolPreview> toolPreview;
+    ToolPreviewState toolPreviewState;
+    bool toolPreviewDirty = true;
 
     //std::optional<WorldRayHit> rayHit;
 
@@ -122,8 +158,34 @@ private:
     AxisLock axisLock = AxisLock::AXIS_LOCK_NONE;
     glm::ivec3 axisLockPosition = glm::ivec3(0, 0, 0);
 
-    std::vector<glm::ivec3> moveVoxels;
+    // voxels picked up by the Move tool, at their original position
+    VoxelSelection moveVoxels;
     glm::ivec3 moveVoxelsStart;
+    // the preview holds the picked up voxels, only its offset follows the mouse
+    bool moveVoxelsPreviewed = false;
+
+    // Ctrl+click with the Brush tool picks the voxels connected to the one
+    // clicked, Ctrl+Shift+click adds them, Ctrl+click on air clears it. While
+    // it is not empty, strokes only change voxels inside. [ and ] shrink and
+    // grow it, Enter paints all of it. Bulk edits, undo and redo clear it.
+    VoxelSelection paintMask;
+
+    // Ctrl+C and Ctrl+V
+    VoxelClipboard clipboard;
+
+    // G generates terrain from this seed, Shift+G from the next one
+    uint32_t worldGeneratorSeed = 1;
+
+    // Ctrl+Z and Ctrl+Y, one step per tool use, paste or import
+    EditHistory editHistory;
+
+    // Place, Brush and Erase while the left mouse button is held, one edit history step
+    BrushStroke brushStroke;
+    // voxel and face the stroke started at, later centers are picked in the
+    // layer through strokeCenter across strokeAxis
+    glm::ivec3 strokeCenter = glm::ivec3(0);
+    glm::ivec3 strokeSide = glm::ivec3(0);
+    int strokeAxis = 1;
 
     Ray mouseRay;
     std::optional<WorldRayHit> brushHit;
@@ -134,10 +196,12 @@ private:
     bool showBoundingBox = true;
     bool isMovingCamera = true;
     bool lineInProgress = false;
+    glm::ivec3 lineStart = glm::ivec3(0, 0, 0);
 
     int y_plane = -1;
 
     std::chrono::steady_clock::time_point lastTime;
+    std::chrono::high_resolution_clock::time_point lastAutosaveTime;
     double frameCounter = 0.0;
     int drawCallCounter = 0;
 
@@ -146,5 +210,22 @@ private:
     void set_current_palette_sprite_uvs(int index);
     void update_current_tool_text();
     void update_axis_lock_text();
+    void update_mesh_memory_text();
+    void update_tool_preview();
+    void autosave_world();
+    void undo_edit();
+    void redo_edit();
+    void report_components();
+    void import_vox();
+    void generate_world();
+    std::optional<WorldRayHit> find_stroke_plane_hit() const;
+    void pick_paint_mask();
+    void clear_paint_mask();
+    void paint_mask();
+    // the tool shape scaled up at the hovered voxel through VoxelShape::select
+    void stamp_shape(bool carve);
+    void export_vox();
+    void save_clipboard();
+    void load_clipboard();
     void construct_ui();
 };
\ No newline at end of file
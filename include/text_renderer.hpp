@@ -2,15 +2,74 @@
 
 #include "engine/engine.hpp"
 
+#include <vector>
+
+// Layouts are shaped once per (content, font, size) and reused by every Text
+// that shows the same string. renderText() only queues glyph quads, flush()
+// uploads them in one buffer and draws once per font page.
 class TextRenderer {
 public:
-    TextRenderer(gfx::Renderer& renderer, const Camera& camera) : _renderer(renderer), _camera(camera) {}
+    TextRenderer(gfx::Renderer& renderer, const Camera& camera);
 
     void renderText(gfx::Shader& shader, Text& text);
+    void flush();
+
 private:
+    struct TextVertex {
+        glm::vec2 position;
+        glm::vec2 uv;
+    };
+
+    struct TextLayoutKey {
+        std::string content;
+        const assets::Font* font;
+        int fontSize;
+
+        bool operator==(const TextLayoutKey& other) const {
+            return font == other.font && fontSize == other.fontSize && content == other.content;
+        }
+    };
+
+    struct TextLayoutKeyHash {
+        size_t operator()(const TextLayoutKey& key) const {
+            size_t hash = std::hash<std::string>()(key.content);
+            hash ^= std::hash<const void*>()(key.font) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+            hash ^= std::hash<int>()(key.fontSize) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+            return hash;
+        }
+    };
+
+    struct TextLayout {
+        std::vector<TextVertex> vertices;
+        glm::vec2 size;
+        const gfx::Texture* texture;
+
+        uint64_t lastUsedFrame = 0;
+    };
+
+    struct TextBatch {
+        const gfx::Texture* texture;
+        std::vector<TextVertex> vertices;
+    };
+
+    static void buildLayout(const std::string& content, const assets::Font::FontPage& fontPage, TextLayout& outLayout);
+
+    const TextLayout& getLayout(Text& text);
+    const gfx::Texture& getPageTexture(const assets::Font::FontPage& page);
+    void reserveIndices(uint32_t quadCount);
+
     gfx::Renderer& _renderer;
     const Camera& _camera;
 
-    std::unordered_map<const Text*, unique<gfx::VertexArray>> _textVaos;
+    std::unordered_map<TextLayoutKey, TextLayout, TextLayoutKeyHash> _layouts;
+    std::unordered_map<const Text*, TextLayout*> _textLayouts;
     std::unordered_map<const assets::Font::FontPage*, unique<gfx::Texture>> _fontPageTextures;
-};
\ No newline at end of file
+
+    gfx::Shader* _batchShader = nullptr;
+    std::vector<TextBatch> _batches;
+    std::vector<TextVertex> _vertices;
+
+    unique<gfx::VertexArray> _batchVAO;
+    uint32_t _indexCapacity = 0;
+    uint64_t _frame = 1;
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "engine/engine.hpp"
+#include "voxel_selection.hpp"
+
+#include <vector>
+
+class World;
+
+// Draws tool previews as instanced unit cubes. Faces shared by two preview
+// voxels are hidden per instance so translucent previews don't stack.
+class ToolPreview {
+public:
+    ToolPreview();
+    ~ToolPreview() = default;
+
+    void setVoxels(const std::vector<glm::ivec3>& voxels, unsigned char blockId);
+    void setVoxels(const std::vector<glm::ivec3>& voxels, const std::vector<unsigned char>& blockIds);
+    // the selected solid voxels of world with their blocks, e.g. for the Move
+    // tool, which then only moves them around with setOffset
+    void setVoxels(const World& world, const VoxelSelection& selection);
+    void clear();
+
+    // translation of the whole preview, reset by setVoxels
+    void setOffset(const glm::vec3& offset) { _offset = offset; }
+    const glm::vec3& getOffset() const { return _offset; }
+
+    const gfx::VertexArray& getVertexArray() const { return *_vao; }
+    uint32_t getInstanceCount() const { return _instanceCount; }
+
+private:
+    struct Instance {
+        glm::vec3 position;
+        float textureID;
+        float faceMask;
+    };
+
+    void upload();
+
+    unique<gfx::VertexArray> _vao;
+    std::vector<Instance> _instances;
+    uint32_t _instanceCount = 0;
+    glm::vec3 _offset = glm::vec3(0.0f);
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "world.hpp"
+
+#include <array>
+
+// "VOX " read as a little-endian u32
+#define VOX_MAGIC 0x20584F56
+#define VOX_VERSION 200
+// largest model size MagicaVoxel accepts on each axis
+#define VOX_MAX_MODEL_SIZE 256
+
+// Exchange of voxel models with MagicaVoxel. Files hold models of at most
+// 256^3 voxels with one byte color indices into a 255 color palette, and an
+// optional scene graph that places the models. MagicaVoxel is z up, a voxel
+// at (x, y, z) in the file is at (x, z, -y - 1) in the world.
+//
+// Colors are mapped to the nearest block color, block id n has color
+// blockColors[n - 1] like the palette in Game. Files without a palette
+// cycle through the block ids instead, the default MagicaVoxel palette isn't
+// built in. Rotations in the scene graph are applied, animation frames past
+// the first, layers and materials are ignored.
+
+struct VoxImportResult {
+    size_t modelCount = 0;
+    size_t voxelCount = 0;
+    // voxels that would land at negative world coordinates
+    size_t skippedVoxelCount = 0;
+    size_t chunkCount = 0;
+};
+
+// block id for each .vox color index, index 0 is empty and maps to 0
+std::array<unsigned char, 256> createVoxPaletteMap(const std::array<uint32_t, 256>& voxColors, const std::vector<glm::vec4>& blockColors);
+
+// Adds the voxels of a .vox file to the world, with the minimum corner of
+// the scene at origin. Voxels are collected per chunk and each chunk is
+// written once with World::editChunk, empty voxels keep what was there.
+// Throws on malformed files.
+VoxImportResult importVox(World& world, const char* data, size_t size, const glm::ivec3& origin, const std::vector<glm::vec4>& blockColors);
+// maps the file instead of reading it whole
+VoxImportResult importVoxFile(World& world, const std::string& path, const glm::ivec3& origin, const std::vector<glm::vec4>& blockColors);
+
+// Writes every block of the world, loaded or not, as a .vox file. Worlds
+// larger than a model are split into 256^3 models placed by the scene
+// graph. Returns the number of voxels written.
+size_t exportVox(const World& world, const std::vector<glm::vec4>& blockColors, std::string& out);
+// throws if the file can't be written
+size_t exportVoxFile(const World& world, const std::string& path, const std::vector<glm::vec4>& blockColors);
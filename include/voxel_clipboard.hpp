@@ -0,0 +1,117 @@
+#pragma once
+
+#include "world.hpp"
+
+#include <string>
+#include <unordered_map>
+
+// "VXLC" read as a little-endian u32
+#define VOXEL_CLIPBOARD_MAGIC 0x434C5856
+#define VOXEL_CLIPBOARD_VERSION 1
+
+// edge length of the bricks a clipboard is stored in, divides CHUNK_SIZE
+#define CLIPBOARD_BRICK_SIZE 8
+#define CLIPBOARD_BRICK_VOLUME (CLIPBOARD_BRICK_SIZE * CLIPBOARD_BRICK_SIZE * CLIPBOARD_BRICK_SIZE)
+
+// Copied voxels in a box, e.g. a selection that is being moved or pasted.
+//
+// The box is split into 8^3 bricks. A brick holding a single value stores
+// only that value, others pack an index into the clipboard palette with as
+// few bits as their largest index needs (1, 2, 4 or 8). Palette index 0 is
+// empty: cells that weren't copied, pasting leaves the world there as it is.
+//
+// Files are little-endian:
+//
+//   u32 magic, u16 version, u16 flags
+//   i32 size x, y, z, i32 origin x, y, z
+//   u16 palette size, block id per palette index
+//   per brick in z, y, x order: u8 bits, u8 value
+//   u32 data size, packed brick data
+class VoxelClipboard {
+public:
+    VoxelClipboard() = default;
+
+    // copies the solid blocks among voxels
+    static VoxelClipboard copyVoxels(const World& world, const std::vector<glm::ivec3>& voxels);
+    // copies the solid blocks among the selected voxels, a chunk at a time
+    static VoxelClipboard copySelection(const World& world, const VoxelSelection& selection);
+    // Copies the solid blocks in the box from min to max inclusive. Bricks
+    // that line up with chunks are copied a row at a time from the chunk.
+    static VoxelClipboard copyBox(const World& world, const glm::ivec3& min, const glm::ivec3& max);
+
+    // Writes the copied voxels with their minimum corner at position, one
+    // World::editChunk per chunk. Single value bricks are written a row at
+    // a time. Voxels at negative coordinates are dropped.
+    void paste(World& world, const glm::ivec3& position) const;
+    // sets the copied voxels at position to air, e.g. before moving them
+    void erase(World& world, const glm::ivec3& position) const;
+
+    // quarter turns around the y axis, clockwise seen from above
+    VoxelClipboard rotated(int quarterTurns) const;
+    // flipped along axis 0, 1 or 2
+    VoxelClipboard mirrored(int axis) const;
+
+    // block id at a position inside the box, 0 for empty cells and outside
+    unsigned char getBlock(const glm::ivec3& local) const;
+    void forEachVoxel(const std::function<void(const glm::ivec3& local, unsigned char block)>& action) const;
+
+    const glm::ivec3& getSize() const { return _size; }
+    // minimum corner of the copied voxels in the world they were copied from
+    const glm::ivec3& getOrigin() const { return _origin; }
+    void setOrigin(const glm::ivec3& origin) { _origin = origin; }
+
+    size_t getVoxelCount() const { return _voxelCount; }
+    bool isEmpty() const { return _voxelCount == 0; }
+    // bytes used by bricks and palette
+    size_t getMemoryUsage() const;
+
+    void saveToBuffer(std::string& out) const;
+    // throws on malformed data
+    static VoxelClipboard loadFromBuffer(const char* data, size_t size);
+
+    // throw if the file can't be written or read
+    void saveToFile(const std::string& path) const;
+    static VoxelClipboard loadFromFile(const std::string& path);
+
+private:
+    struct Brick {
+        // bits per packed palette index, 0 for bricks holding a single value
+        uint8_t bits;
+        // palette index of single value bricks
+        uint8_t value;
+        // of the packed indices in _data
+        uint32_t offset;
+    };
+
+    // block ids of the bricks that have copied voxels, by brick index
+    typedef std::unordered_map<size_t, std::array<unsigned char, CLIPBOARD_BRICK_VOLUME>> SparseBricks;
+
+    static void setSparseBrickCell(SparseBricks& bricks, const glm::ivec3& size, const glm::ivec3& local, unsigned char block);
+    void encodeSparse(const glm::ivec3& size, const SparseBricks& bricks);
+
+    // Builds the bricks of a box of the given size. fill writes the block ids
+    // of the brick at brickOrigin in z, y, x order into a zeroed array, cells
+    // outside the box have to stay 0.
+    void encode(const glm::ivec3& size, const std::function<void(const glm::ivec3& brickOrigin, unsigned char* blocks)>& fill);
+    // block ids of a brick in z, y, x order
+    void decodeBrick(const Brick& brick, unsigned char* blocks) const;
+    void write(World& world, const glm::ivec3& position, bool erase) const;
+    // a clipboard of the given size whose voxel p is getBlock(source(p))
+    template<typename Source>
+    VoxelClipboard transformed(const glm::ivec3& size, const Source& source) const;
+
+    const Brick& getBrick(int x, int y, int z) const {
+        return _bricks[(static_cast<size_t>(z) * _brickCounts.y + y) * _brickCounts.x + x];
+    }
+
+    glm::ivec3 _size = glm::ivec3(0);
+    glm::ivec3 _origin = glm::ivec3(0);
+    glm::ivec3 _brickCounts = glm::ivec3(0);
+
+    // block id per palette index, index 0 is empty
+    std::vector<unsigned char> _palette = { 0 };
+    std::vector<Brick> _bricks;
+    std::vector<uint8_t> _data;
+
+    size_t _voxelCount = 0;
+};
@@ -0,0 +1,348 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+
+// Voxels on the segment between the centers of two voxels, 3D Bresenham in
+// integers. Visits max(|dx|, |dy|, |dz|) + 1 voxels from start to end, each
+// once, consecutive voxels share at least a corner. Along the driving axis
+// every step moves one voxel, the other axes round to the nearest voxel.
+class VoxelLineIterator {
+public:
+    VoxelLineIterator(const glm::ivec3& start, const glm::ivec3& end) : _voxel(start) {
+        glm::ivec3 delta = end - start;
+
+        for(int axis = 0; axis < 3; ++axis) {
+            _step[axis] = delta[axis] > 0 ? 1 : (delta[axis] < 0 ? -1 : 0);
+            _delta[axis] = std::abs(delta[axis]);
+        }
+
+        _driving = 0;
+        if(_delta[1] > _delta[_driving]) _driving = 1;
+        if(_delta[2] > _delta[_driving]) _driving = 2;
+
+        _remaining = _delta[_driving] + 1;
+
+        for(int axis = 0; axis < 3; ++axis) {
+            _error[axis] = 2 * _delta[axis] - _delta[_driving];
+        }
+    }
+
+    // voxels left to visit
+    int getRemaining() const { return _remaining; }
+
+    // writes the next voxel, false once past end
+    bool next(glm::ivec3& outVoxel) {
+        if(_remaining == 0) {
+            return false;
+        }
+
+        outVoxel = _voxel;
+        if(--_remaining == 0) {
+            return true;
+        }
+
+        for(int axis = 0; axis < 3; ++axis) {
+            if(axis == _driving) {
+                continue;
+            }
+
+            if(_error[axis] > 0) {
+                _voxel[axis] += _step[axis];
+                _error[axis] -= 2 * _delta[_driving];
+            }
+
+            _error[axis] += 2 * _delta[axis];
+        }
+
+        _voxel[_driving] += _step[_driving];
+
+        return true;
+    }
+
+private:
+    glm::ivec3 _voxel;
+    int _step[3];
+    int _delta[3];
+    int _error[3];
+    int _driving;
+    int _remaining;
+};
+
+template<typename Action>
+inline void forEachVoxelInLine(const glm::ivec3& start, const glm::ivec3& end, Action&& action) {
+    VoxelLineIterator line(start, end);
+
+    glm::ivec3 voxel;
+    while(line.next(voxel)) {
+        action(voxel.x, voxel.y, voxel.z);
+    }
+}
+
+// Every voxel the segment between the two voxel centers passes through,
+// |dx| + |dy| + |dz| + 1 voxels that share a face with the previous one.
+// Where the segment crosses an edge or corner exactly, the voxels around it
+// are entered in x, y, z order. Crossings are compared as fractions, there
+// is no rounding.
+template<typename Action>
+inline void forEachVoxelInSupercoverLine(const glm::ivec3& start, const glm::ivec3& end, Action&& action) {
+    glm::ivec3 voxel = start;
+    int64_t delta[3];
+    int step[3];
+    // boundaries crossed so far per axis
+    int64_t crossed[3] = { 0, 0, 0 };
+
+    for(int axis = 0; axis < 3; ++axis) {
+        int d = end[axis] - start[axis];
+        step[axis] = d > 0 ? 1 : (d < 0 ? -1 : 0);
+        delta[axis] = std::abs(d);
+    }
+
+    action(voxel.x, voxel.y, voxel.z);
+
+    int64_t steps = delta[0] + delta[1] + delta[2];
+    for(int64_t i = 0; i < steps; ++i) {
+        // the next crossing of axis a is at t = (2 * crossed + 1) / (2 * delta)
+        int next = -1;
+        for(int axis = 0; axis < 3; ++axis) {
+            if(crossed[axis] == delta[axis]) {
+                continue;
+            }
+
+            if(next < 0 || (2 * crossed[axis] + 1) * delta[next] < (2 * crossed[next] + 1) * delta[axis]) {
+                next = axis;
+            }
+        }
+
+        crossed[next]++;
+        voxel[next] += step[next];
+
+        action(voxel.x, voxel.y, voxel.z);
+    }
+}
+
+namespace voxel_line_detail {
+    // b must be positive
+    inline int64_t floorDivide(int64_t a, int64_t b) {
+        return a >= 0 ? a / b : -((-a + b - 1) / b);
+    }
+
+    inline int64_t ceilDivide(int64_t a, int64_t b) {
+        return -floorDivide(-a, b);
+    }
+
+    // squared distance test of a voxel center against the segment, exact
+    inline bool isInCapsule(const glm::ivec3& voxel, const glm::ivec3& start, const glm::ivec3& end, int radius) {
+        int64_t px = voxel.x - start.x, py = voxel.y - start.y, pz = voxel.z - start.z;
+        int64_t dx = end.x - start.x, dy = end.y - start.y, dz = end.z - start.z;
+
+        int64_t lengthSquared = dx * dx + dy * dy + dz * dz;
+        int64_t dot = px * dx + py * dy + pz * dz;
+        int64_t radiusSquared = static_cast<int64_t>(radius) * radius;
+
+        if(dot <= 0) {
+            return px * px + py * py + pz * pz <= radiusSquared;
+        }
+
+        if(dot >= lengthSquared) {
+            int64_t qx = px - dx, qy = py - dy, qz = pz - dz;
+            return qx * qx + qy * qy + qz * qz <= radiusSquared;
+        }
+
+        return (px * px + py * py + pz * pz) * lengthSquared - dot * dot <= radiusSquared * lengthSquared;
+    }
+
+    // x interval of a ball on the row, false if the row misses it
+    inline bool getBallRange(double centerX, double remaining, double& outMin, double& outMax) {
+        if(remaining < 0.0) {
+            return false;
+        }
+
+        double halfWidth = std::sqrt(remaining);
+        outMin = centerX - halfWidth;
+        outMax = centerX + halfWidth;
+
+        return true;
+    }
+}
+
+// Voxels whose center is at most radius from the segment between the two
+// voxel centers, a sphere swept from start to end. Calls action(minX, maxX,
+// y, z) once per row of voxels, inclusive, the capsule is convex so every
+// row is one span. Spans are estimated in floating point and then fixed up
+// with an exact integer test, so they match the test above.
+template<typename SpanAction>
+inline void forEachSpanInCapsule(const glm::ivec3& start, const glm::ivec3& end, int radius, SpanAction&& action) {
+    using namespace voxel_line_detail;
+
+    glm::ivec3 min = glm::min(start, end) - radius;
+    glm::ivec3 max = glm::max(start, end) + radius;
+
+    double dx = end.x - start.x, dy = end.y - start.y, dz = end.z - start.z;
+    double lengthSquared = dx * dx + dy * dy + dz * dz;
+    double radiusSquared = static_cast<double>(radius) * radius;
+
+    for(int z = min.z; z <= max.z; ++z) {
+        for(int y = min.y; y <= max.y; ++y) {
+            double ay = y - start.y, az = z - start.z;
+            double by = y - end.y, bz = z - end.z;
+
+            bool found = false;
+            double low = 0.0, high = 0.0;
+
+            auto include = [&](double rangeMin, double rangeMax) {
+                if(rangeMin > rangeMax) {
+                    return;
+                }
+
+                low = found ? std::min(low, rangeMin) : rangeMin;
+                high = found ? std::max(high, rangeMax) : rangeMax;
+                found = true;
+            };
+
+            double rangeMin, rangeMax;
+            if(getBallRange(start.x, radiusSquared - ay * ay - az * az, rangeMin, rangeMax)) {
+                include(rangeMin, rangeMax);
+            }
+            if(getBallRange(end.x, radiusSquared - by * by - bz * bz, rangeMin, rangeMax)) {
+                include(rangeMin, rangeMax);
+            }
+
+            if(lengthSquared > 0.0) {
+                // with u = x - start.x: perpendicular distance u^2 a - 2 u b + c <= 0
+                // and projection 0 <= u dx + q <= lengthSquared
+                double q = ay * dy + az * dz;
+                double a = lengthSquared - dx * dx;
+                double b = dx * q;
+                double c = (ay * ay + az * az - radiusSquared) * lengthSquared - q * q;
+
+                double cylinderMin = -1e30, cylinderMax = 1e30;
+                bool hit = true;
+
+                if(a > 0.0) {
+                    // a row touching the cylinder at one voxel may come out
+                    // slightly negative, the exact test below decides
+                    double discriminant = b * b - a * c;
+                    if(discriminant < 0.0 && discriminant > -1e-9 * (b * b + std::abs(a * c))) {
+                        discriminant = 0.0;
+                    }
+
+                    if(discriminant < 0.0) {
+                        hit = false;
+                    } else {
+                        double root = std::sqrt(discriminant);
+                        cylinderMin = (b - root) / a;
+                        cylinderMax = (b + root) / a;
+                    }
+                } else if(c > 0.0) {
+                    hit = false;
+                }
+
+                if(dx != 0.0) {
+                    double slabMin = -q / dx;
+                    double slabMax = (lengthSquared - q) / dx;
+                    if(slabMin > slabMax) std::swap(slabMin, slabMax);
+
+                    cylinderMin = std::max(cylinderMin, slabMin);
+                    cylinderMax = std::min(cylinderMax, slabMax);
+                } else if(q < 0.0 || q > lengthSquared) {
+                    hit = false;
+                }
+
+                if(hit) {
+                    include(start.x + cylinderMin, start.x + cylinderMax);
+                }
+            }
+
+            // one voxel of slack either way, then exact
+            if(!found) {
+                continue;
+            }
+
+            int spanMin = std::max(min.x, static_cast<int>(std::floor(low)) - 1);
+            int spanMax = std::min(max.x, static_cast<int>(std::ceil(high)) + 1);
+
+            while(spanMin <= spanMax && !isInCapsule(glm::ivec3(spanMin, y, z), start, end, radius)) spanMin++;
+            while(spanMax >= spanMin && !isInCapsule(glm::ivec3(spanMax, y, z), start, end, radius)) spanMax--;
+
+            if(spanMin <= spanMax) {
+                action(spanMin, spanMax, y, z);
+            }
+        }
+    }
+}
+
+// Voxels within radius of the segment between the two voxel centers along
+// every axis, a cube swept from start to end. Same callback as
+// forEachSpanInCapsule. Exact: per row the range of the segment parameter
+// is intersected as fractions and the span rounded inwards from it.
+template<typename SpanAction>
+inline void forEachSpanInThickLine(const glm::ivec3& start, const glm::ivec3& end, int radius, SpanAction&& action) {
+    using namespace voxel_line_detail;
+
+    glm::ivec3 min = glm::min(start, end) - radius;
+    glm::ivec3 max = glm::max(start, end) + radius;
+    glm::ivec3 delta = end - start;
+
+    for(int z = min.z; z <= max.z; ++z) {
+        for(int y = min.y; y <= max.y; ++y) {
+            // segment parameter t as fractions with positive denominators, starts as 0 to 1
+            int64_t lowNumerator = 0, lowDenominator = 1;
+            int64_t highNumerator = 1, highDenominator = 1;
+            bool empty = false;
+
+            auto constrain = [&](int64_t offset, int64_t axisDelta) {
+                if(axisDelta == 0) {
+                    empty |= std::abs(offset) > radius;
+                    return;
+                }
+
+                // axisDelta * t within offset -/+ radius
+                int64_t lowBound = offset - radius;
+                int64_t highBound = offset + radius;
+                if(axisDelta < 0) {
+                    lowBound = -(offset + radius);
+                    highBound = -(offset - radius);
+                    axisDelta = -axisDelta;
+                }
+
+                if(lowBound * lowDenominator > lowNumerator * axisDelta) {
+                    lowNumerator = lowBound;
+                    lowDenominator = axisDelta;
+                }
+                if(highBound * highDenominator < highNumerator * axisDelta) {
+                    highNumerator = highBound;
+                    highDenominator = axisDelta;
+                }
+            };
+
+            constrain(y - start.y, delta.y);
+            constrain(z - start.z, delta.z);
+
+            if(empty || lowNumerator * highDenominator > highNumerator * lowDenominator) {
+                continue;
+            }
+
+            // x of the segment at both ends of the parameter range, as fractions
+            int64_t lowX = static_cast<int64_t>(start.x) * lowDenominator + lowNumerator * delta.x;
+            int64_t highX = static_cast<int64_t>(start.x) * highDenominator + highNumerator * delta.x;
+
+            int64_t spanMin = std::min(
+                ceilDivide(lowX - static_cast<int64_t>(radius) * lowDenominator, lowDenominator),
+                ceilDivide(highX - static_cast<int64_t>(radius) * highDenominator, highDenominator)
+            );
+            int64_t spanMax = std::max(
+                floorDivide(lowX + static_cast<int64_t>(radius) * lowDenominator, lowDenominator),
+                floorDivide(highX + static_cast<int64_t>(radius) * highDenominator, highDenominator)
+            );
+
+            if(spanMin <= spanMax) {
+                action(static_cast<int>(spanMin), static_cast<int>(spanMax), y, z);
+            }
+        }
+    }
+}
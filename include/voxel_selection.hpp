@@ -0,0 +1,117 @@
+#pragma once
+
+#include "chunk.hpp"
+
+#include <unordered_map>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// one bit per voxel of a chunk, bit z * 256 + y * 16 + x
+#define SELECTION_CHUNK_WORDS (CHUNK_VOLUME / 64)
+
+typedef std::array<uint64_t, SELECTION_CHUNK_WORDS> SelectionBits;
+
+// index of the lowest set bit, word must not be 0
+inline int countTrailingZeros(uint64_t word) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(word);
+#endif
+}
+
+// index of the highest set bit counted from bit 63, word must not be 0
+inline int countLeadingZeros(uint64_t word) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, word);
+    return 63 - static_cast<int>(index);
+#else
+    return __builtin_clzll(word);
+#endif
+}
+
+inline int countSetBits(uint64_t word) {
+#ifdef _MSC_VER
+    return static_cast<int>(__popcnt64(word));
+#else
+    return __builtin_popcountll(word);
+#endif
+}
+
+// Set of voxels at non-negative coordinates, e.g. the result of a flood
+// fill. Stored as a 512 byte bitmap per chunk that has selected voxels, so
+// membership is a lookup and a bit test and a chunk row of 16 voxels is 16
+// bits of one word. Set operations, grow and shrink work on whole words,
+// 64 voxels at a time, and count with popcount afterwards.
+class VoxelSelection {
+public:
+    bool contains(int x, int y, int z) const;
+    bool contains(const glm::ivec3& voxel) const { return contains(voxel.x, voxel.y, voxel.z); }
+
+    // returns false if the voxel was selected already or is at negative coordinates
+    bool add(int x, int y, int z);
+    bool add(const glm::ivec3& voxel) { return add(voxel.x, voxel.y, voxel.z); }
+    // Rows are the 16 voxels at y, z in the chunk with chunk x coordinate
+    // chunkX, bit i is the voxel at x = chunkX * CHUNK_SIZE + i.
+    uint16_t getRow(int chunkX, int y, int z) const;
+    // selects the voxels of the row set in mask, returns how many were new
+    size_t addRow(int chunkX, int y, int z, uint16_t mask);
+    // selects x from minX to maxX inclusive at y, z, returns how many were new
+    size_t addSpan(int minX, int maxX, int y, int z);
+    // selects the voxels set in bits of the chunk at chunk coordinates, returns how many were new
+    size_t addChunkBits(const glm::ivec3& chunk, const SelectionBits& bits);
+    void clear();
+
+    void unite(const VoxelSelection& other);
+    void intersect(const VoxelSelection& other);
+    void subtract(const VoxelSelection& other);
+    // selects the voxels from min to max inclusive that were not selected,
+    // everything outside of them ends up unselected
+    void invert(const glm::ivec3& min, const glm::ivec3& max);
+    // adds the voxels that share a face with a selected voxel
+    void grow();
+    // removes the selected voxels that share a face with an unselected one
+    void shrink();
+
+    size_t getCount() const { return _count; }
+    bool isEmpty() const { return _count == 0; }
+    // bounds of the selected voxels, inclusive, only valid when not empty
+    const glm::ivec3& getMin() const { return _min; }
+    const glm::ivec3& getMax() const { return _max; }
+
+    size_t getChunkCount() const { return _chunks.size(); }
+    // bytes used by the chunk bitmaps
+    size_t getMemoryUsage() const;
+
+    // bitmap of the chunk at chunk coordinates, null if nothing in it is selected
+    const SelectionBits* getChunkBits(int x, int y, int z) const;
+    void forEachChunk(const std::function<void(const glm::ivec3& chunk, const SelectionBits& bits)>& action) const;
+    // chunk by chunk, in bit order within a chunk
+    void forEachVoxel(const std::function<void(const glm::ivec3& voxel)>& action) const;
+    std::vector<glm::ivec3> toVector() const;
+
+private:
+    struct SelectionChunk {
+        glm::ivec3 coords;
+        SelectionBits bits;
+    };
+
+    SelectionBits& getOrCreateChunkBits(int x, int y, int z);
+    void extendBounds(const glm::ivec3& min, const glm::ivec3& max);
+    // grow or shrink by one voxel across faces
+    void morph(bool grow);
+    // count and bounds from the bitmaps after voxels were removed, drops empty chunks
+    void recount();
+
+    std::unordered_map<uint64_t, SelectionChunk> _chunks;
+
+    size_t _count = 0;
+    glm::ivec3 _min = glm::ivec3(0);
+    glm::ivec3 _max = glm::ivec3(0);
+};
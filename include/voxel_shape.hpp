@@ -0,0 +1,106 @@
+#pragma once
+
+#include "voxel_selection.hpp"
+#include "engine/core/thread_pool.hpp"
+
+#include <functional>
+#include <vector>
+
+// edge length of the bricks boundary chunks are culled in, divides CHUNK_SIZE
+#define SHAPE_BRICK_SIZE 8
+
+enum class ShapePrimitive {
+    PRIMITIVE_SPHERE,
+    PRIMITIVE_BOX,
+    PRIMITIVE_CYLINDER,
+    PRIMITIVE_CONE,
+    PRIMITIVE_CAPSULE,
+    PRIMITIVE_TORUS
+};
+
+enum class ShapeOperation {
+    OPERATION_UNION,
+    OPERATION_SUBTRACT,
+    OPERATION_INTERSECT
+};
+
+// A solid built from primitives with boolean operations, as a signed
+// distance function: negative inside, positive outside. A voxel is inside
+// when the distance at its integer coordinates is at most 0.
+//
+// All primitives are exact distances and the operations, also the smooth
+// ones, never grow faster than distance, so the distance at the center of a
+// box of voxels tells whether the whole box is outside or inside. Selecting
+// a shape culls whole groups of chunks that way, then 8^3 bricks of the
+// chunks on the surface, and only evaluates voxels in bricks the surface
+// passes through. The work grows with the surface of the shape, chunks deep
+// inside cost a filled bitmap.
+//
+// Cylinders, cones and tori stand upright along y.
+class VoxelShape {
+public:
+    static VoxelShape sphere(const glm::vec3& center, float radius);
+    static VoxelShape box(const glm::vec3& center, const glm::vec3& halfSize);
+    static VoxelShape cylinder(const glm::vec3& center, float radius, float halfHeight);
+    // apex height above the center of the base
+    static VoxelShape cone(const glm::vec3& baseCenter, float radius, float height);
+    static VoxelShape capsule(const glm::vec3& start, const glm::vec3& end, float radius);
+    // the ring lies in the xz plane
+    static VoxelShape torus(const glm::vec3& center, float majorRadius, float minorRadius);
+
+    // smoothness blends the surfaces within that distance of each other, 0 is a sharp edge
+    VoxelShape unite(const VoxelShape& other, float smoothness = 0.0f) const;
+    VoxelShape subtract(const VoxelShape& other, float smoothness = 0.0f) const;
+    VoxelShape intersect(const VoxelShape& other, float smoothness = 0.0f) const;
+
+    float getDistance(const glm::vec3& point) const;
+    bool contains(const glm::ivec3& voxel) const { return getDistance(glm::vec3(voxel)) <= 0.0f; }
+
+    // bounds of the voxels inside, inclusive, false if nothing can be inside
+    bool getBounds(glm::ivec3& outMin, glm::ivec3& outMax) const;
+
+    // the voxels inside at non-negative coordinates, chunks on the surface
+    // are evaluated on pool when one is given
+    VoxelSelection select(core::ThreadPool* pool = nullptr) const;
+    // every run of voxels inside, x from minX to maxX inclusive at y, z, also at negative coordinates
+    void forEachSpan(const std::function<void(int minX, int maxX, int y, int z)>& action) const;
+
+private:
+    enum class NodeType {
+        NODE_PRIMITIVE,
+        NODE_OPERATION
+    };
+
+    struct Node {
+        NodeType type;
+        ShapePrimitive primitive;
+        ShapeOperation operation;
+
+        // primitive position and sizes, meaning depends on the primitive
+        glm::vec3 a = glm::vec3(0.0f);
+        glm::vec3 b = glm::vec3(0.0f);
+        float radius = 0.0f;
+        float size = 0.0f;
+
+        // operands of an operation
+        size_t left = 0;
+        size_t right = 0;
+        float smoothness = 0.0f;
+
+        // conservative bounds of the inside, min > max when empty
+        glm::vec3 boundsMin = glm::vec3(0.0f);
+        glm::vec3 boundsMax = glm::vec3(0.0f);
+    };
+
+    static VoxelShape primitive(const Node& node);
+    VoxelShape combine(const VoxelShape& other, ShapeOperation operation, float smoothness) const;
+
+    float evaluate(size_t node, float x, float y, float z) const;
+    // bits of the voxels inside the chunk at chunk coordinates
+    void evaluateChunk(const glm::ivec3& chunk, SelectionBits& outBits) const;
+    // splits a box of chunks until each part is outside, inside or a single chunk
+    void cullChunks(const glm::ivec3& min, const glm::ivec3& max, std::vector<glm::ivec3>& outInside, std::vector<glm::ivec3>& outSurface) const;
+
+    // children before their parents, the root last
+    std::vector<Node> _nodes;
+};
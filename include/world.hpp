@@ -2,7 +2,16 @@
 
 #include "chunk.hpp"
 #include "world_asset.hpp"
+#include "world_region.hpp"
+#include "voxel_selection.hpp"
+#include "voxel_line.hpp"
 #include "ray.hpp"
+#include "engine/core/thread_pool.hpp"
+
+#include <unordered_set>
+
+// smallest batch World::raycastBatch splits across a thread pool
+#define RAYCAST_PARALLEL_MIN_RAYS 4096
 
 struct WorldRayHit {
     glm::ivec3 block;
@@ -11,13 +20,54 @@ struct WorldRayHit {
     float distance;
 };
 
+// Copy of a world's contents that is cheap to take and safe to read from
+// another thread. Block arrays are shared with the chunks, which copy them on
+// their next write instead.
+struct WorldSnapshot {
+    struct ChunkEntry {
+        int x, y, z;
+        uint64_t revision;
+        std::shared_ptr<const ChunkBlocks> blocks;
+    };
+
+    std::string name;
+    std::vector<ChunkEntry> chunks;
+
+    // region chunks that were never loaded, by table index
+    std::shared_ptr<const WorldRegion> region;
+    std::vector<size_t> regionChunks;
+
+    // only filled by World::takeChanges, and by World::takeSnapshot with
+    // chunks that are gone when it is taken
+    std::vector<glm::ivec3> removedChunks;
+};
+
+// voxels that count as neighbours, sharing a face, at least an edge or at least a corner
+enum class Connectivity {
+    CONNECTIVITY_6,
+    CONNECTIVITY_18,
+    CONNECTIVITY_26
+};
+
+struct WorldStorageStats {
+    size_t chunkCount = 0;
+    // distinct block arrays held by the loaded chunks
+    size_t blockArrayCount = 0;
+    size_t blockBytes = 0;
+    // not allocated because chunks share the array of an identical chunk
+    size_t savedBytes = 0;
+};
+
 class World {
 public:
     World() = default;
     ~World() = default;
 
     Chunk* createChunk(int x, int y, int z);
+    // decodes the chunk from the region on first access
     Chunk* getChunk(int x, int y, int z) const;
+    // only chunks already in memory, never touches the region
+    Chunk* getLoadedChunk(int x, int y, int z) const;
 
     Chunk* getChunkContainingBlock(int x, int y, int z) const;
     const auto& getChunks() const { return _chunks; }
@@ -27,8 +77,37 @@ public:
     unsigned char getBlock(int x, int y, int z) const;
     void setBlock(int x, int y, int z, unsigned char blockId);
     void setBlocks(const std::vector<glm::ivec3>& positions, unsigned char blockId);
+    // Lets edit write the blocks of the chunk at chunk coordinates x, y, z
+    // in place, creating the chunk if needed. For bulk writes that would
+    // otherwise call setBlock per voxel. Returns null for negative coordinates.
+    Chunk* editChunk(int x, int y, int z, const std::function<void(unsigned char* blocks)>& edit);
+
+    // Called before a chunk is created, removed or has its blocks changed by
+    // the methods above, with the chunk as it is until then or null if there
+    // is none. Used to record edits, see EditHistory.
+    void setChunkEditCallback(std::function<void(const glm::ivec3& coords, const Chunk* chunk)> callback);
+
+    // Moves the selected solid voxels by offset, the cells they leave become
+    // air. Works chunk by chunk with one editChunk per source or destination
+    // chunk, reading from the chunks as they were before the move. Rows are
+    // copied whole when offset.x is a multiple of CHUNK_SIZE, otherwise each
+    // destination row is put together from two shifted source rows. Voxels
+    // that would end up at negative coordinates are dropped.
+    void moveSelection(const VoxelSelection& selection, const glm::ivec3& offset);
+    // Sets the selected voxels to blockId with one editChunk per chunk that
+    // changes, only solid voxels with solidOnly. Fully selected chunks are
+    // filled whole. Returns how many voxels changed.
+    size_t fillSelection(const VoxelSelection& selection, unsigned char blockId, bool solidOnly = false);
 
     std::optional<WorldRayHit> findRayHitBlock(const Ray& ray, float maxDistance) const;
+    // Casts count rays at once, outHits[i] is the first solid block rays[i]
+    // hits, the same as findRayHitBlock gives. Only reads chunks in memory,
+    // chunks of the region that aren't loaded yet count as air. With a pool,
+    // batches of at least RAYCAST_PARALLEL_MIN_RAYS are split across it, the
+    // world must not change meanwhile.
+    void raycastBatch(const Ray* rays, std::optional<WorldRayHit>* outHits, size_t count, float maxDistance) const;
+    void raycastBatch(const Ray* rays, std::optional<WorldRayHit>* outHits, size_t count, float maxDistance, core::ThreadPool& pool) const;
+    void raycastBatch(const std::vector<Ray>& rays, std::vector<std::optional<WorldRayHit>>& outHits, float maxDistance, core::ThreadPool& pool) const;
     std::optional<WorldRayHit> findRayHitXPlane(const Ray& ray, float maxDistance, int x_plane) const;
     std::optional<WorldRayHit> findRayHitYPlane(const Ray& ray, float maxDistance, int y_plane) const;
     std::optional<WorldRayHit> findRayHitXZPlane(const Ray& ray, float maxDistance, glm::ivec2 xz_plane) const;
@@ -36,14 +115,100 @@ public:
     std::vector<glm::ivec3> getVoxelsInLine(const glm::ivec3& start, const glm::ivec3& end) const;
     std::vector<glm::ivec3> getVoxelsInSphere(const glm::ivec3& center, int radius) const;
     std::vector<glm::ivec3> getVoxelsInCube(const glm::ivec3& min, const glm::ivec3& max) const;
+    // same as selectConnected with 18-connectivity, as a list
     std::vector<glm::ivec3> getConnectedVoxels(const glm::ivec3& start) const;
+    // Solid voxels connected to start, empty if start is air. Flood fills
+    // whole x runs at a time, 16 voxels of a chunk row per step, and uses
+    // the selection's chunk bitmaps to mark visited voxels.
+    VoxelSelection selectConnected(const glm::ivec3& start, Connectivity connectivity = Connectivity::CONNECTIVITY_18) const;
+    // integer Bresenham between the two voxels, see VoxelLineIterator, hot
+    // loops call forEachVoxelInLine directly to skip the std::function
     void forVoxelsInLine(const glm::ivec3& start, const glm::ivec3& end, const std::function<void(int x, int y, int z)>& action) const;
 
+    // chunks of the region are loaded lazily through getChunk, chunks created
+    // or removed afterwards take precedence over the region
+    void setRegion(std::unique_ptr<WorldRegion> region);
+    const WorldRegion* getRegion() const { return _region.get(); }
+    // for reading the region from other threads
+    std::shared_ptr<const WorldRegion> shareRegion() const { return _region; }
+
+    // in the region and neither loaded, replaced nor removed yet
+    bool isRegionChunkAvailable(int x, int y, int z) const;
+    // adds a chunk decoded from the region elsewhere, returns null if it
+    // stopped being available in the meantime
+    Chunk* installRegionChunk(int x, int y, int z, const unsigned char* blocks) const;
+    // Drops a chunk that is unchanged since it was loaded from the region,
+    // it can be loaded from the region again later. Returns false for
+    // anything else, those stay in memory until a save by WorldSaver maps
+    // the file it wrote, see adoptSavedRegion.
+    bool unloadChunk(int x, int y, int z);
+    // Loads every region chunk that is still available at once. Chunks are
+    // decoded straight into their storage on the pool, then added to the
+    // world in one batch. Returns the number of chunks loaded.
+    size_t loadAllRegionChunks(core::ThreadPool& pool);
+    // Bulk writes whole chunks, e.g. for generated terrain. fill writes the
+    // zeroed blocks of each chunk straight into its storage on the pool, from
+    // several threads at once, and returns false to leave the chunk as air.
+    // The chunks then replace those in the world in one batch, chunks left
+    // as air are removed, each through the edit callback. Returns the number
+    // of chunks with blocks.
+    size_t fillChunks(const std::vector<glm::ivec3>& coords, const std::function<bool(const glm::ivec3& coords, unsigned char* blocks)>& fill, core::ThreadPool& pool);
+
+    // While enabled, chunks loaded from the region share the block array of
+    // an identical chunk, found by the hash of their blocks. Enabling it
+    // deduplicates the chunks loaded so far.
+    void setChunkDeduplication(bool enabled);
+    bool isChunkDeduplicationEnabled() const { return _deduplicateChunks; }
+    // Lets all loaded chunks with identical blocks share one array, e.g.
+    // after bulk edits. Returns the number of chunks that gave up their own.
+    size_t deduplicateChunks();
+    WorldStorageStats getStorageStats() const;
+
+    WorldSnapshot takeSnapshot() const;
+    // Modified and removed chunks since the last takeChanges or clearChanges,
+    // marks them saved. The region is left out.
+    WorldSnapshot takeChanges();
+    void clearChanges();
+    // Marks the chunks of a snapshot saved once it was written, those
+    // edited since keep their changes. Removals it covers are forgotten.
+    void markSnapshotSaved(const WorldSnapshot& snapshot);
+    // Switches to the region of a file just written from snapshot. Chunks
+    // unchanged since the snapshot count as loaded from it and can be
+    // unloaded, everything in memory or removed still hides the region.
+    void adoptSavedRegion(std::unique_ptr<WorldRegion> region, const WorldSnapshot& snapshot);
+
     static std::unique_ptr<World> loadFromAsset(const WorldAsset& asset);
+    // maps world files with a chunk table and loads chunks on demand,
+    // legacy files are loaded whole
+    static std::unique_ptr<World> loadFromFile(const std::string& filepath);
+    // same as loadFromFile, but with a full path instead of one relative to the executable
+    static std::unique_ptr<World> loadFromPath(const std::string& path);
     static WorldAsset saveToAsset(const World& world);
 
 private:
-    std::unordered_map<uint64_t, std::unique_ptr<Chunk>> _chunks;
+    Chunk* loadRegionChunk(int x, int y, int z) const;
+    void markNeighborsDirty(int x, int y, int z) const;
+    // returns true if the chunk now shares the array of an identical chunk
+    bool deduplicateChunk(Chunk* chunk) const;
+
+    mutable std::unordered_map<uint64_t, std::unique_ptr<Chunk>> _chunks;
+
+    // shared with snapshots that are still being saved
+    std::shared_ptr<WorldRegion> _region;
+    // region chunks that were loaded, replaced or removed, never read again
+    mutable std::unordered_set<uint64_t> _consumedRegionChunks;
+    // revision of region chunks right after loading, to tell whether they were edited since
+    mutable std::unordered_map<uint64_t, uint64_t> _regionChunkRevisions;
+
+    std::function<void(const glm::ivec3& coords, const Chunk* chunk)> _chunkEditCallback;
+
+    bool _deduplicateChunks = false;
+    // one array per blocks hash, for chunks loaded while deduplication is
+    // enabled. Entries may have been edited since, adoptBlocks compares.
+    mutable std::unordered_map<uint64_t, std::weak_ptr<const ChunkBlocks>> _blockArrays;
+
+    // removed since the last takeChanges or clearChanges
+    std::unordered_map<uint64_t, glm::ivec3> _removedChunks;
 };
 
 uint64_t getChunkKey(int x, int y, int z);
\ No newline at end of file
@@ -1,9 +1,17 @@
 #pragma once
 
 #include "chunk.hpp"
+#include "chunk_codec.hpp"
+#include "engine/core/binary.hpp"
 #include <map>
 #include <string>
 
+// "VXLW" read as a little-endian u32
+#define WORLD_FILE_MAGIC 0x574C5856
+#define WORLD_FILE_VERSION 1
+// i32 x, y, z, u64 offset, u32 size, u8 encoding, u8[3] reserved
+#define WORLD_FILE_CHUNK_ENTRY_SIZE 28
+
 struct ChunkData {
     int x;
     int y;
@@ -12,11 +20,66 @@ struct ChunkData {
     std::array<unsigned char, CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE> data;
 };
 
+struct WorldFileHeader {
+    uint16_t version;
+    // matches the journal written after this file, 0 for files without one
+    uint16_t saveId;
+    std::string name;
+    uint32_t chunkCount;
+
+    // position of the first chunk table entry
+    size_t tableOffset;
+};
+
+struct WorldFileChunkEntry {
+    int x;
+    int y;
+    int z;
+
+    uint64_t payloadOffset;
+    uint32_t payloadSize;
+    ChunkEncoding encoding;
+};
+
+// World files are little-endian:
+//
+//   u32 magic, u16 version, u16 save id
+//   u32 name length, name bytes
+//   u32 chunk count
+//   chunk table, sorted by chunk key, per chunk:
+//       i32 x, i32 y, i32 z, u64 payload offset, u32 payload size, u8 encoding, u8[3] reserved
+//   chunk payloads (see ChunkEncoding)
+//
+// Identical chunks may share one payload, their entries have the same offset.
+// The save id changes with every full save by WorldSaver and ties the file
+// to its journal, see world_journal.hpp. It was the unused flags field,
+// older files have 0.
+//
+// The table allows reading single chunks without touching the rest of the
+// file, see WorldRegion. Files written before the format existed (no magic,
+// raw ChunkData dumps) are still read.
 class WorldAsset {
 public:
     std::string name;
     std::unordered_map<uint64_t, ChunkData> chunks;
 
     void saveToFile(const std::string& filepath) const;
+    std::string saveToBuffer() const;
+
     static WorldAsset loadFromFile(const std::string& filepath);
-};
\ No newline at end of file
+    static WorldAsset loadFromBuffer(const std::string& buffer);
+
+private:
+    static WorldAsset loadLegacy(core::BinaryReader& reader);
+};
+
+// Returns false when the data doesn't start with the world file magic,
+// throws when it does but the header or chunk table is unusable.
+bool readWorldFileHeader(core::BinaryReader& reader, WorldFileHeader& outHeader);
+WorldFileChunkEntry readWorldFileChunkEntry(core::BinaryReader& reader);
+
+// The table follows the header directly, so payload offsets start at
+// getWorldFileTableOffset(name) + chunkCount * WORLD_FILE_CHUNK_ENTRY_SIZE.
+size_t getWorldFileTableOffset(const std::string& name);
+void writeWorldFileHeader(core::BinaryWriter& writer, const std::string& name, uint32_t chunkCount, uint16_t saveId = 0);
+void writeWorldFileChunkEntry(core::BinaryWriter& writer, const WorldFileChunkEntry& entry);
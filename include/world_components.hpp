@@ -0,0 +1,68 @@
+#pragma once
+
+#include "world.hpp"
+#include "engine/core/thread_pool.hpp"
+
+#include <atomic>
+
+struct WorldComponent {
+    size_t voxelCount = 0;
+    // inclusive
+    glm::ivec3 min = glm::ivec3(0);
+    glm::ivec3 max = glm::ivec3(0);
+
+    // not resting on the bottom of the world, e.g. a floating island
+    bool isFloating() const { return min.y > 0; }
+};
+
+// Connected components of the solid voxels of a world, e.g. to find
+// floating islands.
+//
+// Labelling runs in three passes on a thread pool. Each chunk is labelled on
+// its own first, the labels of all chunks are then numbered globally and
+// merged across chunk borders with a lock-free union-find, and finally the
+// per chunk statistics are summed per component. Only chunks in memory take
+// part, see World::loadAllRegionChunks for labelling a whole region.
+class WorldComponents {
+public:
+    static WorldComponents label(const World& world, core::ThreadPool& pool, Connectivity connectivity = Connectivity::CONNECTIVITY_6);
+
+    // largest first
+    const std::vector<WorldComponent>& getComponents() const { return _components; }
+    size_t getComponentCount() const { return _components.size(); }
+
+    // index into getComponents, -1 for air and voxels outside the labelled chunks
+    long findComponent(const glm::ivec3& voxel) const;
+    VoxelSelection selectComponent(size_t index) const;
+
+private:
+    struct LabelledChunk {
+        glm::ivec3 coords;
+        // per voxel, 0 for air, otherwise 1 + index of the chunk's local component
+        std::vector<uint16_t> labels;
+        // first global label of the chunk's local components
+        uint32_t firstLabel = 0;
+        std::vector<WorldComponent> localComponents;
+    };
+
+    std::vector<LabelledChunk> _chunks;
+    std::unordered_map<uint64_t, size_t> _chunkIndices;
+    // component index per global label
+    std::vector<uint32_t> _labelComponents;
+
+    std::vector<WorldComponent> _components;
+};
+
+// Union-find over a fixed number of elements that any number of threads can
+// unite and find in at the same time. Roots are linked to the smaller root,
+// finds halve paths with compare and swap.
+class ConcurrentUnionFind {
+public:
+    explicit ConcurrentUnionFind(size_t count);
+
+    uint32_t find(uint32_t element);
+    void unite(uint32_t a, uint32_t b);
+
+private:
+    std::unique_ptr<std::atomic<uint32_t>[]> _parents;
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "world.hpp"
+#include "engine/core/thread_pool.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// voxels between samples of the cave noise, divides CHUNK_SIZE
+#define GENERATOR_CAVE_SPACING 4
+
+struct WorldGeneratorSettings {
+    uint32_t seed = 1;
+
+    // height of the top solid voxel of a column, fractal noise around baseHeight
+    int baseHeight = 48;
+    float heightAmplitude = 36.0f;
+    float heightFrequency = 1.0f / 160.0f;
+    int heightOctaves = 5;
+    int dirtDepth = 3;
+
+    // tunnels where two noise fields are both close to zero
+    bool caves = true;
+    float caveFrequency = 1.0f / 40.0f;
+    float caveWidth = 0.11f;
+    // voxels below the surface caves stay under, so they rarely open up
+    int caveCrust = 5;
+
+    // trees scattered on the surface, chance per column
+    float treeDensity = 0.003f;
+    int treeHeight = 5;
+    int treeCrownRadius = 2;
+
+    unsigned char stoneBlock = 1;
+    unsigned char dirtBlock = 3;
+    unsigned char grassBlock = 4;
+    unsigned char trunkBlock = 3;
+    unsigned char leavesBlock = 4;
+};
+
+// a chunk as passes see it while it is generated
+struct GeneratorChunk {
+    glm::ivec3 coords;
+    // top solid voxel of each column before caves, z * CHUNK_SIZE + x
+    const int* heights;
+    // z * CHUNK_SIZE * CHUNK_SIZE + y * CHUNK_SIZE + x
+    unsigned char* blocks;
+};
+
+// Fills chunks with terrain from a seed. Every voxel is a function of the
+// seed and its position only, so a chunk comes out the same whichever order
+// or thread it is generated on, and features crossing chunk borders, like
+// trees, line up.
+//
+// The built-in passes run first: a fractal noise heightmap with stone, dirt
+// and grass, tunnels carved from 3D noise and trees scattered on the surface.
+// Noise for caves is sampled on a lattice every GENERATOR_CAVE_SPACING voxels
+// and interpolated per row of a chunk, a loop the compiler vectorizes.
+// Chunks entirely above the terrain are skipped unless passes were added.
+class WorldGenerator {
+public:
+    // runs after the built-in passes, from several threads at once
+    typedef std::function<void(const GeneratorChunk& chunk)> Pass;
+
+    explicit WorldGenerator(const WorldGeneratorSettings& settings = WorldGeneratorSettings());
+
+    const WorldGeneratorSettings& getSettings() const { return _settings; }
+    void addPass(Pass pass);
+
+    // top solid voxel of the column before caves
+    int getHeight(int x, int z) const;
+
+    // writes the chunk into zeroed blocks, returns false if it stays air
+    bool generateChunk(const glm::ivec3& coords, unsigned char* blocks) const;
+    // Replaces the chunks from minChunk to maxChunk, inclusive, with
+    // generated ones, on the pool and straight into their storage through
+    // World::fillChunks. Returns the number of chunks with blocks.
+    size_t generate(World& world, const glm::ivec3& minChunk, const glm::ivec3& maxChunk, core::ThreadPool& pool) const;
+
+private:
+    void computeHeights(int chunkX, int chunkZ, int* outHeights) const;
+    bool generateChunk(const glm::ivec3& coords, const int* heights, unsigned char* blocks) const;
+
+    void fillTerrain(const GeneratorChunk& chunk) const;
+    void carveCaves(const GeneratorChunk& chunk) const;
+    void scatterTrees(const GeneratorChunk& chunk) const;
+
+    WorldGeneratorSettings _settings;
+    std::vector<Pass> _passes;
+};
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "chunk.hpp"
+#include "chunk_codec.hpp"
+#include "engine/core/binary.hpp"
+
+#include <optional>
+
+// "VXLJ" read as a little-endian u32
+#define WORLD_JOURNAL_MAGIC 0x4A4C5856
+#define WORLD_JOURNAL_VERSION 1
+
+class World;
+
+// Values are part of the journal format, never renumber them.
+enum class WorldJournalRecordType : uint8_t {
+    CHUNK = 0,  // full chunk contents
+    REMOVED = 1 // chunk was removed, no payload
+};
+
+// Journals are appended to between full saves of a world file and emptied
+// by the next one. They are little-endian:
+//
+//   u32 magic, u16 version, u16 save id
+//   records, per record:
+//       u8 type, u8 encoding, u16 reserved, i32 x, i32 y, i32 z
+//       u32 payload size, payload (see ChunkEncoding)
+//       u32 FNV-1a checksum of everything above
+//
+// Records hold whole chunks, so replaying a record twice gives the same
+// world. The save id is that of the world file the journal continues. A
+// crash after a full save replaced the file but before the journal was
+// emptied leaves a journal with the previous id, whose records may be older
+// than the file, so it is not replayed. Everything in it is in the file,
+// appends never run while a full save does.
+std::string getWorldJournalPath(const std::string& worldPath);
+
+void writeWorldJournalHeader(core::BinaryWriter& writer, uint16_t saveId);
+// save id in the header, empty if there is no journal or no complete header
+std::optional<uint16_t> readWorldJournalSaveId(const std::string& path);
+void writeWorldJournalRecord(
+    core::BinaryWriter& writer, WorldJournalRecordType type, const glm::ivec3& chunk,
+    ChunkEncoding encoding, const std::string& payload
+);
+
+// Applies the records of the journal to the world in order and returns how
+// many were applied. A missing journal applies nothing, a torn or corrupt
+// record ends the replay, everything before it is kept. A journal whose save
+// id differs from the world's region, 0 without one, is stale and deleted.
+size_t replayWorldJournal(World& world, const std::string& path);
@@ -1,34 +1,46 @@
 #pragma once
 
 #include "engine/engine.hpp"
+#include "engine/core/thread_pool.hpp"
 #include "world.hpp"
 #include "chunk_mesh.hpp"
+#include "frustum.hpp"
+
+#include <mutex>
+
+// A LOD level is used once a voxel covers fewer pixels on screen than its
+// threshold, level 1 draws 2x2x2 cells and level 2 draws 4x4x4 cells.
+struct LodSettings {
+    bool enabled = true;
+
+    float lod1PixelSize = 3.0f;
+    float lod2PixelSize = 1.5f;
+};
+
+// GPU bytes held by chunk meshes, per LOD level
+struct MeshMemoryStats {
+    std::array<size_t, CHUNK_LOD_COUNT> currentBytes {};
+    std::array<size_t, CHUNK_LOD_COUNT> peakBytes {};
+
+    size_t totalBytes = 0;
+    size_t peakTotalBytes = 0;
+
+    // levels released to stay under the budget since startup
+    size_t evictions = 0;
+};
 
 class WorldMesh {
 public:
-    WorldMesh(World* world) : _world(world) {}
+    WorldMesh(World* world);
     ~WorldMesh() = default;
 
-    void update() {
-        for (auto it = _chunkMeshes.begin(); it != _chunkMeshes.end(); ) {
-            if (_world->getChunks().find(it->first) == _world->getChunks().end()) {
-                it = _chunkMeshes.erase(it);
-            } else {
-                ++it;
-            }
-        }
-
-        for (auto& [key, chunk] : _world->getChunks()) {
-            if (chunk->isDirty()) {
-                if (_chunkMeshes.find(key) == _chunkMeshes.end()) {
-                    _chunkMeshes[key] = std::make_unique<ChunkMesh>(chunk.get());
-                }
-
-                _chunkMeshes[key]->updateMesh();
-                chunk->setDirty(false);
-            }
-        }
-    }
+    // meshes dirty chunks, every chunk is drawn at full resolution
+    void update();
+    // additionally culls chunks outside the view, picks a LOD per chunk from
+    // its projected voxel size and builds coarser levels in the background
+    // (chunks draw full resolution until their level is ready), then evicts
+    // the least recently visible meshes once over the GPU budget
+    void update(const Camera& camera, float viewportHeight);
 
     World* getWorld() const { return _world; }
 
@@ -40,7 +52,50 @@ public:
         _chunkMeshes.clear();
     }
 
+    void setLodSettings(const LodSettings& settings) { _lodSettings = settings; }
+    const LodSettings& getLodSettings() const { return _lodSettings; }
+
+    // 0 disables the budget, meshes drawn this frame are never evicted
+    void setGpuBudget(size_t bytes) { _gpuBudget = bytes; }
+    size_t getGpuBudget() const { return _gpuBudget; }
+
+    const MeshMemoryStats& getMemoryStats() const { return _memoryStats; }
+
 private:
+    struct LodBuildResult {
+        uint64_t key;
+        int lod;
+        uint64_t revision;
+        ChunkMeshData data;
+    };
+
+    // shared with in-flight jobs so they can finish after the WorldMesh is gone
+    struct LodBuildQueue {
+        std::mutex mutex;
+        std::vector<LodBuildResult> results;
+    };
+
+    void syncChunks();
+
+    float getVoxelPixelSize(const Camera& camera, float viewportHeight, const Chunk& chunk) const;
+    int selectLod(float voxelPixelSize, int currentLod) const;
+
+    void requestLod(uint64_t key, ChunkMesh& mesh, int lod);
+    void collectLodBuilds();
+    void updateSkirts();
+    void enforceGpuBudget();
+    void updateMemoryStats();
+
     World* _world;
     std::unordered_map<uint64_t, std::unique_ptr<ChunkMesh>> _chunkMeshes;
-};
\ No newline at end of file
+
+    LodSettings _lodSettings;
+
+    size_t _gpuBudget = 0;
+    MeshMemoryStats _memoryStats;
+    uint64_t _frame = 0;
+
+    core::ThreadPool& _threadPool;
+    shared<LodBuildQueue> _lodBuilds;
+    int _pendingLodBuilds = 0;
+};
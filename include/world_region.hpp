@@ -0,0 +1,37 @@
+#pragma once
+
+#include "chunk.hpp"
+#include "world_asset.hpp"
+#include "engine/core/mapped_file.hpp"
+
+// Random access to the chunks of a world file. The file is mapped and only
+// the header is parsed up front, a chunk is located by binary search over
+// the sorted chunk table and decoded when it is read.
+class WorldRegion {
+public:
+    // returns null for legacy files, which have no chunk table
+    static unique<WorldRegion> open(const std::string& path);
+
+    const std::string& getName() const { return _header.name; }
+    size_t getChunkCount() const { return _header.chunkCount; }
+    uint16_t getSaveId() const { return _header.saveId; }
+
+    glm::ivec3 getChunkCoords(size_t index) const;
+    bool contains(int x, int y, int z) const;
+
+    // returns false if the chunk isn't in the file
+    bool readChunk(int x, int y, int z, unsigned char* outBlocks) const;
+    void readChunkAt(size_t index, unsigned char* outBlocks) const;
+    // encoded payload as stored in the file, valid as long as the region is
+    const char* getChunkPayloadAt(size_t index, WorldFileChunkEntry& outEntry) const;
+
+private:
+    WorldRegion(unique<core::MappedFile> file, const WorldFileHeader& header);
+
+    WorldFileChunkEntry getEntry(size_t index) const;
+    // index into the chunk table or -1
+    long findEntry(int x, int y, int z) const;
+
+    unique<core::MappedFile> _file;
+    WorldFileHeader _header;
+};
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "world.hpp"
+#include "world_journal.hpp"
+#include "engine/core/thread_pool.hpp"
+
+#include <atomic>
+
+struct WorldSaveStats {
+    size_t chunkCount = 0;
+    // written to the file, chunks with identical payloads share one
+    size_t payloadCount = 0;
+    size_t payloadBytes = 0;
+    // not written because the chunk shares the payload of an identical one
+    size_t savedBytes = 0;
+};
+
+// Saves worlds in the world file format on a background thread. save() only
+// takes a WorldSnapshot, encoding and writing happen on the worker, so the
+// world can be edited while the file is written. Encoded payloads are kept
+// per chunk revision and only chunks edited since the last save are encoded
+// again, region chunks that were never loaded are copied as stored.
+//
+// Chunks with identical payloads, e.g. repeated parts of a build, store the
+// payload once and share its offset in the chunk table.
+//
+// The file is written next to the target and renamed over it once complete,
+// a failed or interrupted save leaves the previous file untouched. Every
+// full save writes the next save id into the file and the emptied journal,
+// so a journal left over by a crash in between is not replayed.
+//
+// Between full saves, appendJournal() writes the chunks edited since the
+// previous call to the world's journal (see world_journal.hpp), which the
+// next full save empties again.
+class WorldSaver {
+public:
+    WorldSaver();
+    ~WorldSaver();
+
+    WorldSaver(const WorldSaver&) = delete;
+    WorldSaver& operator=(const WorldSaver&) = delete;
+
+    // Returns false without saving while a previous save is still running.
+    // The world's changes are marked saved by the next call to save or
+    // appendJournal after the file was written, a failed save keeps them.
+    // That call also maps the new file as the world's region, so chunks
+    // unchanged since can be unloaded and streamed in again.
+    bool save(World& world, const std::string& path);
+    // returns false when nothing changed since the last save or append, or
+    // while a full save is running, which empties the journal once done
+    bool appendJournal(World& world, const std::string& path);
+
+    bool isSaving() const { return _saving; }
+    // size of the journal after the last append or save
+    size_t getJournalSize() const { return _journalSize; }
+    // of the last completed full save
+    WorldSaveStats getLastSaveStats() const;
+
+    // waits for every queued save and append
+    void wait();
+
+private:
+    struct EncodedChunk {
+        uint64_t revision;
+        ChunkEncoding encoding;
+        std::string payload;
+    };
+
+    void submit(std::function<void()> job);
+    // marks what the last completed save wrote as saved in the world and
+    // moves the world over to the written file, see World::adoptSavedRegion
+    void applyCompletedSave(World& world);
+    // save id of the file on disk, taken from the world's region on first use
+    uint16_t getFileSaveId(const World& world);
+
+    // reuses the cached payload when the chunk is unchanged since it was encoded
+    const EncodedChunk& encodeChunk(const WorldSnapshot::ChunkEntry& chunk);
+    void writeSnapshot(const WorldSnapshot& snapshot, const std::string& path, uint16_t saveId);
+    void writeJournal(const WorldSnapshot& changes, const std::string& path);
+    void resetJournal(const std::string& path, uint16_t saveId);
+
+    // only touched by the job that is currently running
+    std::unordered_map<uint64_t, EncodedChunk> _encodedChunks;
+
+    std::atomic<bool> _saving { false };
+    std::atomic<size_t> _journalSize { 0 };
+    // new journals get the id of the file they continue
+    std::atomic<uint16_t> _fileSaveId { 0 };
+    bool _fileSaveIdKnown = false;
+
+    WorldSaveStats _lastSaveStats;
+
+    // written by the worker, the world is only touched on the caller's thread
+    std::shared_ptr<const WorldSnapshot> _completedSave;
+    const World* _completedSaveWorld = nullptr;
+    std::string _completedSavePath;
+
+    size_t _pendingJobs = 0;
+    mutable std::mutex _mutex;
+    std::condition_variable _condition;
+
+    core::ThreadPool _pool;
+};
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "engine/engine.hpp"
+#include "engine/core/thread_pool.hpp"
+#include "world.hpp"
+
+#include <mutex>
+#include <unordered_set>
+
+// Radii are in blocks, measured from the camera to chunk centers. Chunks
+// between the two radii stay as they are, so moving back and forth across
+// the load radius doesn't reload the same chunks.
+struct StreamingSettings {
+    float loadRadius = 256.0f;
+    float unloadRadius = 320.0f;
+};
+
+// Keeps the region chunks around the camera resident. Chunks inside the
+// load radius are decoded from the region on background threads, closest
+// first with chunks in the view direction ahead of those behind. Chunks
+// beyond the unload radius are dropped again if they are unchanged since
+// loading, edited chunks stay in memory until the world is saved by
+// WorldSaver, which maps the new file as the region.
+class WorldStreamer {
+public:
+    WorldStreamer(World* world);
+    ~WorldStreamer() = default;
+
+    void update(const Camera& camera);
+
+    void setSettings(const StreamingSettings& settings);
+    const StreamingSettings& getSettings() const { return _settings; }
+
+    size_t getPendingLoadCount() const { return _pendingLoads.size(); }
+
+private:
+    struct LoadResult {
+        // the region the chunk was decoded from, results from a replaced region are dropped
+        const WorldRegion* region;
+        glm::ivec3 coords;
+        ChunkBlocks blocks;
+        bool failed;
+    };
+
+    // shared with in-flight jobs so they can finish after the streamer is gone
+    struct LoadQueue {
+        std::mutex mutex;
+        std::vector<LoadResult> results;
+    };
+
+    struct LoadRequest {
+        size_t regionIndex;
+        glm::ivec3 coords;
+        float priority;
+    };
+
+    void syncRegion();
+    void collectLoads();
+    void scan(const glm::vec3& position, const glm::vec3& forward);
+    void submitLoads();
+
+    World* _world;
+    StreamingSettings _settings;
+
+    // kept alive so a new region can't reuse the address of the old one
+    std::shared_ptr<const WorldRegion> _region;
+    // region chunk coordinates by table index, refreshed when the world's region changes
+    std::vector<glm::ivec3> _regionChunks;
+
+    // loads waiting to be submitted, lowest priority value last
+    std::vector<LoadRequest> _requests;
+    std::unordered_set<uint64_t> _pendingLoads;
+    // chunks that failed to decode, not requested again for this region
+    std::unordered_set<uint64_t> _failedLoads;
+
+    // camera state of the last scan, a new scan only runs once it changed enough
+    bool _needsScan = true;
+    glm::ivec3 _scanChunk = glm::ivec3(0);
+    glm::vec3 _scanForward = glm::vec3(0.0f);
+
+    core::ThreadPool _ioPool;
+    shared<LoadQueue> _loads;
+};
@@ -0,0 +1,948 @@
+#include "benchmarks.hpp"
+#include "world.hpp"
+#include "chunk_mesh.hpp"
+#include "world_generator.hpp"
+#include "voxel_shape.hpp"
+#include "vox_format.hpp"
+#include "engine/core/binary.hpp"
+#include "engine/core/thread_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+// 110592 chunks, a 1024 x 432 x 1024 block terrain
+const glm::ivec3 LOAD_BENCHMARK_CHUNKS = glm::ivec3(64, 27, 64);
+
+// random segments per line benchmark pass, up to 256 voxels long
+const int LINE_BENCHMARK_SEGMENTS = 200000;
+const int LINE_BENCHMARK_LENGTH = 256;
+const int LINE_BENCHMARK_RADIUS = 4;
+
+// a 512 x 512 x 512 block terrain seen through a 512 x 512 ray grid
+const glm::ivec3 RAYCAST_BENCHMARK_CHUNKS = glm::ivec3(32, 32, 32);
+const int RAYCAST_BENCHMARK_RESOLUTION = 512;
+
+// a 512 x 128 x 512 block generated world, the standard benchmark scene
+const glm::ivec3 GENERATE_BENCHMARK_CHUNKS = glm::ivec3(32, 8, 32);
+const uint32_t GENERATE_BENCHMARK_SEED = 1;
+
+// radii of the CSG benchmark shape, the first one is also checked per voxel
+const std::vector<int> CSG_BENCHMARK_RADII = { 100, 200, 400 };
+
+// random voxels in a 3 x 3 x 3 chunk box from the origin, so every kind of
+// chunk edge and the world's own edge are crossed, checked step by step
+const int SELECTION_CHECK_SIZE = 3 * CHUNK_SIZE;
+const std::vector<float> SELECTION_CHECK_DENSITIES = { 0.3f, 0.8f };
+const int SELECTION_CHECK_STEPS = 3;
+const uint32_t SELECTION_CHECK_SEED = 5;
+// 256 x 256 x 128 selected voxels for timing, 8.4M
+const glm::ivec3 SELECTION_BENCHMARK_CHUNKS = glm::ivec3(16, 16, 8);
+
+// random voxels in each .vox test world, the large one spans several 256^3 models
+const int VOX_TEST_VOXELS = 20000;
+const glm::ivec3 VOX_TEST_SMALL_EXTENT = glm::ivec3(40, 40, 40);
+const glm::ivec3 VOX_TEST_LARGE_EXTENT = glm::ivec3(600, 300, 280);
+const uint32_t VOX_TEST_SEED = 7;
+
+// the palette of Game, block id n has color n - 1
+const std::vector<glm::vec4> VOX_TEST_COLORS = {
+    glm::vec4(0.0f, 0.0f, 0.0f, 1.0f),
+    glm::vec4(1.0f, 1.0f, 1.0f, 1.0f),
+    glm::vec4(1.0f, 0.0f, 0.0f, 1.0f),
+    glm::vec4(0.0f, 1.0f, 0.0f, 1.0f),
+    glm::vec4(0.0f, 0.0f, 1.0f, 1.0f)
+};
+
+static double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void fillBenchmarkTerrain(const glm::ivec3& chunkCoords, unsigned char* blocks) {
+    for(int z = 0; z < CHUNK_SIZE; ++z) {
+        for(int x = 0; x < CHUNK_SIZE; ++x) {
+            float worldX = static_cast<float>(chunkCoords.x * CHUNK_SIZE + x);
+            float worldZ = static_cast<float>(chunkCoords.z * CHUNK_SIZE + z);
+
+            int height = static_cast<int>(
+                200.0f +
+                120.0f * std::sin(worldX * 0.013f) * std::cos(worldZ * 0.011f) +
+                40.0f * std::sin((worldX + worldZ) * 0.05f)
+            );
+
+            for(int y = 0; y < CHUNK_SIZE; ++y) {
+                int worldY = chunkCoords.y * CHUNK_SIZE + y;
+
+                unsigned char block = 0;
+                if(worldY < height - 6) {
+                    block = static_cast<unsigned char>(1 + (worldY / 32) % 3);
+                } else if(worldY < height) {
+                    block = 4;
+                } else if(worldY == height) {
+                    block = 5;
+                }
+
+                blocks[z * CHUNK_SIZE * CHUNK_SIZE + y * CHUNK_SIZE + x] = block;
+            }
+        }
+    }
+}
+
+static void writeBenchmarkWorld(const std::string& path, core::ThreadPool& pool) {
+    std::vector<glm::ivec3> coords;
+    for(int x = 0; x < LOAD_BENCHMARK_CHUNKS.x; ++x) {
+        for(int y = 0; y < LOAD_BENCHMARK_CHUNKS.y; ++y) {
+            for(int z = 0; z < LOAD_BENCHMARK_CHUNKS.z; ++z) {
+                coords.push_back(glm::ivec3(x, y, z));
+            }
+        }
+    }
+
+    std::sort(coords.begin(), coords.end(), [](const glm::ivec3& a, const glm::ivec3& b) {
+        return getChunkKey(a.x, a.y, a.z) < getChunkKey(b.x, b.y, b.z);
+    });
+
+    std::vector<std::string> payloads(coords.size());
+    std::vector<ChunkEncoding> encodings(coords.size());
+
+    pool.parallelFor(coords.size(), [&](size_t begin, size_t end) {
+        ChunkBlocks blocks;
+        for(size_t i = begin; i < end; ++i) {
+            fillBenchmarkTerrain(coords[i], blocks.data());
+            encodings[i] = encodeChunkBlocks(blocks.data(), payloads[i]);
+        }
+    });
+
+    std::string header;
+    core::BinaryWriter writer(header);
+
+    std::string name = "load benchmark";
+    writeWorldFileHeader(writer, name, static_cast<uint32_t>(coords.size()));
+
+    uint64_t offset = getWorldFileTableOffset(name) + coords.size() * WORLD_FILE_CHUNK_ENTRY_SIZE;
+    for(size_t i = 0; i < coords.size(); ++i) {
+        writeWorldFileChunkEntry(writer, { coords[i].x, coords[i].y, coords[i].z, offset, static_cast<uint32_t>(payloads[i].size()), encodings[i] });
+        offset += payloads[i].size();
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::out | std::ios::trunc);
+    if(!file) {
+        throw std::runtime_error("Failed to open file for writing: " + path);
+    }
+
+    file.write(header.data(), header.size());
+    for(const auto& payload : payloads) {
+        file.write(payload.data(), payload.size());
+    }
+
+    if(!file) {
+        throw std::runtime_error("Failed to write to file: " + path);
+    }
+}
+
+int runLoadBenchmark() {
+    auto& pool = core::ThreadPool::getDefault();
+    std::string path = (std::filesystem::temp_directory_path() / "voxelly-bench-load.dat").string();
+
+    try {
+        auto start = std::chrono::steady_clock::now();
+        writeBenchmarkWorld(path, pool);
+
+        std::cout << "Load benchmark: " << LOAD_BENCHMARK_CHUNKS.x * LOAD_BENCHMARK_CHUNKS.y * LOAD_BENCHMARK_CHUNKS.z << " chunks, "
+                  << std::filesystem::file_size(path) / 1024 << " KB file, " << pool.getWorkerCount() + 1 << " threads" << std::endl;
+        std::cout << "  generate and write   " << millisecondsSince(start) << " ms" << std::endl;
+
+        double serialLoad = 0.0;
+        double parallelLoad = 0.0;
+
+        {
+            start = std::chrono::steady_clock::now();
+            auto world = World::loadFromPath(path);
+
+            const WorldRegion* region = world->getRegion();
+            for(size_t i = 0; i < region->getChunkCount(); ++i) {
+                auto coords = region->getChunkCoords(i);
+                world->getChunk(coords.x, coords.y, coords.z);
+            }
+
+            serialLoad = millisecondsSince(start);
+        }
+
+        start = std::chrono::steady_clock::now();
+        auto world = World::loadFromPath(path);
+        size_t loaded = world->loadAllRegionChunks(pool);
+        parallelLoad = millisecondsSince(start);
+
+        std::cout << "  load, one thread     " << serialLoad << " ms" << std::endl;
+        std::cout << "  load, parallel       " << parallelLoad << " ms (" << loaded << " chunks, " << serialLoad / parallelLoad << "x)" << std::endl;
+
+        std::vector<const Chunk*> chunks;
+        chunks.reserve(world->getChunks().size());
+        for(const auto& [key, chunk] : world->getChunks()) {
+            chunks.push_back(chunk.get());
+        }
+
+        start = std::chrono::steady_clock::now();
+        size_t serialVertices = 0;
+
+        ChunkMeshData data;
+        for(const Chunk* chunk : chunks) {
+            buildChunkMeshData(getChunkBlocksView(*chunk), 0, data);
+            serialVertices += data.vertices.size() / 7;
+        }
+
+        double serialMesh = millisecondsSince(start);
+
+        start = std::chrono::steady_clock::now();
+        std::atomic<size_t> parallelVertices { 0 };
+
+        pool.parallelFor(chunks.size(), [&](size_t begin, size_t end) {
+            ChunkMeshData rangeData;
+            size_t vertices = 0;
+
+            for(size_t i = begin; i < end; ++i) {
+                buildChunkMeshData(getChunkBlocksView(*chunks[i]), 0, rangeData);
+                vertices += rangeData.vertices.size() / 7;
+            }
+
+            parallelVertices += vertices;
+        });
+
+        double parallelMesh = millisecondsSince(start);
+
+        std::cout << "  mesh, one thread     " << serialMesh << " ms (" << serialVertices << " vertices)" << std::endl;
+        std::cout << "  mesh, parallel       " << parallelMesh << " ms (" << parallelVertices << " vertices, " << serialMesh / parallelMesh << "x)" << std::endl;
+    } catch(const std::exception& e) {
+        std::cerr << "Load benchmark failed: " << e.what() << std::endl;
+
+        std::error_code ignored;
+        std::filesystem::remove(path, ignored);
+
+        return 1;
+    }
+
+    std::error_code ignored;
+    std::filesystem::remove(path, ignored);
+
+    return 0;
+}
+
+// World::forVoxelsInLine before the integer rewrite, unit float steps along
+// the normalized direction, kept here as the baseline
+static void forVoxelsInLineFloatSteps(const glm::ivec3& start, const glm::ivec3& end, const std::function<void(int x, int y, int z)>& action) {
+    glm::vec3 origin = glm::vec3(start) + glm::vec3(0.5f);
+    glm::vec3 endPos = glm::vec3(end) + glm::vec3(0.5f);
+    glm::vec3 direction = endPos - origin;
+
+    float length = glm::length(direction);
+    if (length == 0.0f) {
+        action(origin.x, origin.y, origin.z);
+        return;
+    }
+
+    direction = glm::normalize(direction);
+    glm::ivec3 voxel(
+        static_cast<int>(std::floor(origin.x)),
+        static_cast<int>(std::floor(origin.y)),
+        static_cast<int>(std::floor(origin.z))
+    );
+
+    float distance = length;
+    while(true) {
+        action(voxel.x, voxel.y, voxel.z);
+        if (distance <= 0.0f) {
+            break;
+        }
+
+        float step = distance < 1.0f ? distance : 1.0f;
+        origin += direction * step;
+        voxel = glm::ivec3(
+            static_cast<int>(std::floor(origin.x)),
+            static_cast<int>(std::floor(origin.y)),
+            static_cast<int>(std::floor(origin.z))
+        );
+
+        distance -= step;
+    }
+}
+
+int runLineBenchmark() {
+    std::mt19937 random(1234);
+    std::uniform_int_distribution<int> coordinate(0, LINE_BENCHMARK_LENGTH);
+
+    std::vector<std::pair<glm::ivec3, glm::ivec3>> segments(LINE_BENCHMARK_SEGMENTS);
+    for(auto& [start, end] : segments) {
+        start = glm::ivec3(coordinate(random), coordinate(random), coordinate(random));
+        end = glm::ivec3(coordinate(random), coordinate(random), coordinate(random));
+    }
+
+    std::cout << "Line benchmark: " << segments.size() << " segments up to " << LINE_BENCHMARK_LENGTH << " voxels per axis" << std::endl;
+
+    // voxels visited, consecutive repeats and steps that skip a voxel
+    size_t visited = 0;
+    size_t repeats = 0;
+    size_t gaps = 0;
+    glm::ivec3 last;
+    bool first = true;
+
+    auto count = [&](int x, int y, int z) {
+        glm::ivec3 voxel(x, y, z);
+        if(!first) {
+            glm::ivec3 step = glm::abs(voxel - last);
+            repeats += step == glm::ivec3(0);
+            gaps += std::max(step.x, std::max(step.y, step.z)) > 1;
+        }
+
+        last = voxel;
+        first = false;
+        visited++;
+    };
+
+    auto run = [&](const char* name, auto&& line) {
+        visited = repeats = gaps = 0;
+
+        auto start = std::chrono::steady_clock::now();
+        for(const auto& [from, to] : segments) {
+            first = true;
+            line(from, to);
+        }
+        double milliseconds = millisecondsSince(start);
+
+        std::cout << "  " << name << milliseconds << " ms, " << visited << " voxels, "
+                  << repeats << " repeated, " << gaps << " gaps" << std::endl;
+    };
+
+    run("float steps          ", [&](const glm::ivec3& from, const glm::ivec3& to) { forVoxelsInLineFloatSteps(from, to, count); });
+    run("bresenham, function  ", [&](const glm::ivec3& from, const glm::ivec3& to) {
+        std::function<void(int, int, int)> action = count;
+        forEachVoxelInLine(from, to, action);
+    });
+    run("bresenham, inlined   ", [&](const glm::ivec3& from, const glm::ivec3& to) { forEachVoxelInLine(from, to, count); });
+    run("supercover, inlined  ", [&](const glm::ivec3& from, const glm::ivec3& to) { forEachVoxelInSupercoverLine(from, to, count); });
+
+    // a thick line as the Line tool drew it before, a sphere per line voxel,
+    // against capsule spans, on a hundredth of the segments
+    size_t thickSegments = segments.size() / 100;
+    size_t sphereVoxels = 0;
+    size_t capsuleVoxels = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    World world;
+    for(size_t i = 0; i < thickSegments; ++i) {
+        forVoxelsInLineFloatSteps(segments[i].first, segments[i].second, [&](int x, int y, int z) {
+            sphereVoxels += world.getVoxelsInSphere(glm::ivec3(x, y, z), LINE_BENCHMARK_RADIUS).size();
+        });
+    }
+    double sphereMilliseconds = millisecondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    for(size_t i = 0; i < thickSegments; ++i) {
+        forEachSpanInCapsule(segments[i].first, segments[i].second, LINE_BENCHMARK_RADIUS, [&](int minX, int maxX, int, int) {
+            capsuleVoxels += maxX - minX + 1;
+        });
+    }
+    double capsuleMilliseconds = millisecondsSince(start);
+
+    std::cout << "  radius " << LINE_BENCHMARK_RADIUS << ", sphere per voxel " << sphereMilliseconds << " ms (" << sphereVoxels << " voxels with repeats)" << std::endl;
+    std::cout << "  radius " << LINE_BENCHMARK_RADIUS << ", capsule spans    " << capsuleMilliseconds << " ms (" << capsuleVoxels << " voxels)" << std::endl;
+
+    return 0;
+}
+
+int runRaycastBenchmark() {
+    auto& pool = core::ThreadPool::getDefault();
+
+    World world;
+    for(int x = 0; x < RAYCAST_BENCHMARK_CHUNKS.x; ++x) {
+        for(int y = 0; y < RAYCAST_BENCHMARK_CHUNKS.y; ++y) {
+            for(int z = 0; z < RAYCAST_BENCHMARK_CHUNKS.z; ++z) {
+                world.editChunk(x, y, z, [&](unsigned char* blocks) {
+                    fillBenchmarkTerrain(glm::ivec3(x, y, z), blocks);
+                });
+            }
+        }
+    }
+
+    // looking down at the terrain from one corner, as a camera would
+    glm::vec3 origin(-64.0f, 480.0f, -64.0f);
+    float extent = static_cast<float>(RAYCAST_BENCHMARK_CHUNKS.x * CHUNK_SIZE);
+
+    std::vector<Ray> rays;
+    rays.reserve(RAYCAST_BENCHMARK_RESOLUTION * RAYCAST_BENCHMARK_RESOLUTION);
+    for(int v = 0; v < RAYCAST_BENCHMARK_RESOLUTION; ++v) {
+        for(int u = 0; u < RAYCAST_BENCHMARK_RESOLUTION; ++u) {
+            glm::vec3 target(
+                extent * (u + 0.5f) / RAYCAST_BENCHMARK_RESOLUTION,
+                0.0f,
+                extent * (v + 0.5f) / RAYCAST_BENCHMARK_RESOLUTION
+            );
+
+            rays.emplace_back(origin, target - origin);
+        }
+    }
+
+    float maxDistance = 1024.0f;
+
+    std::cout << "Raycast benchmark: " << rays.size() << " rays, " << world.getChunks().size() << " chunks, "
+              << pool.getWorkerCount() + 1 << " threads" << std::endl;
+
+    // the chunk lookup per voxel findRayHitBlock used to do
+    auto start = std::chrono::steady_clock::now();
+    size_t perVoxelHits = 0;
+    for(const auto& ray : rays) {
+        perVoxelHits += performDDA(ray.origin, ray.direction, maxDistance, [&](const glm::ivec3& voxel, const glm::ivec3&, float) {
+            return world.getBlock(voxel.x, voxel.y, voxel.z) != 0;
+        });
+    }
+    double perVoxel = millisecondsSince(start);
+
+    std::vector<std::optional<WorldRayHit>> hits(rays.size());
+
+    start = std::chrono::steady_clock::now();
+    world.raycastBatch(rays.data(), hits.data(), rays.size(), maxDistance);
+    double serial = millisecondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    world.raycastBatch(rays, hits, maxDistance, pool);
+    double parallel = millisecondsSince(start);
+
+    size_t batchHits = std::count_if(hits.begin(), hits.end(), [](const auto& hit) { return hit.has_value(); });
+
+    std::cout << "  chunk lookup per voxel  " << perVoxel << " ms (" << perVoxelHits << " hits)" << std::endl;
+    std::cout << "  batch, one thread       " << serial << " ms (" << perVoxel / serial << "x)" << std::endl;
+    std::cout << "  batch, parallel         " << parallel << " ms (" << batchHits << " hits, " << perVoxel / parallel << "x)" << std::endl;
+
+    return perVoxelHits == batchHits ? 0 : 1;
+}
+
+static uint64_t hashWorldChunks(const World& world) {
+    std::vector<std::pair<uint64_t, uint64_t>> hashes;
+    for(const auto& [key, chunk] : world.getChunks()) {
+        hashes.emplace_back(key, hashBytes(chunk->getBlocks().data(), CHUNK_VOLUME));
+    }
+
+    std::sort(hashes.begin(), hashes.end());
+
+    uint64_t hash = 0;
+    for(const auto& [key, blocksHash] : hashes) {
+        hash = hash * 0x100000001b3ull ^ key;
+        hash = hash * 0x100000001b3ull ^ blocksHash;
+    }
+
+    return hash;
+}
+
+int runGenerateBenchmark() {
+    auto& pool = core::ThreadPool::getDefault();
+    core::ThreadPool serialPool(0);
+
+    WorldGeneratorSettings settings;
+    settings.seed = GENERATE_BENCHMARK_SEED;
+    WorldGenerator generator(settings);
+
+    glm::ivec3 maxChunk = GENERATE_BENCHMARK_CHUNKS - glm::ivec3(1);
+
+    std::cout << "Generate benchmark: " << GENERATE_BENCHMARK_CHUNKS.x * CHUNK_SIZE << " x " << GENERATE_BENCHMARK_CHUNKS.y * CHUNK_SIZE
+              << " x " << GENERATE_BENCHMARK_CHUNKS.z * CHUNK_SIZE << " blocks, seed " << settings.seed << ", "
+              << pool.getWorkerCount() + 1 << " threads" << std::endl;
+
+    World serialWorld;
+    auto start = std::chrono::steady_clock::now();
+    size_t serialChunks = generator.generate(serialWorld, glm::ivec3(0), maxChunk, serialPool);
+    double serial = millisecondsSince(start);
+
+    World parallelWorld;
+    start = std::chrono::steady_clock::now();
+    size_t parallelChunks = generator.generate(parallelWorld, glm::ivec3(0), maxChunk, pool);
+    double parallel = millisecondsSince(start);
+
+    size_t voxels = 0;
+    for(const auto& [key, chunk] : parallelWorld.getChunks()) {
+        voxels += chunk->getBlockCount();
+    }
+
+    // the same seed has to give the same world on any number of threads
+    bool deterministic = serialChunks == parallelChunks && hashWorldChunks(serialWorld) == hashWorldChunks(parallelWorld);
+
+    std::cout << "  one thread   " << serial << " ms (" << serialChunks << " chunks)" << std::endl;
+    std::cout << "  parallel     " << parallel << " ms (" << parallelChunks << " chunks, " << voxels << " solid voxels, " << serial / parallel << "x)" << std::endl;
+    std::cout << "  " << (deterministic ? "identical on both" : "DIFFERENT between one thread and parallel") << std::endl;
+
+    return deterministic ? 0 : 1;
+}
+
+// A sphere with a smooth torus cut around its equator, a capsule through it
+// and the top and bottom cut flat, every combinator once.
+static VoxelShape createBenchmarkShape(int radius) {
+    float r = static_cast<float>(radius);
+    glm::vec3 center(r + CHUNK_SIZE);
+
+    return VoxelShape::sphere(center, r)
+        .subtract(VoxelShape::torus(center, 0.8f * r, 0.25f * r), 0.05f * r)
+        .unite(VoxelShape::capsule(center - glm::vec3(r, 0.0f, 0.0f), center + glm::vec3(r, 0.0f, 0.0f), 0.15f * r))
+        .intersect(VoxelShape::box(center, glm::vec3(1.1f * r, 0.8f * r, 1.1f * r)));
+}
+
+int runCsgBenchmark() {
+    auto& pool = core::ThreadPool::getDefault();
+    bool passed = true;
+
+    std::cout << "CSG benchmark: sphere - torus + capsule & box, " << pool.getWorkerCount() + 1 << " threads" << std::endl;
+
+    for(size_t i = 0; i < CSG_BENCHMARK_RADII.size(); ++i) {
+        int radius = CSG_BENCHMARK_RADII[i];
+        VoxelShape shape = createBenchmarkShape(radius);
+
+        auto start = std::chrono::steady_clock::now();
+        VoxelSelection serialSelection = shape.select();
+        double serial = millisecondsSince(start);
+
+        start = std::chrono::steady_clock::now();
+        VoxelSelection parallelSelection = shape.select(&pool);
+        double parallel = millisecondsSince(start);
+
+        glm::ivec3 min, max;
+        shape.getBounds(min, max);
+        glm::ivec3 extent = max - min + 1;
+
+        std::cout << "  radius " << radius << ", " << extent.x << " x " << extent.y << " x " << extent.z << " bounds, "
+                  << parallelSelection.getCount() << " voxels" << std::endl;
+        std::cout << "    select, one thread  " << serial << " ms" << std::endl;
+        std::cout << "    select, parallel    " << parallel << " ms (" << serial / parallel << "x)" << std::endl;
+
+        if(serialSelection.getCount() != parallelSelection.getCount()) {
+            std::cout << "    DIFFERENT between one thread and parallel" << std::endl;
+            passed = false;
+        }
+
+        if(i != 0) {
+            continue;
+        }
+
+        // every voxel of the bounds evaluated on its own
+        size_t mismatches = 0;
+        size_t inside = 0;
+
+        start = std::chrono::steady_clock::now();
+        for(int z = min.z; z <= max.z; ++z) {
+            for(int y = min.y; y <= max.y; ++y) {
+                for(int x = min.x; x <= max.x; ++x) {
+                    bool contained = shape.contains(glm::ivec3(x, y, z));
+                    inside += contained;
+                    mismatches += contained != parallelSelection.contains(x, y, z);
+                }
+            }
+        }
+        double perVoxel = millisecondsSince(start);
+
+        std::cout << "    per voxel           " << perVoxel << " ms (" << mismatches << " of " << inside << " voxels differ)" << std::endl;
+
+        passed &= mismatches == 0 && inside == parallelSelection.getCount();
+    }
+
+    return passed ? 0 : 1;
+}
+
+// Dense copy of a selection from the origin to extent, exclusive, grown
+// and shrunk voxel by voxel.
+struct SelectionReference {
+    int extent;
+    std::vector<unsigned char> voxels;
+
+    explicit SelectionReference(int extent) : extent(extent), voxels(static_cast<size_t>(extent) * extent * extent, 0) {}
+
+    // voxels at negative coordinates don't exist and never count as selected
+    bool at(int x, int y, int z) const {
+        if(x < 0 || y < 0 || z < 0 || x >= extent || y >= extent || z >= extent) {
+            return false;
+        }
+
+        return voxels[(static_cast<size_t>(z) * extent + y) * extent + x] != 0;
+    }
+
+    void set(int x, int y, int z, bool selected) {
+        voxels[(static_cast<size_t>(z) * extent + y) * extent + x] = selected;
+    }
+
+    void morph(bool grow) {
+        static const glm::ivec3 faces[6] = {
+            glm::ivec3(-1, 0, 0), glm::ivec3(1, 0, 0), glm::ivec3(0, -1, 0), glm::ivec3(0, 1, 0), glm::ivec3(0, 0, -1), glm::ivec3(0, 0, 1)
+        };
+
+        std::vector<unsigned char> result(voxels.size());
+
+        for(int z = 0; z < extent; ++z) {
+            for(int y = 0; y < extent; ++y) {
+                for(int x = 0; x < extent; ++x) {
+                    bool selected = at(x, y, z);
+                    for(const auto& face : faces) {
+                        bool neighbor = at(x + face.x, y + face.y, z + face.z);
+                        selected = grow ? selected || neighbor : selected && neighbor;
+                    }
+
+                    result[(static_cast<size_t>(z) * extent + y) * extent + x] = selected;
+                }
+            }
+        }
+
+        voxels = std::move(result);
+    }
+
+    // voxels selected in only one of them, including any past extent
+    size_t countDifferences(const VoxelSelection& selection) const {
+        size_t differences = 0;
+        size_t selectedInside = 0;
+
+        for(int z = 0; z < extent; ++z) {
+            for(int y = 0; y < extent; ++y) {
+                for(int x = 0; x < extent; ++x) {
+                    bool contained = selection.contains(x, y, z);
+                    selectedInside += contained;
+                    differences += at(x, y, z) != contained;
+                }
+            }
+        }
+
+        return differences + (selection.getCount() - selectedInside);
+    }
+};
+
+int runSelectionBenchmark() {
+    bool passed = true;
+
+    std::cout << "Selection benchmark: grow and shrink of " << SELECTION_CHECK_SIZE << "^3 random voxels against a per voxel reference" << std::endl;
+
+    std::mt19937 random(SELECTION_CHECK_SEED);
+
+    for(float density : SELECTION_CHECK_DENSITIES) {
+        std::bernoulli_distribution selected(density);
+
+        // room around the random voxels for growing
+        SelectionReference initial(SELECTION_CHECK_SIZE + SELECTION_CHECK_STEPS + 1);
+        VoxelSelection initialSelection;
+
+        for(int z = 0; z < SELECTION_CHECK_SIZE; ++z) {
+            for(int y = 0; y < SELECTION_CHECK_SIZE; ++y) {
+                for(int x = 0; x < SELECTION_CHECK_SIZE; ++x) {
+                    if(selected(random)) {
+                        initial.set(x, y, z, true);
+                        initialSelection.add(x, y, z);
+                    }
+                }
+            }
+        }
+
+        for(bool grow : { true, false }) {
+            SelectionReference reference = initial;
+            VoxelSelection selection = initialSelection;
+
+            for(int step = 1; step <= SELECTION_CHECK_STEPS; ++step) {
+                reference.morph(grow);
+                if(grow) {
+                    selection.grow();
+                } else {
+                    selection.shrink();
+                }
+
+                size_t differences = reference.countDifferences(selection);
+                passed &= differences == 0;
+
+                std::cout << "  density " << density << ", " << (grow ? "grow " : "shrink ") << step << ": " << selection.getCount() << " voxels, "
+                          << differences << " differences" << std::endl;
+            }
+        }
+    }
+
+    // timing on whole chunks and a sphere through them
+    SelectionBits full;
+    full.fill(~0ull);
+
+    VoxelSelection box;
+    for(int z = 0; z < SELECTION_BENCHMARK_CHUNKS.z; ++z) {
+        for(int y = 0; y < SELECTION_BENCHMARK_CHUNKS.y; ++y) {
+            for(int x = 0; x < SELECTION_BENCHMARK_CHUNKS.x; ++x) {
+                box.addChunkBits(glm::ivec3(x, y, z), full);
+            }
+        }
+    }
+
+    glm::vec3 center = glm::vec3(SELECTION_BENCHMARK_CHUNKS * CHUNK_SIZE) * 0.5f;
+    VoxelSelection sphere = VoxelShape::sphere(center, center.z * 1.5f).select();
+
+    std::cout << "  " << box.getCount() << " voxels, sphere of " << sphere.getCount() << std::endl;
+
+    auto time = [](const char* name, VoxelSelection selection, const std::function<void(VoxelSelection&)>& operation) {
+        auto start = std::chrono::steady_clock::now();
+        operation(selection);
+        double milliseconds = millisecondsSince(start);
+
+        std::cout << "    " << name << milliseconds << " ms (" << selection.getCount() << " voxels)" << std::endl;
+    };
+
+    time("grow       ", box, [](VoxelSelection& selection) { selection.grow(); });
+    time("shrink     ", box, [](VoxelSelection& selection) { selection.shrink(); });
+    time("unite      ", box, [&sphere](VoxelSelection& selection) { selection.unite(sphere); });
+    time("intersect  ", box, [&sphere](VoxelSelection& selection) { selection.intersect(sphere); });
+    time("subtract   ", box, [&sphere](VoxelSelection& selection) { selection.subtract(sphere); });
+
+    return passed ? 0 : 1;
+}
+
+// voxels that differ between two worlds, chunks missing from one of them count as air
+static size_t countWorldDifferences(const World& a, const World& b) {
+    size_t differences = 0;
+
+    auto compare = [&differences](const World& from, const World& to, bool skipShared) {
+        for(const auto& [key, chunk] : from.getChunks()) {
+            Chunk* other = to.getChunk(chunk->getX(), chunk->getY(), chunk->getZ());
+            if(other && skipShared) {
+                continue;
+            }
+
+            const unsigned char* blocks = chunk->getBlocks().data();
+            for(size_t i = 0; i < CHUNK_VOLUME; ++i) {
+                unsigned char otherBlock = other ? other->getBlocks()[i] : 0;
+                differences += blocks[i] != otherBlock;
+            }
+        }
+    };
+
+    compare(a, b, false);
+    compare(b, a, true);
+
+    return differences;
+}
+
+// fills a world with random voxels of every palette color, returns the minimum corner
+static glm::ivec3 fillVoxTestWorld(World& world, const glm::ivec3& origin, const glm::ivec3& extent, std::mt19937& random) {
+    std::uniform_int_distribution<int> blockDistribution(1, static_cast<int>(VOX_TEST_COLORS.size()));
+    glm::ivec3 min(INT_MAX);
+
+    for(int i = 0; i < VOX_TEST_VOXELS; ++i) {
+        glm::ivec3 position;
+        for(int axis = 0; axis < 3; ++axis) {
+            position[axis] = origin[axis] + std::uniform_int_distribution<int>(0, extent[axis] - 1)(random);
+        }
+
+        world.setBlock(position.x, position.y, position.z, static_cast<unsigned char>(blockDistribution(random)));
+        min = glm::min(min, position);
+    }
+
+    return min;
+}
+
+static bool checkVox(bool passed, const std::string& name, const std::string& details) {
+    std::cout << "  " << (passed ? "ok    " : "FAILED") << "  " << name << " (" << details << ")" << std::endl;
+    return passed;
+}
+
+// exports a world and imports it into an empty one at the same corner
+static bool checkVoxRoundTrip(const std::string& name, const glm::ivec3& origin, const glm::ivec3& extent, std::mt19937& random, size_t minModels) {
+    World world;
+    glm::ivec3 min = fillVoxTestWorld(world, origin, extent, random);
+
+    std::string file;
+    size_t exported = exportVox(world, VOX_TEST_COLORS, file);
+
+    World imported;
+    VoxImportResult result = importVox(imported, file.data(), file.size(), min, VOX_TEST_COLORS);
+    size_t differences = countWorldDifferences(world, imported);
+
+    bool passed = differences == 0 && result.voxelCount == exported && result.skippedVoxelCount == 0 && result.modelCount >= minModels;
+    return checkVox(passed, name,
+        std::to_string(exported) + " voxels, " + std::to_string(result.modelCount) + " models, " + std::to_string(differences) + " differences");
+}
+
+// Writes a minimal file with one 4 x 4 x 4 model, a palette of colors
+// close to but not exactly the block colors and one voxel outside the
+// model, which the importer has to skip.
+static bool checkVoxPalette() {
+    std::array<uint32_t, 256> colors = {};
+    colors[1] = 0xFF1010F0; // almost red
+    colors[2] = 0xFFE01008; // almost blue
+    colors[3] = 0xFF202020; // dark gray, closest to black
+    colors[4] = 0xFFF0F0E8; // almost white
+    colors[5] = 0xFF30D020; // almost green
+
+    const std::array<unsigned char, 6> expectedBlocks = { 0, 3, 5, 1, 2, 4 };
+
+    std::array<unsigned char, 256> map = createVoxPaletteMap(colors, VOX_TEST_COLORS);
+    size_t mapMismatches = 0;
+    for(size_t i = 0; i < expectedBlocks.size(); ++i) {
+        mapMismatches += map[i] != expectedBlocks[i];
+    }
+
+    const glm::ivec3 size(4, 4, 4);
+    std::vector<std::array<unsigned char, 4>> voxels = {
+        { 0, 0, 0, 1 }, { 3, 0, 0, 2 }, { 0, 3, 0, 3 }, { 0, 0, 3, 4 }, { 3, 3, 3, 5 }, { 1, 2, 1, 1 },
+        { 4, 0, 0, 1 }
+    };
+
+    auto writeChunk = [](core::BinaryWriter& writer, const char* id, const std::string& content) {
+        writer.writeBytes(id, 4);
+        writer.write<uint32_t>(static_cast<uint32_t>(content.size()));
+        writer.write<uint32_t>(0);
+        writer.writeBytes(content.data(), content.size());
+    };
+
+    std::string children;
+    core::BinaryWriter childWriter(children);
+
+    std::string content;
+    core::BinaryWriter writer(content);
+    writer.write<int32_t>(size.x);
+    writer.write<int32_t>(size.y);
+    writer.write<int32_t>(size.z);
+    writeChunk(childWriter, "SIZE", content);
+
+    content.clear();
+    writer.write<uint32_t>(static_cast<uint32_t>(voxels.size()));
+    for(const auto& voxel : voxels) {
+        writer.writeBytes(voxel.data(), voxel.size());
+    }
+    writeChunk(childWriter, "XYZI", content);
+
+    content.clear();
+    for(int i = 1; i <= 256; ++i) {
+        writer.write<uint32_t>(i < 256 ? colors[i] : 0);
+    }
+    writeChunk(childWriter, "RGBA", content);
+
+    std::string file;
+    core::BinaryWriter fileWriter(file);
+    fileWriter.write<uint32_t>(VOX_MAGIC);
+    fileWriter.write<uint32_t>(VOX_VERSION);
+    fileWriter.writeBytes("MAIN", 4);
+    fileWriter.write<uint32_t>(0);
+    fileWriter.write<uint32_t>(static_cast<uint32_t>(children.size()));
+    fileWriter.writeBytes(children.data(), children.size());
+
+    const glm::ivec3 origin(10, 20, 30);
+
+    World world;
+    VoxImportResult result = importVox(world, file.data(), file.size(), origin, VOX_TEST_COLORS);
+
+    // file (x, y, z) is world (x, z, -y - 1), shifted so the model starts at origin
+    World expected;
+    for(const auto& voxel : voxels) {
+        if(voxel[0] < size.x && voxel[1] < size.y && voxel[2] < size.z) {
+            expected.setBlock(origin.x + voxel[0], origin.y + voxel[2], origin.z + size.y - 1 - voxel[1], expectedBlocks[voxel[3]]);
+        }
+    }
+
+    size_t differences = countWorldDifferences(world, expected);
+
+    bool passed = mapMismatches == 0 && differences == 0 && result.voxelCount == voxels.size() - 1 && result.skippedVoxelCount == 1;
+    return checkVox(passed, "palette mapping",
+        std::to_string(mapMismatches) + " wrong colors, " + std::to_string(result.skippedVoxelCount) + " skipped, " + std::to_string(differences) + " differences");
+}
+
+// imports a world with part of it pushed below zero, those voxels are skipped
+static bool checkVoxOutOfRange(std::mt19937& random) {
+    const int shift = 20;
+
+    World world;
+    glm::ivec3 min = fillVoxTestWorld(world, glm::ivec3(0), VOX_TEST_SMALL_EXTENT, random);
+
+    std::string file;
+    size_t exported = exportVox(world, VOX_TEST_COLORS, file);
+
+    World imported;
+    VoxImportResult result = importVox(imported, file.data(), file.size(), glm::ivec3(min.x - shift, min.y, min.z), VOX_TEST_COLORS);
+
+    World expected;
+    size_t expectedSkipped = 0;
+    for(const auto& [key, chunk] : world.getChunks()) {
+        for(int z = 0; z < CHUNK_SIZE; ++z) {
+            for(int y = 0; y < CHUNK_SIZE; ++y) {
+                for(int x = 0; x < CHUNK_SIZE; ++x) {
+                    unsigned char block = chunk->getBlocks()[z * CHUNK_SIZE * CHUNK_SIZE + y * CHUNK_SIZE + x];
+                    if(block == 0) {
+                        continue;
+                    }
+
+                    int worldX = chunk->getX() * CHUNK_SIZE + x - shift;
+                    if(worldX < 0) {
+                        expectedSkipped++;
+                        continue;
+                    }
+
+                    expected.setBlock(worldX, chunk->getY() * CHUNK_SIZE + y, chunk->getZ() * CHUNK_SIZE + z, block);
+                }
+            }
+        }
+    }
+
+    size_t differences = countWorldDifferences(imported, expected);
+
+    bool passed = differences == 0 && result.skippedVoxelCount == expectedSkipped && result.voxelCount + result.skippedVoxelCount == exported;
+    return checkVox(passed, "out of range voxels",
+        std::to_string(result.skippedVoxelCount) + " of " + std::to_string(exported) + " skipped, " + std::to_string(expectedSkipped) + " expected, " +
+        std::to_string(differences) + " differences");
+}
+
+int runVoxTest() {
+    std::mt19937 random(VOX_TEST_SEED);
+    bool passed = true;
+
+    std::cout << "Vox test: " << VOX_TEST_VOXELS << " random voxels per world" << std::endl;
+
+    try {
+        passed &= checkVoxRoundTrip("round trip", glm::ivec3(17, 5, 33), VOX_TEST_SMALL_EXTENT, random, 1);
+        passed &= checkVoxRoundTrip("multiple models", glm::ivec3(10, 0, 0), VOX_TEST_LARGE_EXTENT, random, 2);
+        passed &= checkVoxPalette();
+        passed &= checkVoxOutOfRange(random);
+    } catch(const std::exception& e) {
+        std::cerr << "  " << e.what() << std::endl;
+        passed = false;
+    }
+
+    std::cout << "  " << (passed ? "all passed" : "MISMATCH") << std::endl;
+
+    return passed ? 0 : 1;
+}
+
+bool runBenchmark(const std::string& flag, int& outExitCode) {
+    if(flag == "--bench-load") {
+        outExitCode = runLoadBenchmark();
+        return true;
+    }
+
+    if(flag == "--bench-lines") {
+        outExitCode = runLineBenchmark();
+        return true;
+    }
+
+    if(flag == "--bench-raycast") {
+        outExitCode = runRaycastBenchmark();
+        return true;
+    }
+
+    if(flag == "--bench-generate") {
+        outExitCode = runGenerateBenchmark();
+        return true;
+    }
+
+    if(flag == "--bench-csg") {
+        outExitCode = runCsgBenchmark();
+        return true;
+    }
+
+    if(flag == "--bench-selection") {
+        outExitCode = runSelectionBenchmark();
+        return true;
+    }
+
+    if(flag == "--test-vox") {
+        outExitCode = runVoxTest();
+        return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,164 @@
+#include "brush_stroke.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+void BrushStroke::begin(World& world, const glm::ivec3& position, int brushSize, ToolShape shape, BrushStrokeMode mode, unsigned char blockId, const VoxelSelection* mask) {
+    _world = &world;
+    _position = position;
+    _brushSize = brushSize;
+    _shape = shape;
+    _mode = mode;
+    _blockId = mode == BrushStrokeMode::STROKE_ERASE ? 0 : blockId;
+    _mask = mask;
+
+    _pending.clear();
+    _written.clear();
+
+    sweep(_pending, position, position, _brushSize, _shape);
+}
+
+void BrushStroke::moveTo(const glm::ivec3& position) {
+    if(!_world || position == _position) {
+        return;
+    }
+
+    sweep(_pending, _position, position, _brushSize, _shape);
+
+    _position = position;
+}
+
+size_t BrushStroke::flush() {
+    if(!_world || _pending.isEmpty()) {
+        return 0;
+    }
+
+    size_t written = 0;
+
+    _pending.forEachChunk([&](const glm::ivec3& coords, const SelectionBits& pendingBits) {
+        const SelectionBits* writtenBits = _written.getChunkBits(coords.x, coords.y, coords.z);
+        const SelectionBits* maskBits = _mask ? _mask->getChunkBits(coords.x, coords.y, coords.z) : nullptr;
+        if(_mask && !maskBits) {
+            return;
+        }
+
+        SelectionBits bits;
+        bool any = false;
+        for(int word = 0; word < SELECTION_CHUNK_WORDS; ++word) {
+            bits[word] = pendingBits[word] & (writtenBits ? ~(*writtenBits)[word] : ~0ull) & (maskBits ? (*maskBits)[word] : ~0ull);
+            any |= bits[word] != 0;
+        }
+
+        if(!any) {
+            return;
+        }
+
+        // remember the voxels as written, a row at a time
+        for(int row = 0; row < CHUNK_SIZE * CHUNK_SIZE; ++row) {
+            uint16_t mask = static_cast<uint16_t>(bits[row / 4] >> ((row % 4) * CHUNK_SIZE));
+            if(mask != 0) {
+                _written.addRow(coords.x, coords.y * CHUNK_SIZE + row % CHUNK_SIZE, coords.z * CHUNK_SIZE + row / CHUNK_SIZE, mask);
+            }
+        }
+
+        // only touch chunks the stroke changes, every editChunk is a history
+        // record and a remesh of the chunk and its neighbours
+        const Chunk* chunk = _world->getChunk(coords.x, coords.y, coords.z);
+        if(!chunk && _mode != BrushStrokeMode::STROKE_PLACE) {
+            return;
+        }
+
+        auto changes = [&](unsigned char block) {
+            return block != _blockId && (_mode != BrushStrokeMode::STROKE_PAINT || block != 0);
+        };
+
+        size_t changed = 0;
+        for(int word = 0; word < SELECTION_CHUNK_WORDS; ++word) {
+            for(uint64_t selected = bits[word]; selected != 0; selected &= selected - 1) {
+                int index = word * 64 + countTrailingZeros(selected);
+
+                if(chunk ? changes(chunk->getBlocks()[index]) : _blockId != 0) {
+                    changed++;
+                } else {
+                    bits[word] &= ~(1ull << (index % 64));
+                }
+            }
+        }
+
+        if(changed == 0) {
+            return;
+        }
+
+        _world->editChunk(coords.x, coords.y, coords.z, [&](unsigned char* blocks) {
+            for(int word = 0; word < SELECTION_CHUNK_WORDS; ++word) {
+                for(uint64_t selected = bits[word]; selected != 0; selected &= selected - 1) {
+                    blocks[word * 64 + countTrailingZeros(selected)] = _blockId;
+                }
+            }
+        });
+
+        written += changed;
+    });
+
+    _pending.clear();
+
+    return written;
+}
+
+void BrushStroke::end() {
+    flush();
+
+    _world = nullptr;
+    _mask = nullptr;
+    _pending.clear();
+    _written.clear();
+}
+
+void BrushStroke::sweep(VoxelSelection& selection, const glm::ivec3& start, const glm::ivec3& end, int brushSize, ToolShape shape) {
+    auto addSpan = [&](int minX, int maxX, int y, int z) {
+        selection.addSpan(minX, maxX, y, z);
+    };
+
+    if(brushSize == 0) {
+        forEachVoxelInLine(start, end, [&](int x, int y, int z) {
+            selection.add(x, y, z);
+        });
+    } else if(shape == ToolShape::SHAPE_SPHERE) {
+        forEachSpanInCapsule(start, end, brushSize, addSpan);
+    } else if(shape == ToolShape::SHAPE_CUBE) {
+        forEachSpanInThickLine(start, end, brushSize, addSpan);
+    } else {
+        // spans of the brush around the origin once, then stamped at every voxel of the line
+        std::vector<glm::ivec4> stamp;
+        getShape(glm::vec3(0.0f), brushSize, shape).forEachSpan([&](int minX, int maxX, int y, int z) {
+            stamp.emplace_back(minX, maxX, y, z);
+        });
+
+        forEachVoxelInLine(start, end, [&](int x, int y, int z) {
+            for(const auto& span : stamp) {
+                selection.addSpan(x + span.x, x + span.y, y + span.z, z + span.w);
+            }
+        });
+    }
+}
+
+VoxelShape BrushStroke::getShape(const glm::vec3& center, int brushSize, ToolShape shape) {
+    float size = static_cast<float>(brushSize);
+
+    switch(shape) {
+        case ToolShape::SHAPE_SPHERE:
+            return VoxelShape::sphere(center, size);
+        case ToolShape::SHAPE_CUBE:
+            return VoxelShape::box(center, glm::vec3(size));
+        case ToolShape::SHAPE_CYLINDER:
+            return VoxelShape::cylinder(center, size, size);
+        case ToolShape::SHAPE_CONE:
+            return VoxelShape::cone(center - glm::vec3(0.0f, size, 0.0f), size, 2.0f * size);
+        case ToolShape::SHAPE_TORUS: {
+            float minor = std::max(1.0f, std::floor(size / 3.0f));
+            return VoxelShape::torus(center, std::max(size - minor, 0.0f), minor);
+        }
+    }
+
+    return VoxelShape::sphere(center, size);
+}
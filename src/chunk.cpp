@@ -1,7 +1,75 @@
 #include "chunk.hpp"
 
+#include <atomic>
+#include <cstring>
+
+const glm::ivec3 FACE_DIRECTIONS[6] = {
+    glm::ivec3(0, 0, 1),
+    glm::ivec3(0, 0, -1),
+    glm::ivec3(-1, 0, 0),
+    glm::ivec3(1, 0, 0),
+    glm::ivec3(0, 1, 0),
+    glm::ivec3(0, -1, 0)
+};
+
+size_t countSolidBlocks(const unsigned char* blocks, size_t count) {
+    const uint64_t lowBits = 0x7F7F7F7F7F7F7F7FULL;
+    const uint64_t highBits = 0x8080808080808080ULL;
+    const uint64_t byteOnes = 0x0101010101010101ULL;
+
+    size_t solid = 0;
+    size_t i = 0;
+
+    for(; i + 8 <= count; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, blocks + i, sizeof(word));
+
+        // high bit of every byte ends up set iff that byte is non-zero
+        uint64_t nonZero = (((word & lowBits) + lowBits) | word) & highBits;
+
+        // sum the per byte flags into the top byte
+        solid += static_cast<size_t>(((nonZero >> 7) * byteOnes) >> 56);
+    }
+
+    for(; i < count; ++i) {
+        solid += blocks[i] != 0;
+    }
+
+    return solid;
+}
+
+uint64_t hashBytes(const unsigned char* data, size_t size) {
+    const uint64_t multiplier = 0x9E3779B97F4A7C15ULL;
+
+    uint64_t hash = static_cast<uint64_t>(size) * multiplier;
+    size_t i = 0;
+
+    for(; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+
+        hash = (((hash << 5) | (hash >> 59)) ^ word) * multiplier;
+    }
+
+    for(; i < size; ++i) {
+        hash = (((hash << 5) | (hash >> 59)) ^ data[i]) * multiplier;
+    }
+
+    // the multiplications only carry upwards, mix the high bits back down
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDULL;
+    hash ^= hash >> 33;
+
+    return hash;
+}
+
+// chunks are created on loader threads as well
+static std::atomic<uint64_t> nextChunkRevision { 1 };
+
 Chunk::Chunk(int x, int y, int z, World* world) {
-    _data.fill(0);
+    _data = std::make_shared<ChunkBlocks>();
+    _data->fill(0);
+    _revision = nextChunkRevision++;
 
     _x = x;
     _y = y;
@@ -19,7 +87,7 @@ unsigned char Chunk::getBlock(int x, int y, int z) const {
         return 0;
     }
 
-    return _data[z * CHUNK_SIZE * CHUNK_SIZE + y * CHUNK_SIZE + x];
+    return (*_data)[z * CHUNK_SIZE * CHUNK_SIZE + y * CHUNK_SIZE + x];
 }
 
 void Chunk::setBlock(int x, int y, int z, unsigned char type) {
@@ -30,15 +98,66 @@ void Chunk::setBlock(int x, int y, int z, unsigned char type) {
     }
 
     int index = z * CHUNK_SIZE * CHUNK_SIZE + y * CHUNK_SIZE + x;
-    if(_data[index] == type) {
+    if((*_data)[index] == type) {
         return;
     }
+
+    detachBlocks();
     
-    _data[index] = type;
-    if(type == 0) {
-        _blockCount = std::max(0, _blockCount - 1);
-    } else {
+    if((*_data)[index] == 0) {
         _blockCount++;
+    } else if(type == 0) {
+        _blockCount = std::max(0, _blockCount - 1);
     }
+
+    (*_data)[index] = type;
+    _revision = nextChunkRevision++;
+    _dirty = true;
+}
+
+void Chunk::assignBlocks(const unsigned char* blocks) {
+    fillBlocks([blocks](unsigned char* outBlocks) {
+        std::memcpy(outBlocks, blocks, CHUNK_VOLUME);
+    });
+}
+
+void Chunk::fillBlocks(const std::function<void(unsigned char* blocks)>& fill) {
+    detachBlocks();
+    fill(_data->data());
+
+    _blockCount = static_cast<int>(countSolidBlocks(_data->data(), _data->size()));
+    _revision = nextChunkRevision++;
     _dirty = true;
+}
+
+bool Chunk::adoptBlocks(const std::shared_ptr<const ChunkBlocks>& blocks) {
+    if(blocks == _data) {
+        return true;
+    }
+
+    if(!blocks || std::memcmp(blocks->data(), _data->data(), CHUNK_VOLUME) != 0) {
+        return false;
+    }
+
+    // never written through while shared, see detachBlocks
+    _data = std::const_pointer_cast<ChunkBlocks>(blocks);
+    return true;
+}
+
+uint64_t Chunk::getBlocksHash() const {
+    if(_blocksHashRevision != _revision) {
+        _blocksHash = hashBytes(_data->data(), _data->size());
+        _blocksHashRevision = _revision;
+    }
+
+    return _blocksHash;
+}
+
+void Chunk::detachBlocks() {
+    if(_data.use_count() > 1) {
+        _data = std::make_shared<ChunkBlocks>(*_data);
+    } else {
+        // pairs with the release of the last shared reference on another thread
+        std::atomic_thread_fence(std::memory_order_acquire);
+    }
 }
\ No newline at end of file
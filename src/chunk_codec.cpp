@@ -0,0 +1,93 @@
+#include "chunk_codec.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+void rleEncode(const unsigned char* data, size_t size, std::string& out) {
+    size_t i = 0;
+    while(i < size) {
+        unsigned char value = data[i];
+
+        size_t run = 1;
+        while(i + run < size && run < 256 && data[i + run] == value) {
+            run++;
+        }
+
+        out.push_back(static_cast<char>(run - 1));
+        out.push_back(static_cast<char>(value));
+
+        i += run;
+    }
+}
+
+void rleDecode(const char* data, size_t size, unsigned char* out, size_t outSize) {
+    if(size % 2 != 0) {
+        throw std::runtime_error("Corrupt RLE data: odd payload size.");
+    }
+
+    size_t written = 0;
+    for(size_t i = 0; i < size; i += 2) {
+        size_t run = static_cast<size_t>(static_cast<unsigned char>(data[i])) + 1;
+        if(written + run > outSize) {
+            throw std::runtime_error("Corrupt RLE data: runs exceed output size.");
+        }
+
+        std::memset(out + written, static_cast<unsigned char>(data[i + 1]), run);
+        written += run;
+    }
+
+    if(written != outSize) {
+        throw std::runtime_error("Corrupt RLE data: runs do not fill the output.");
+    }
+}
+
+ChunkEncoding encodeChunkBlocks(const unsigned char* blocks, std::string& outPayload) {
+    bool uniform = true;
+    for(size_t i = 1; i < CHUNK_VOLUME; ++i) {
+        if(blocks[i] != blocks[0]) {
+            uniform = false;
+            break;
+        }
+    }
+
+    if(uniform) {
+        outPayload.push_back(static_cast<char>(blocks[0]));
+        return ChunkEncoding::UNIFORM;
+    }
+
+    size_t start = outPayload.size();
+    rleEncode(blocks, CHUNK_VOLUME, outPayload);
+
+    if(outPayload.size() - start < CHUNK_VOLUME) {
+        return ChunkEncoding::RLE;
+    }
+
+    outPayload.resize(start);
+    outPayload.append(reinterpret_cast<const char*>(blocks), CHUNK_VOLUME);
+
+    return ChunkEncoding::RAW;
+}
+
+void decodeChunkBlocks(ChunkEncoding encoding, const char* payload, size_t size, unsigned char* outBlocks) {
+    switch(encoding) {
+        case ChunkEncoding::RAW:
+            if(size != CHUNK_VOLUME) {
+                throw std::runtime_error("Corrupt chunk: raw payload has the wrong size.");
+            }
+
+            std::memcpy(outBlocks, payload, CHUNK_VOLUME);
+            break;
+        case ChunkEncoding::UNIFORM:
+            if(size != 1) {
+                throw std::runtime_error("Corrupt chunk: uniform payload has the wrong size.");
+            }
+
+            std::memset(outBlocks, static_cast<unsigned char>(payload[0]), CHUNK_VOLUME);
+            break;
+        case ChunkEncoding::RLE:
+            rleDecode(payload, size, outBlocks, CHUNK_VOLUME);
+            break;
+        default:
+            throw std::runtime_error("Unknown chunk encoding: " + std::to_string(static_cast<int>(encoding)));
+    }
+}
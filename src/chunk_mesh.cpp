@@ -1,8 +1,11 @@
 #include "chunk_mesh.hpp"
 #include "world.hpp"
 
-#define CHUNK_MAX_VERTICES (CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE * 6 * 4)
-#define CHUNK_MAX_INDICES (CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE * 6 * 6)
+#include <cstring>
+
+// a downsampled cell is solid once this fraction (1/n) of its voxels is,
+// a plain majority would erase one voxel thick floors and walls at 4x
+#define LOD_SOLID_COVERAGE 4
 
 const float FACE_VERTICES[] = {
     // FRONT FACE
@@ -72,12 +75,12 @@ const float FACE_NORMALS[] = {
 void emitFace(
     float* vertices, unsigned int* indices,
     unsigned int& vertex_count, unsigned int& index_count,
-    int face, float textureID, float fx, float fy, float fz
+    int face, float textureID, float fx, float fy, float fz, float size
 ) {
     for (int i = 0; i < 4; ++i) {
-        vertices[vertex_count * 7 + 0] = FACE_VERTICES[(face * 4 + i) * 3 + 0] + fx;
-        vertices[vertex_count * 7 + 1] = FACE_VERTICES[(face * 4 + i) * 3 + 1] + fy;
-        vertices[vertex_count * 7 + 2] = FACE_VERTICES[(face * 4 + i) * 3 + 2] + fz;
+        vertices[vertex_count * 7 + 0] = FACE_VERTICES[(face * 4 + i) * 3 + 0] * size + fx;
+        vertices[vertex_count * 7 + 1] = FACE_VERTICES[(face * 4 + i) * 3 + 1] * size + fy;
+        vertices[vertex_count * 7 + 2] = FACE_VERTICES[(face * 4 + i) * 3 + 2] * size + fz;
         vertices[vertex_count * 7 + 3] = textureID;
         vertices[vertex_count * 7 + 4] = FACE_NORMALS[(face) * 3 + 0];
         vertices[vertex_count * 7 + 5] = FACE_NORMALS[(face) * 3 + 1];
@@ -94,7 +97,7 @@ void emitFace(
     indices[index_count++] = FACE_INDICES[5] + vertex_count - 4;
 }
 
-std::unique_ptr<gfx::VertexArray> createCubeMeshVAO(int textureID) {
+unique<gfx::VertexArray> createChunkVAO() {
     auto vao = std::make_unique<gfx::VertexArray>();
 
     auto vbo = std::make_unique<gfx::VertexBuffer>(
@@ -110,6 +113,11 @@ std::unique_ptr<gfx::VertexArray> createCubeMeshVAO(int textureID) {
     vao->setVertexBuffer(std::move(vbo));
     vao->setIndexBuffer(std::move(ibo));
 
+    return vao;
+}
+
+std::unique_ptr<gfx::VertexArray> createCubeMeshVAO(int textureID) {
+    auto vao = createChunkVAO();
     renderCubeMesh(*vao, textureID);
 
     return vao;
@@ -130,123 +138,272 @@ void renderCubeMesh(gfx::VertexArray& vao, int textureID) {
     vao.getIndexBuffer()->setData(indices, index_count * sizeof(unsigned int));
 }
 
-ChunkMesh::ChunkMesh(Chunk* chunk)
-    : _chunk(chunk) {
-    _vertex_buffer = new float[CHUNK_MAX_VERTICES * 7]; // 7 floats per vertex (position, normal, texcoord)
-    _index_buffer = new unsigned int[CHUNK_MAX_INDICES];
+static void emitFace(ChunkMeshData& data, int face, float textureID, float fx, float fy, float fz, float size) {
+    unsigned int vertex_count = static_cast<unsigned int>(data.vertices.size() / 7);
+    unsigned int index_count = static_cast<unsigned int>(data.indices.size());
 
-    auto vbo = std::make_unique<gfx::VertexBuffer>(
-        gfx::BufferLayout({
-            { gfx::BufferDataType::FLOAT3 },
-            { gfx::BufferDataType::FLOAT },
-            { gfx::BufferDataType::FLOAT3 }
-        })
-    );
+    data.vertices.resize(data.vertices.size() + 4 * 7);
+    data.indices.resize(data.indices.size() + 6);
 
-    auto ibo = std::make_unique<gfx::IndexBuffer>();
+    emitFace(data.vertices.data(), data.indices.data(), vertex_count, index_count, face, textureID, fx, fy, fz, size);
+}
+
+ChunkBlocksView ChunkSnapshot::view() const {
+    ChunkBlocksView result;
+    result.blocks = blocks.data();
 
-    _vao.setVertexBuffer(std::move(vbo));
-    _vao.setIndexBuffer(std::move(ibo));
+    for(int face = 0; face < 6; ++face) {
+        result.neighbors[face] = hasNeighbor[face] ? neighbors[face].data() : nullptr;
+    }
+
+    return result;
 }
 
-ChunkMesh::~ChunkMesh() {
-    delete[] _vertex_buffer;
-    delete[] _index_buffer;
+ChunkBlocksView getChunkBlocksView(const Chunk& chunk) {
+    ChunkBlocksView view;
+    view.blocks = chunk.getBlocks().data();
+
+    auto world = chunk.getWorld();
+    for(int face = 0; face < 6; ++face) {
+        const Chunk* neighbor = world ? world->getLoadedChunk(
+            chunk.getX() + FACE_DIRECTIONS[face].x,
+            chunk.getY() + FACE_DIRECTIONS[face].y,
+            chunk.getZ() + FACE_DIRECTIONS[face].z
+        ) : nullptr;
+
+        view.neighbors[face] = neighbor ? neighbor->getBlocks().data() : nullptr;
+    }
+
+    return view;
 }
 
-void ChunkMesh::updateMesh() const {
-    unsigned int vertex_count = 0;
-    unsigned int index_count = 0;
+ChunkSnapshot takeChunkSnapshot(const Chunk& chunk) {
+    auto view = getChunkBlocksView(chunk);
 
-    auto world = _chunk->getWorld();
-    int x = _chunk->getX();
-    int y = _chunk->getY();
-    int z = _chunk->getZ();
-
-    std::array<Chunk*, 6> neighborChunks {
-        world->getChunk(x, y, z + 1), // FRONT
-        world->getChunk(x, y, z - 1), // BACK
-        world->getChunk(x - 1, y, z), // LEFT
-        world->getChunk(x + 1, y, z), // RIGHT
-        world->getChunk(x, y + 1, z), // TOP
-        world->getChunk(x, y - 1, z)  // BOTTOM
-    };
+    ChunkSnapshot snapshot;
+    snapshot.blocks = chunk.getBlocks();
 
-    auto getBlock = [&](int bx, int by, int bz) -> unsigned char {
-        if(bx < 0) {
-            if(!neighborChunks[2]) return 0;
-            return neighborChunks[2]->getBlock(bx + CHUNK_SIZE, by, bz);
-        } else if(bx >= CHUNK_SIZE) {
-            if(!neighborChunks[3]) return 0;
-            return neighborChunks[3]->getBlock(bx - CHUNK_SIZE, by, bz);
+    for(int face = 0; face < 6; ++face) {
+        snapshot.hasNeighbor[face] = view.neighbors[face] != nullptr;
+        if(view.neighbors[face]) {
+            std::memcpy(snapshot.neighbors[face].data(), view.neighbors[face], snapshot.neighbors[face].size());
         }
+    }
 
-        if(by < 0) {
-            if(!neighborChunks[5]) return 0;
-            return neighborChunks[5]->getBlock(bx, by + CHUNK_SIZE, bz);
-        } else if(by >= CHUNK_SIZE) {
-            if(!neighborChunks[4]) return 0;
-            return neighborChunks[4]->getBlock(bx, by - CHUNK_SIZE, bz);
-        }
+    return snapshot;
+}
+
+void downsampleChunkBlocks(const unsigned char* blocks, int factor, unsigned char* outCells) {
+    const int cellsPerAxis = CHUNK_SIZE / factor;
+    const int voxelsPerCell = factor * factor * factor;
+
+    std::array<uint16_t, 256> counts {};
+    std::array<unsigned char, 64> seen {};
+
+    for(int cz = 0; cz < cellsPerAxis; ++cz) {
+        for(int cy = 0; cy < cellsPerAxis; ++cy) {
+            for(int cx = 0; cx < cellsPerAxis; ++cx) {
+                int solidCount = 0;
+                int seenCount = 0;
+
+                unsigned char material = 0;
+                uint16_t materialCount = 0;
+
+                for(int z = cz * factor; z < (cz + 1) * factor; ++z) {
+                    for(int y = cy * factor; y < (cy + 1) * factor; ++y) {
+                        const unsigned char* row = blocks + z * CHUNK_SIZE * CHUNK_SIZE + y * CHUNK_SIZE + cx * factor;
+
+                        for(int x = 0; x < factor; ++x) {
+                            unsigned char id = row[x];
+                            if(!id) {
+                                continue;
+                            }
+
+                            solidCount++;
+                            if(counts[id]++ == 0 && seenCount < static_cast<int>(seen.size())) {
+                                seen[seenCount++] = id;
+                            }
+
+                            // majority vote, ties keep the first material found
+                            if(counts[id] > materialCount) {
+                                materialCount = counts[id];
+                                material = id;
+                            }
+                        }
+                    }
+                }
+
+                for(int i = 0; i < seenCount; ++i) {
+                    counts[seen[i]] = 0;
+                }
 
-        if(bz < 0) {
-            if(!neighborChunks[1]) return 0;
-            return neighborChunks[1]->getBlock(bx, by, bz + CHUNK_SIZE);
-        } else if(bz >= CHUNK_SIZE) {
-            if(!neighborChunks[0]) return 0;
-            return neighborChunks[0]->getBlock(bx, by, bz - CHUNK_SIZE);
+                bool solid = solidCount * LOD_SOLID_COVERAGE >= voxelsPerCell;
+                outCells[cz * cellsPerAxis * cellsPerAxis + cy * cellsPerAxis + cx] = solid ? material : 0;
+            }
         }
+    }
+}
 
-        return _chunk->getBlock(bx, by, bz);
+static void meshCells(
+    const unsigned char* cells, const std::array<const unsigned char*, 6>& neighbors,
+    int cellsPerAxis, float cellSize, ChunkMeshData& outData
+) {
+    struct SkirtFace {
+        int face;
+        float textureID;
+        glm::vec3 position;
     };
 
-    for (int z = 0; z < CHUNK_SIZE; ++z) {
-        for (int y = 0; y < CHUNK_SIZE; ++y) {
-            for (int x = 0; x < CHUNK_SIZE; ++x) {
-                auto blockID = _chunk->getBlock(x, y, z);
+    std::vector<SkirtFace> skirts;
+
+    auto cellIndex = [cellsPerAxis](int x, int y, int z) {
+        return z * cellsPerAxis * cellsPerAxis + y * cellsPerAxis + x;
+    };
+
+    for (int z = 0; z < cellsPerAxis; ++z) {
+        for (int y = 0; y < cellsPerAxis; ++y) {
+            for (int x = 0; x < cellsPerAxis; ++x) {
+                auto blockID = cells[cellIndex(x, y, z)];
                 if(!blockID) {
                     continue;
                 }
 
                 float textureID = blockID - 1;
+                glm::vec3 position = glm::vec3(x, y, z) * cellSize;
 
-                float fx = static_cast<float>(x);
-                float fy = static_cast<float>(y);
-                float fz = static_cast<float>(z);
+                for(int face = 0; face < 6; ++face) {
+                    glm::ivec3 n = glm::ivec3(x, y, z) + FACE_DIRECTIONS[face];
 
-                // FRONT FACE
-                if(!getBlock(x, y, z + 1)) {
-                    emitFace(_vertex_buffer, _index_buffer, vertex_count, index_count, 0, textureID, fx, fy, fz);
-                }
+                    bool inside = n.x >= 0 && n.x < cellsPerAxis &&
+                                  n.y >= 0 && n.y < cellsPerAxis &&
+                                  n.z >= 0 && n.z < cellsPerAxis;
 
-                // BACK FACE
-                if(!getBlock(x, y, z - 1)) {
-                    emitFace(_vertex_buffer, _index_buffer, vertex_count, index_count, 1, textureID, fx, fy, fz);
-                }
+                    if(inside) {
+                        if(!cells[cellIndex(n.x, n.y, n.z)]) {
+                            emitFace(outData, face, textureID, position.x, position.y, position.z, cellSize);
+                        }
 
-                // LEFT FACE
-                if(!getBlock(x - 1, y, z)) {
-                    emitFace(_vertex_buffer, _index_buffer, vertex_count, index_count, 2, textureID, fx, fy, fz);
-                }
+                        continue;
+                    }
 
-                // RIGHT FACE
-                if(!getBlock(x + 1, y, z)) {
-                    emitFace(_vertex_buffer, _index_buffer, vertex_count, index_count, 3, textureID, fx, fy, fz);
-                }
+                    const unsigned char* neighbor = neighbors[face];
+                    n.x = (n.x + cellsPerAxis) % cellsPerAxis;
+                    n.y = (n.y + cellsPerAxis) % cellsPerAxis;
+                    n.z = (n.z + cellsPerAxis) % cellsPerAxis;
 
-                // TOP FACE
-                if(!getBlock(x, y + 1, z)) {
-                    emitFace(_vertex_buffer, _index_buffer, vertex_count, index_count, 4, textureID, fx, fy, fz);
-                }
-
-                // BOTTOM FACE
-                if(!getBlock(x, y - 1, z)) {
-                    emitFace(_vertex_buffer, _index_buffer, vertex_count, index_count, 5, textureID, fx, fy, fz);
+                    if(neighbor && neighbor[cellIndex(n.x, n.y, n.z)]) {
+                        skirts.push_back({ face, textureID, position });
+                    } else {
+                        emitFace(outData, face, textureID, position.x, position.y, position.z, cellSize);
+                    }
                 }
             }
         }
     }
 
-    _vao.getVertexBuffer()->setData(_vertex_buffer, vertex_count * 8 * sizeof(float));
-    _vao.getIndexBuffer()->setData(_index_buffer, index_count * sizeof(unsigned int));
-}
\ No newline at end of file
+    outData.skirtIndexStart = static_cast<uint32_t>(outData.indices.size());
+
+    for(const auto& skirt : skirts) {
+        emitFace(outData, skirt.face, skirt.textureID, skirt.position.x, skirt.position.y, skirt.position.z, cellSize);
+    }
+}
+
+void buildChunkMeshData(const ChunkBlocksView& view, int lod, ChunkMeshData& outData) {
+    outData.clear();
+
+    if(lod == 0) {
+        meshCells(view.blocks, view.neighbors, CHUNK_SIZE, 1.0f, outData);
+        return;
+    }
+
+    const int factor = 1 << lod;
+    const int cellsPerAxis = CHUNK_SIZE / factor;
+    const int cellCount = cellsPerAxis * cellsPerAxis * cellsPerAxis;
+
+    // neighbours are downsampled the same way so border culling matches
+    // what a neighbour at this LOD actually draws
+    std::vector<unsigned char> cells(cellCount * 7);
+    std::array<const unsigned char*, 6> neighborCells {};
+
+    downsampleChunkBlocks(view.blocks, factor, cells.data());
+
+    for(int face = 0; face < 6; ++face) {
+        if(!view.neighbors[face]) {
+            continue;
+        }
+
+        unsigned char* target = cells.data() + cellCount * (face + 1);
+        downsampleChunkBlocks(view.neighbors[face], factor, target);
+        neighborCells[face] = target;
+    }
+
+    meshCells(cells.data(), neighborCells, cellsPerAxis, static_cast<float>(factor), outData);
+}
+
+// shared across all meshes so a result built for a removed chunk can never
+// match the mesh that replaced it under the same key
+static uint64_t nextMeshRevision = 0;
+
+ChunkMesh::ChunkMesh(Chunk* chunk)
+    : _chunk(chunk) {
+}
+
+void ChunkMesh::updateMesh() {
+    _revision = ++nextMeshRevision;
+    buildFullResolution();
+}
+
+void ChunkMesh::updateMesh(const ChunkMeshData& data) {
+    _revision = ++nextMeshRevision;
+    uploadLod(0, data, _revision);
+}
+
+void ChunkMesh::restoreMesh() {
+    buildFullResolution();
+}
+
+void ChunkMesh::buildFullResolution() {
+    // only ever called from the main thread, reuse the allocation
+    static ChunkMeshData data;
+
+    buildChunkMeshData(getChunkBlocksView(*_chunk), 0, data);
+    uploadLod(0, data, _revision);
+}
+
+void ChunkMesh::uploadLod(int lod, const ChunkMeshData& data, uint64_t revision) {
+    auto& level = _levels[lod];
+    if(!level.vao) {
+        level.vao = createChunkVAO();
+    }
+
+    level.vao->getVertexBuffer()->setData(data.vertices.data(), static_cast<uint32_t>(data.vertices.size() * sizeof(float)));
+    level.vao->getIndexBuffer()->setData(data.indices.data(), static_cast<uint32_t>(data.indices.size() * sizeof(unsigned int)));
+
+    level.indexCount = static_cast<uint32_t>(data.indices.size());
+    level.skirtIndexStart = data.skirtIndexStart;
+    level.bytes = data.vertices.size() * sizeof(float) + data.indices.size() * sizeof(unsigned int);
+    level.revision = revision;
+    level.pendingRevision = 0;
+}
+
+size_t ChunkMesh::releaseLod(int lod) {
+    auto& level = _levels[lod];
+    size_t bytes = level.bytes;
+
+    level.vao.reset();
+    level.indexCount = 0;
+    level.skirtIndexStart = 0;
+    level.bytes = 0;
+    level.revision = 0;
+
+    return bytes;
+}
+
+uint32_t ChunkMesh::getIndexCount(int lod, bool withSkirts) const {
+    const auto& level = _levels[lod];
+    if(!level.vao) {
+        return 0;
+    }
+
+    return withSkirts ? level.indexCount : level.skirtIndexStart;
+}
@@ -0,0 +1,258 @@
+#include "edit_history.hpp"
+
+#include <cstring>
+
+// shorter runs are cheaper as part of a literal than as a token of their own
+const size_t MIN_DELTA_RUN = 4;
+const size_t MAX_DELTA_TOKEN_LENGTH = 0x7FFF;
+
+static void writeDeltaToken(std::vector<uint8_t>& out, uint16_t token) {
+    out.push_back(static_cast<uint8_t>(token & 0xFF));
+    out.push_back(static_cast<uint8_t>(token >> 8));
+}
+
+void encodeChunkDelta(const unsigned char* before, const unsigned char* after, std::vector<uint8_t>& out) {
+    unsigned char delta[CHUNK_VOLUME];
+
+    for(size_t i = 0; i < CHUNK_VOLUME; i += 8) {
+        uint64_t beforeWord = 0;
+        uint64_t afterWord = 0;
+
+        if(before) {
+            std::memcpy(&beforeWord, before + i, sizeof(beforeWord));
+        }
+        if(after) {
+            std::memcpy(&afterWord, after + i, sizeof(afterWord));
+        }
+
+        uint64_t word = beforeWord ^ afterWord;
+        std::memcpy(delta + i, &word, sizeof(word));
+    }
+
+    out.clear();
+
+    size_t literalStart = 0;
+    auto writeLiteral = [&](size_t end) {
+        while(literalStart < end) {
+            size_t length = std::min(end - literalStart, MAX_DELTA_TOKEN_LENGTH);
+
+            writeDeltaToken(out, static_cast<uint16_t>(length));
+            out.insert(out.end(), delta + literalStart, delta + literalStart + length);
+
+            literalStart += length;
+        }
+    };
+
+    size_t i = 0;
+    while(i < CHUNK_VOLUME) {
+        size_t run = 1;
+        while(i + run < CHUNK_VOLUME && run < MAX_DELTA_TOKEN_LENGTH && delta[i + run] == delta[i]) {
+            run++;
+        }
+
+        if(run < MIN_DELTA_RUN) {
+            i += run;
+            continue;
+        }
+
+        writeLiteral(i);
+
+        // unchanged cells up to the end need no token at all
+        if(delta[i] != 0 || i + run < CHUNK_VOLUME) {
+            writeDeltaToken(out, static_cast<uint16_t>(0x8000 | run));
+            out.push_back(delta[i]);
+        }
+
+        i += run;
+        literalStart = i;
+    }
+
+    writeLiteral(CHUNK_VOLUME);
+}
+
+void applyChunkDelta(const uint8_t* delta, size_t size, unsigned char* blocks) {
+    size_t position = 0;
+    size_t i = 0;
+
+    while(position + 2 <= size && i < CHUNK_VOLUME) {
+        uint16_t token = static_cast<uint16_t>(delta[position] | (delta[position + 1] << 8));
+        position += 2;
+
+        size_t length = std::min<size_t>(token & MAX_DELTA_TOKEN_LENGTH, CHUNK_VOLUME - i);
+
+        if(token & 0x8000) {
+            if(position >= size) {
+                break;
+            }
+
+            uint8_t value = delta[position++];
+            if(value != 0) {
+                for(size_t k = 0; k < length; ++k) {
+                    blocks[i + k] ^= value;
+                }
+            }
+        } else {
+            length = std::min(length, size - position);
+
+            for(size_t k = 0; k < length; ++k) {
+                blocks[i + k] ^= delta[position + k];
+            }
+
+            position += length;
+        }
+
+        i += length;
+    }
+}
+
+EditHistory::EditHistory(size_t memoryLimit) : _memoryLimit(memoryLimit) {
+}
+
+EditHistory::~EditHistory() {
+    if(_world) {
+        _world->setChunkEditCallback(nullptr);
+    }
+}
+
+void EditHistory::begin(World& world) {
+    if(_depth++ > 0) {
+        return;
+    }
+
+    _world = &world;
+    _world->setChunkEditCallback([this](const glm::ivec3& coords, const Chunk* chunk) {
+        recordChunk(coords, chunk);
+    });
+}
+
+bool EditHistory::commit() {
+    if(_depth == 0 || --_depth > 0) {
+        return false;
+    }
+
+    _world->setChunkEditCallback(nullptr);
+
+    Step step;
+    for(const auto& [key, recorded] : _recordedChunks) {
+        const Chunk* chunk = _world->getChunk(recorded.coords.x, recorded.coords.y, recorded.coords.z);
+        auto blocks = chunk ? chunk->shareBlocks() : nullptr;
+
+        ChunkDelta chunkDelta;
+        chunkDelta.coords = recorded.coords;
+        chunkDelta.existedBefore = recorded.blocks != nullptr;
+        chunkDelta.existsAfter = chunk != nullptr;
+
+        // never written to, the chunk would have copied the array
+        if(blocks == recorded.blocks && chunkDelta.existedBefore == chunkDelta.existsAfter) {
+            continue;
+        }
+
+        encodeChunkDelta(
+            recorded.blocks ? recorded.blocks->data() : nullptr,
+            blocks ? blocks->data() : nullptr,
+            chunkDelta.delta
+        );
+
+        if(chunkDelta.delta.empty() && chunkDelta.existedBefore == chunkDelta.existsAfter) {
+            continue;
+        }
+
+        chunkDelta.delta.shrink_to_fit();
+        step.memoryUsage += sizeof(ChunkDelta) + chunkDelta.delta.capacity();
+        step.chunks.push_back(std::move(chunkDelta));
+    }
+
+    _recordedChunks.clear();
+    _hasLastRecordedKey = false;
+    _world = nullptr;
+
+    if(step.chunks.empty()) {
+        return false;
+    }
+
+    for(const auto& redoStep : _redoSteps) {
+        _memoryUsage -= redoStep.memoryUsage;
+    }
+    _redoSteps.clear();
+
+    _memoryUsage += step.memoryUsage;
+    _undoSteps.push_back(std::move(step));
+
+    trim();
+
+    return true;
+}
+
+bool EditHistory::undo(World& world) {
+    if(_undoSteps.empty() || isRecording()) {
+        return false;
+    }
+
+    Step step = std::move(_undoSteps.back());
+    _undoSteps.pop_back();
+
+    apply(world, step, true);
+    _redoSteps.push_back(std::move(step));
+
+    return true;
+}
+
+bool EditHistory::redo(World& world) {
+    if(_redoSteps.empty() || isRecording()) {
+        return false;
+    }
+
+    Step step = std::move(_redoSteps.back());
+    _redoSteps.pop_back();
+
+    apply(world, step, false);
+    _undoSteps.push_back(std::move(step));
+
+    return true;
+}
+
+void EditHistory::setMemoryLimit(size_t memoryLimit) {
+    _memoryLimit = memoryLimit;
+    trim();
+}
+
+void EditHistory::clear() {
+    _undoSteps.clear();
+    _redoSteps.clear();
+    _memoryUsage = 0;
+}
+
+void EditHistory::recordChunk(const glm::ivec3& coords, const Chunk* chunk) {
+    uint64_t key = getChunkKey(coords.x, coords.y, coords.z);
+    if(_hasLastRecordedKey && key == _lastRecordedKey) {
+        return;
+    }
+
+    _lastRecordedKey = key;
+    _hasLastRecordedKey = true;
+
+    // only the first write of the step has the chunk as it was before
+    _recordedChunks.try_emplace(key, RecordedChunk { coords, chunk ? chunk->shareBlocks() : nullptr });
+}
+
+void EditHistory::apply(World& world, const Step& step, bool before) const {
+    for(const auto& chunk : step.chunks) {
+        const auto& coords = chunk.coords;
+
+        // a missing chunk is air, so this works in both directions
+        world.editChunk(coords.x, coords.y, coords.z, [&](unsigned char* blocks) {
+            applyChunkDelta(chunk.delta.data(), chunk.delta.size(), blocks);
+        });
+
+        if(!(before ? chunk.existedBefore : chunk.existsAfter)) {
+            world.removeChunk(coords.x, coords.y, coords.z);
+        }
+    }
+}
+
+void EditHistory::trim() {
+    while(_memoryUsage > _memoryLimit && !_undoSteps.empty() && _undoSteps.size() + _redoSteps.size() > 1) {
+        _memoryUsage -= _undoSteps.front().memoryUsage;
+        _undoSteps.pop_front();
+    }
+}
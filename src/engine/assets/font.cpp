@@ -62,7 +62,7 @@ Font::FontPage _createFontPage(FT_Face face, int pixelSize) {
         character.advance_x = glyph->advance.x >> 6;
         character.advance_y = glyph->advance.y >> 6;
 
-        glyphs.emplace(c, character);
+        glyphs[c] = character;
 
         for(int row = 0; row < character.height; ++row) {
             for(int col = 0; col < character.width; ++col) {
@@ -9,9 +9,9 @@ int Text::getContentWidth() const {
     int width = 0;
 
     for(char c : _content) {
-        auto glyphIt = fontPage.glyphs.find(c);
-        if(glyphIt != fontPage.glyphs.end()) {
-            width += glyphIt->second.advance_x;
+        auto glyph = fontPage.getGlyph(c);
+        if(glyph) {
+            width += glyph->advance_x;
         }
     }
 
@@ -0,0 +1,62 @@
+#include "engine/core/mapped_file.hpp"
+#include "engine/core/filesystem.hpp"
+
+#include <stdexcept>
+
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
+#define VOXELLY_HAS_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace core;
+
+MappedFile::~MappedFile() {
+#ifdef VOXELLY_HAS_MMAP
+    if(_mapping) {
+        munmap(_mapping, _size);
+    }
+#endif
+}
+
+unique<MappedFile> MappedFile::open(const std::string& path) {
+    unique<MappedFile> file(new MappedFile());
+
+#ifdef VOXELLY_HAS_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0) {
+        throw std::runtime_error("Failed to open file: " + path);
+    }
+
+    struct stat info;
+    if(fstat(fd, &info) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Failed to stat file: " + path);
+    }
+
+    file->_size = static_cast<size_t>(info.st_size);
+
+    // mmap rejects empty mappings, an empty file simply has no data
+    if(file->_size > 0) {
+        void* mapping = mmap(nullptr, file->_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(mapping == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("Failed to map file: " + path);
+        }
+
+        file->_mapping = mapping;
+        file->_data = static_cast<const char*>(mapping);
+    }
+
+    // the mapping stays valid after the descriptor is closed
+    ::close(fd);
+#else
+    file->_buffer = FileSystem::readFromFile(path);
+    file->_data = file->_buffer.data();
+    file->_size = file->_buffer.size();
+#endif
+
+    return file;
+}
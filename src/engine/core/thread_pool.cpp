@@ -0,0 +1,150 @@
+#include "engine/core/thread_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+
+using namespace core;
+
+ThreadPool::ThreadPool(size_t workerCount) {
+    _workers.reserve(workerCount);
+    for(size_t i = 0; i < workerCount; ++i) {
+        _workers.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+
+    _condition.notify_all();
+
+    for(auto& worker : _workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> job) {
+    if(_workers.empty()) {
+        job();
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _jobs.push_back(std::move(job));
+    }
+
+    _condition.notify_one();
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t begin, size_t end)>& job) {
+    if(count == 0) {
+        return;
+    }
+
+    if(_workers.empty() || count == 1) {
+        job(0, count);
+        return;
+    }
+
+    struct State {
+        std::atomic<size_t> next { 0 };
+        std::atomic<size_t> done { 0 };
+
+        size_t count = 0;
+        size_t grain = 1;
+
+        // first exception thrown by job, guarded by mutex
+        std::atomic<bool> failed { false };
+        std::exception_ptr error;
+
+        std::mutex mutex;
+        std::condition_variable condition;
+    };
+
+    // a few ranges per thread so uneven ranges balance out
+    size_t rangeCount = std::min(count, (_workers.size() + 1) * 4);
+
+    auto state = std::make_shared<State>();
+    state->count = count;
+    state->grain = (count + rangeCount - 1) / rangeCount;
+
+    // helpers that get scheduled after every range was taken return without
+    // touching job, so it is fine for them to outlive this call
+    auto run = [state, &job]() {
+        while(true) {
+            size_t begin = state->next.fetch_add(state->grain);
+            if(begin >= state->count) {
+                return;
+            }
+
+            size_t end = std::min(begin + state->grain, state->count);
+
+            // once a range failed the rest are only counted, so the wait below
+            // still finishes and nothing escapes into a worker
+            if(!state->failed.load()) {
+                try {
+                    job(begin, end);
+                } catch(...) {
+                    std::lock_guard<std::mutex> lock(state->mutex);
+                    if(!state->error) {
+                        state->error = std::current_exception();
+                    }
+                    state->failed = true;
+                }
+            }
+
+            if(state->done.fetch_add(end - begin) + (end - begin) == state->count) {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->condition.notify_all();
+            }
+        }
+    };
+
+    size_t helperCount = std::min(_workers.size(), rangeCount - 1);
+    for(size_t i = 0; i < helperCount; ++i) {
+        submit(run);
+    }
+
+    run();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->condition.wait(lock, [&]() { return state->done.load() == state->count; });
+
+    if(state->error) {
+        std::rethrow_exception(state->error);
+    }
+}
+
+void ThreadPool::workerLoop() {
+    while(true) {
+        std::function<void()> job;
+
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _condition.wait(lock, [this]() { return _stopping || !_jobs.empty(); });
+
+            if(_stopping && _jobs.empty()) {
+                return;
+            }
+
+            job = std::move(_jobs.front());
+            _jobs.pop_front();
+        }
+
+        job();
+    }
+}
+
+ThreadPool& ThreadPool::getDefault() {
+#ifdef __EMSCRIPTEN__
+    static ThreadPool pool(0);
+#else
+    static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+#endif
+
+    return pool;
+}
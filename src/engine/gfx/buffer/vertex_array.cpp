@@ -65,6 +65,35 @@ void VertexArray::setVertexBuffer(std::unique_ptr<VertexBuffer> vertexBuffer) {
     }
 
     _vertexBuffer = std::move(vertexBuffer);
+    _vertexAttributeCount = static_cast<uint32_t>(elements.size());
+    unbind();
+}
+
+void VertexArray::setInstanceBuffer(std::unique_ptr<VertexBuffer> instanceBuffer) {
+    bind();
+    instanceBuffer->bind();
+
+    const auto& layout = instanceBuffer->getLayout();
+    const auto& elements = layout.getElements();
+    uint32_t stride = layout.getStride();
+
+    for (uint32_t i = 0; i < elements.size(); ++i) {
+        const auto& element = elements[i];
+        uint32_t location = _vertexAttributeCount + i;
+
+        glEnableVertexAttribArray(location);
+        glVertexAttribPointer(
+            location,
+            getBufferDataTypeCount(element.type),
+            getGLType(element.type),
+            element.normalized ? GL_TRUE : GL_FALSE,
+            stride,
+            reinterpret_cast<const void*>(element.offset)
+        );
+        glVertexAttribDivisor(location, 1);
+    }
+
+    _instanceBuffer = std::move(instanceBuffer);
     unbind();
 }
 
@@ -55,6 +55,31 @@ void RendererGL::drawVAO(const VertexArray& vao, RenderMode mode) {
     drawCallCount++;
 }
 
+void RendererGL::drawVAO(const VertexArray& vao, RenderMode mode, uint32_t indexCount, uint32_t indexOffset) {
+    vao.bind();
+    glDrawElements(
+        getGLPrimitiveType(mode),
+        indexCount,
+        GL_UNSIGNED_INT,
+        reinterpret_cast<const void*>(static_cast<uintptr_t>(indexOffset) * sizeof(unsigned int))
+    );
+    vao.unbind();
+
+    drawCallCount++;
+}
+
+void RendererGL::drawVAOInstanced(const VertexArray& vao, uint32_t instanceCount, RenderMode mode) {
+    if(instanceCount == 0) {
+        return;
+    }
+
+    vao.bind();
+    glDrawElementsInstanced(getGLPrimitiveType(mode), vao.getIndexBuffer()->getCount(), GL_UNSIGNED_INT, 0, instanceCount);
+    vao.unbind();
+
+    drawCallCount++;
+}
+
 void RendererGL::drawEmpty(int count) {
     _emptyVAO->bind();
     glDrawArrays(GL_TRIANGLES, 0, count);
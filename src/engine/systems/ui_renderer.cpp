@@ -1,28 +1,16 @@
 #include "engine/systems/ui_renderer.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 
-std::unique_ptr<gfx::VertexArray> createQuadVAO(gfx::BufferUsage usage) {
-    const float vertices[] = {
-        0.0f, 0.0f, 0.0f, 0.0f,
-        1.0f, 0.0f, 1.0f, 0.0f,
-        1.0f, 1.0f, 1.0f, 1.0f,
-        0.0f, 1.0f, 0.0f, 1.0f,
-    };
-
-    const int indices[] = {
-        0, 1, 2,
-        2, 3, 0
-    };
-
+std::unique_ptr<gfx::VertexArray> createBatchVAO() {
     auto indexBuffer = std::make_unique<gfx::IndexBuffer>();
     auto vertexBuffer = std::make_unique<gfx::VertexBuffer>(gfx::BufferLayout({
-        gfx::BufferLayoutElement(gfx::BufferDataType::FLOAT2),
-        gfx::BufferLayoutElement(gfx::BufferDataType::FLOAT2)
-    }), usage);
-
-    vertexBuffer->setData(vertices, sizeof(vertices));
-    indexBuffer->setData(indices, sizeof(indices));
+        gfx::BufferLayoutElement(gfx::BufferDataType::FLOAT2), // position
+        gfx::BufferLayoutElement(gfx::BufferDataType::FLOAT2), // texcoord
+        gfx::BufferLayoutElement(gfx::BufferDataType::FLOAT4)  // color
+    }), gfx::BufferUsage::STREAM);
 
     auto vao = std::make_unique<gfx::VertexArray>();
     vao->setVertexBuffer(std::move(vertexBuffer));
@@ -31,21 +19,10 @@ std::unique_ptr<gfx::VertexArray> createQuadVAO(gfx::BufferUsage usage) {
     return vao;
 }
 
-void updateQuadVAOUVs(gfx::VertexArray& vao, const glm::vec4& uvs) {
-    const float vertices[] = {
-        0.0f, 0.0f, uvs.x, uvs.y,
-        1.0f, 0.0f, uvs.z, uvs.y,
-        1.0f, 1.0f, uvs.z, uvs.w,
-        0.0f, 1.0f, uvs.x, uvs.w,
-    };
-    
-    vao.getVertexBuffer()->setData(vertices, sizeof(vertices));
-}
-
 UIRenderer::UIRenderer(gfx::Renderer& renderer, const Camera& camera)
     : _renderer(renderer), _camera(camera) {
-    _quadVAO = createQuadVAO(gfx::BufferUsage::STATIC);
-    _spriteVAO = createQuadVAO(gfx::BufferUsage::DYNAMIC);
+    _batchVAO = createBatchVAO();
+    reserveIndices(64);
 }
 
 void UIRenderer::renderQuad(gfx::Shader& shader, const gfx::Texture& texture, const Transform2D& transform) {
@@ -54,38 +31,114 @@ void UIRenderer::renderQuad(gfx::Shader& shader, const gfx::Texture& texture, co
 }
 
 void UIRenderer::renderQuad(gfx::Shader& shader, const gfx::Texture& texture, float x, float y, float width, float height, float angle) {
-    _renderer.useShader(shader);
-    _renderer.bindTexture(0, texture);
-
-    glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(x, y, 0.0f)) *
-                        glm::rotate(glm::mat4(1.0f), glm::radians(angle), glm::vec3(0.0f, 0.0f, 1.0f)) *
-                        glm::scale(glm::mat4(1.0f), glm::vec3(width, height, 1.0f));
-
-    shader.setUniformMat4("u_Model", glm::value_ptr(model));
-    shader.setUniformMat4("u_View", glm::value_ptr(_camera.getViewMatrix()));
-    shader.setUniformMat4("u_Projection", glm::value_ptr(_camera.getProjectionMatrix()));
-    
-    _renderer.drawVAO(*_quadVAO, gfx::RenderMode::TRIANGLES);
+    submitQuad(
+        shader, texture,
+        glm::vec2(x, y), glm::vec2(width, height), angle,
+        glm::vec4(0.0f, 0.0f, 1.0f, 1.0f),
+        glm::vec4(1.0f, 1.0f, 1.0f, 1.0f)
+    );
 }
 
 void UIRenderer::renderSprite(gfx::Shader& shader, const Sprite& sprite) {
     auto correctedPosition = sprite.position - (sprite.anchor * sprite.size);
-    updateQuadVAOUVs(*_spriteVAO, sprite.getUVs());
 
-    _renderer.useShader(shader);
-    _renderer.bindTexture(0, *sprite.getTexture());
+    submitQuad(
+        shader, *sprite.getTexture(),
+        correctedPosition, sprite.size, sprite.rotation,
+        sprite.getUVs(), sprite.getColor()
+    );
+}
+
+void UIRenderer::submitQuad(
+    gfx::Shader& shader, const gfx::Texture& texture,
+    const glm::vec2& position, const glm::vec2& size, float angle,
+    const glm::vec4& uvs, const glm::vec4& color
+) {
+    if(_batchShader != &shader) {
+        flush();
+        _batchShader = &shader;
+    }
+
+    // same as translate(position) * rotate(angle) * scale(size) applied to the unit quad
+    float radians = glm::radians(angle);
+    glm::vec2 axisX = glm::vec2(std::cos(radians), std::sin(radians)) * size.x;
+    glm::vec2 axisY = glm::vec2(-std::sin(radians), std::cos(radians)) * size.y;
+
+    BatchQuad quad;
+    quad.texture = &texture;
+
+    quad.vertices[0] = { position, glm::vec2(uvs.x, uvs.y), color };
+    quad.vertices[1] = { position + axisX, glm::vec2(uvs.z, uvs.y), color };
+    quad.vertices[2] = { position + axisX + axisY, glm::vec2(uvs.z, uvs.w), color };
+    quad.vertices[3] = { position + axisY, glm::vec2(uvs.x, uvs.w), color };
+
+    _quads.push_back(quad);
+}
+
+void UIRenderer::reserveIndices(uint32_t quadCount) {
+    if(quadCount <= _indexCapacity) {
+        return;
+    }
+
+    uint32_t capacity = std::max(quadCount, _indexCapacity * 2);
+    std::vector<unsigned int> indices(capacity * 6);
+
+    for(uint32_t i = 0; i < capacity; ++i) {
+        indices[i * 6 + 0] = i * 4 + 0;
+        indices[i * 6 + 1] = i * 4 + 1;
+        indices[i * 6 + 2] = i * 4 + 2;
+        indices[i * 6 + 3] = i * 4 + 2;
+        indices[i * 6 + 4] = i * 4 + 3;
+        indices[i * 6 + 5] = i * 4 + 0;
+    }
+
+    _batchVAO->getIndexBuffer()->setData(indices.data(), static_cast<uint32_t>(indices.size() * sizeof(unsigned int)));
+    _indexCapacity = capacity;
+}
+
+void UIRenderer::flush() {
+    if(_quads.empty() || !_batchShader) {
+        _quads.clear();
+        return;
+    }
+
+    std::stable_sort(_quads.begin(), _quads.end(), [](const BatchQuad& a, const BatchQuad& b) {
+        return a.texture < b.texture;
+    });
+
+    _vertices.clear();
+    _vertices.reserve(_quads.size() * 4);
+    for(const auto& quad : _quads) {
+        _vertices.insert(_vertices.end(), quad.vertices, quad.vertices + 4);
+    }
+
+    reserveIndices(static_cast<uint32_t>(_quads.size()));
+    _batchVAO->getVertexBuffer()->setData(_vertices.data(), static_cast<uint32_t>(_vertices.size() * sizeof(QuadVertex)));
 
-    glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(correctedPosition, 0.0f)) *
-                        glm::rotate(glm::mat4(1.0f), glm::radians(sprite.rotation), glm::vec3(0.0f, 0.0f, 1.0f)) *
-                        glm::scale(glm::mat4(1.0f), glm::vec3(sprite.size, 1.0f));
+    auto viewProjection = _camera.getProjectionMatrix() * _camera.getViewMatrix();
 
-    auto mvp = _camera.getProjectionMatrix() * _camera.getViewMatrix() * model;
-    auto color = sprite.getColor();
+    _renderer.useShader(*_batchShader);
+    _batchShader->setUniformMat4("u_MVP", glm::value_ptr(viewProjection));
+    _batchShader->setUniformInt("u_UseTexture", 1);
 
-    shader.setUniformMat4("u_MVP", glm::value_ptr(mvp));
-    shader.setUniformVec4("u_Color", color.r, color.g, color.b, color.a);
-    shader.setUniformInt("u_UseColor", 1);
-    shader.setUniformInt("u_UseTexture", 1);
+    size_t groupStart = 0;
+    while(groupStart < _quads.size()) {
+        const gfx::Texture* texture = _quads[groupStart].texture;
 
-    _renderer.drawVAO(*_spriteVAO, gfx::RenderMode::TRIANGLES);
-}
\ No newline at end of file
+        size_t groupEnd = groupStart + 1;
+        while(groupEnd < _quads.size() && _quads[groupEnd].texture == texture) {
+            ++groupEnd;
+        }
+
+        _renderer.bindTexture(0, *texture);
+        _renderer.drawVAO(
+            *_batchVAO, gfx::RenderMode::TRIANGLES,
+            static_cast<uint32_t>((groupEnd - groupStart) * 6),
+            static_cast<uint32_t>(groupStart * 6)
+        );
+
+        groupStart = groupEnd;
+    }
+
+    _quads.clear();
+}
@@ -1,5 +1,34 @@
 #include "game.hpp"
 
+// GPU memory chunk meshes may hold before meshes out of view get evicted
+const size_t WORLD_MESH_GPU_BUDGET = 256 * 1024 * 1024;
+
+// relative to the user data path
+const std::string WORLD_SAVE_FILE = "arrow.dat";
+// saved worlds up to this many chunks, e.g. a generated one, are decoded
+// whole on the thread pool at startup, larger ones are streamed in
+const size_t WORLD_PRELOAD_CHUNKS = 8192;
+
+// MagicaVoxel models read by F6 and written by F7, relative to the user data path
+const std::string VOX_IMPORT_FILE = "import.vox";
+const std::string VOX_EXPORT_FILE = "export.vox";
+
+// chunks replaced by generated terrain on G, 512 x 128 x 512 blocks from the origin
+const glm::ivec3 GENERATED_WORLD_CHUNKS = glm::ivec3(32, 8, 32);
+
+// H stamps the tool shape at this many times the brush size, as a shell
+// this thick, Shift+H carves it out whole
+const int SHAPE_STAMP_SCALE = 4;
+const int SHAPE_STAMP_WALL = 2;
+
+// clipboard written by F8 and read by F9, relative to the user data path
+const std::string CLIPBOARD_FILE = "clipboard.vxc";
+
+// seconds between journal appends of edited chunks
+const double WORLD_AUTOSAVE_INTERVAL = 10.0;
+// journal size after which autosave does a full save instead
+const size_t WORLD_JOURNAL_COMPACT_SIZE = 16 * 1024 * 1024;
+
 std::vector<glm::ivec3> getVoxelsForTool(const World& world, const glm::ivec3& center, int brushSize, ToolShape shape) {
     std::vector<glm::ivec3> voxels;
 
@@ -9,11 +38,31 @@ std::vector<glm::ivec3> getVoxelsForTool(const World& world, const glm::ivec3& c
         glm::ivec3 min = center - glm::ivec3(brushSize);
         glm::ivec3 max = center + glm::ivec3(brushSize);
         voxels = world.getVoxelsInCube(min, max);
+    } else {
+        BrushStroke::getShape(glm::vec3(center), brushSize, shape).forEachSpan([&](int minX, int maxX, int y, int z) {
+            for(int x = minX; x <= maxX; ++x) {
+                if(x >= 0 && y >= 0 && z >= 0) {
+                    voxels.emplace_back(x, y, z);
+                }
+            }
+        });
     }
 
     return voxels;
 }
 
+const char* get_tool_shape_name(ToolShape shape) {
+    switch(shape) {
+        case ToolShape::SHAPE_SPHERE: return "Sphere";
+        case ToolShape::SHAPE_CUBE: return "Cube";
+        case ToolShape::SHAPE_CYLINDER: return "Cylinder";
+        case ToolShape::SHAPE_CONE: return "Cone";
+        case ToolShape::SHAPE_TORUS: return "Torus";
+    }
+
+    return "";
+}
+
 std::optional<glm::ivec3> find_lowest_voxel_on_xz(const std::vector<glm::ivec3>& voxels, int x, int z) {
     if(voxels.empty()) {
         return std::nullopt;
@@ -56,6 +105,8 @@ void Game::init() {
 
     std::cout << "Compiling Voxel Shader..." << std::endl;
     voxelShader.compile(*assetManager->loadAsset<assets::Shader>("assets/shaders/voxel.glsl"));
+    std::cout << "Compiling Voxel Instanced Shader..." << std::endl;
+    voxelInstancedShader.compile(*assetManager->loadAsset<assets::Shader>("assets/shaders/voxel-instanced.glsl"));
     std::cout << "Compiling Text Shader..." << std::endl;
     textShader.compile(*assetManager->loadAsset<assets::Shader>("assets/shaders/text.glsl"));
     std::cout << "Compiling Grid Shader..." << std::endl;
@@ -111,6 +162,12 @@ void Game::init() {
     drawCallText = std::make_unique<Text>("Draw Calls: 0", font, 16);
     drawCallText->anchor = glm::vec2(1.0f, 1.0f);
 
+    meshMemoryText = std::make_unique<Text>("Mesh Memory: 0.0 MB", font, 16);
+    meshMemoryText->anchor = glm::vec2(1.0f, 1.0f);
+
+    meshLodMemoryText = std::make_unique<Text>("LOD 0.0 / 0.0 / 0.0 MB", font, 16);
+    meshLodMemoryText->anchor = glm::vec2(1.0f, 1.0f);
+
     currentToolText = std::make_unique<Text>("Tool: Place", font, 16);
     currentToolText->anchor = glm::vec2(0.0f, 0.0f);
 
@@ -152,19 +209,61 @@ void Game::init() {
     auto cubeMesh = assets::MeshBuilder::createCube();
 
     outlineVAO = renderer->createMeshVAO(cubeMesh);
-    previewVAO = createCubeMeshVAO(0);
     
+    worldSavePath = core::FileSystem::getDataPath() + WORLD_SAVE_FILE;
+
     try {
-        world = World::loadFromAsset(WorldAsset::loadFromFile("assets/examples/chess.dat"));
+        if(std::filesystem::exists(worldSavePath)) {
+            world = World::loadFromPath(worldSavePath);
+        } else {
+            world = World::loadFromFile("assets/examples/chess.dat");
+        }
     } catch (...) {
         world = std::make_unique<World>();
         world->createChunk(0, 0, 0);
     }
 
+    worldSaver = std::make_unique<WorldSaver>();
+
+    // edits autosaved after the last full save, e.g. before a crash
+    try {
+        size_t recovered = replayWorldJournal(*world, getWorldJournalPath(worldSavePath));
+        if(recovered > 0) {
+            std::cout << "Recovered " << recovered << " chunk edits from the world journal." << std::endl;
+            worldSaver->save(*world, worldSavePath);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to replay world journal: " << e.what() << std::endl;
+    }
+
+    // repeated parts of a build, like the squares of the chess board, share their blocks
+    world->setChunkDeduplication(true);
+
+    if(world->getRegion() && world->getRegion()->getChunkCount() <= WORLD_PRELOAD_CHUNKS) {
+        try {
+            auto start = std::chrono::high_resolution_clock::now();
+            size_t loaded = world->loadAllRegionChunks(core::ThreadPool::getDefault());
+
+            std::cout << "Loaded " << loaded << " chunks in "
+                      << std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() << " ms." << std::endl;
+        } catch(const std::exception& e) {
+            // nothing was added, the chunks are streamed in instead
+            std::cerr << "Failed to preload world: " << e.what() << std::endl;
+        }
+    }
+
+    auto storage = world->getStorageStats();
+    if(storage.savedBytes > 0) {
+        std::cout << storage.chunkCount << " chunks share " << storage.blockArrayCount << " block arrays, "
+                  << storage.savedBytes << " bytes saved." << std::endl;
+    }
+
     worldMesh = std::make_unique<WorldMesh>(world.get());
+    worldMesh->setGpuBudget(WORLD_MESH_GPU_BUDGET);
+
+    worldStreamer = std::make_unique<WorldStreamer>(world.get());
 
-    toolWorld = std::make_unique<World>();
-    toolWorldMesh = std::make_unique<WorldMesh>(toolWorld.get());
+    toolPreview = std::make_unique<ToolPreview>();
 
     set_current_palette_sprite_uvs(0);
     regenerate_palette();
@@ -200,9 +299,90 @@ void Game::init() {
                 renderer->setWireframe(isWireframe);
                 break;
 
+            case SDL_SCANCODE_F5:
+                if(!worldSaver->save(*world, worldSavePath)) {
+                    std::cout << "World is still being saved." << std::endl;
+                }
+                break;
+
+            case SDL_SCANCODE_F6:
+                import_vox();
+                break;
+
+            case SDL_SCANCODE_F7:
+                export_vox();
+                break;
+
+            case SDL_SCANCODE_F8:
+                save_clipboard();
+                break;
+
+            case SDL_SCANCODE_F9:
+                load_clipboard();
+                break;
+
+            case SDL_SCANCODE_LEFTBRACKET:
+                if(!paintMask.isEmpty()) {
+                    paintMask.shrink();
+                    std::cout << "Paint mask: " << paintMask.getCount() << " voxels" << std::endl;
+                }
+                break;
+
+            case SDL_SCANCODE_RIGHTBRACKET:
+                if(!paintMask.isEmpty()) {
+                    paintMask.grow();
+                    std::cout << "Paint mask: " << paintMask.getCount() << " voxels" << std::endl;
+                }
+                break;
+
+            case SDL_SCANCODE_RETURN:
+                paint_mask();
+                break;
+
+            case SDL_SCANCODE_H:
+                stamp_shape(isKeyHeld[SDL_SCANCODE_LSHIFT]);
+                break;
+
+            case SDL_SCANCODE_G:
+                if(isKeyHeld[SDL_SCANCODE_LSHIFT]) {
+                    worldGeneratorSeed++;
+                }
+                generate_world();
+                break;
+
+            case SDL_SCANCODE_C:
+                if(isKeyHeld[SDL_SCANCODE_LCTRL] && brushHit.has_value() && world->getBlock(brushHit->block.x, brushHit->block.y, brushHit->block.z) != 0) {
+                    clipboard = VoxelClipboard::copySelection(*world, world->selectConnected(brushHit->block));
+                    std::cout << "Copied " << clipboard.getVoxelCount() << " voxels (" << clipboard.getMemoryUsage() << " bytes)" << std::endl;
+                }
+                break;
+
+            case SDL_SCANCODE_V:
+                if(isKeyHeld[SDL_SCANCODE_LCTRL] && brushHit.has_value()) {
+                    editHistory.begin(*world);
+                    clipboard.paste(*world, brushHit->block + brushHit->side);
+                    editHistory.commit();
+
+                    clear_paint_mask();
+                }
+                break;
+
+            case SDL_SCANCODE_L:
+                report_components();
+                break;
+
+            case SDL_SCANCODE_PERIOD:
+                clipboard = clipboard.rotated(1);
+                break;
+
+            case SDL_SCANCODE_COMMA:
+                clipboard = clipboard.mirrored(0);
+                break;
+
             case SDL_SCANCODE_R:
                 try {
                     voxelShader.compile(*assetManager->loadAsset<assets::Shader>("assets/shaders/voxel.glsl", true));
+                    voxelInstancedShader.compile(*assetManager->loadAsset<assets::Shader>("assets/shaders/voxel-instanced.glsl", true));
                     textShader.compile(*assetManager->loadAsset<assets::Shader>("assets/shaders/text.glsl", true));
                     gridShader.compile(*assetManager->loadAsset<assets::Shader>("assets/shaders/grid.glsl", true));
                     outlineShader.compile(*assetManager->loadAsset<assets::Shader>("assets/shaders/outline.glsl", true));
@@ -289,7 +469,7 @@ void Game::init() {
                 break;
 
             case SDL_SCANCODE_TAB:
-                toolShape = (toolShape == ToolShape::SHAPE_SPHERE) ? ToolShape::SHAPE_CUBE : ToolShape::SHAPE_SPHERE;
+                toolShape = static_cast<ToolShape>((static_cast<int>(toolShape) + 1) % (static_cast<int>(ToolShape::SHAPE_TORUS) + 1));
                 break;
 
             case SDL_SCANCODE_X:
@@ -304,6 +484,11 @@ void Game::init() {
                 break;
 
             case SDL_SCANCODE_Y:
+                if(isKeyHeld[SDL_SCANCODE_LCTRL]) {
+                    redo_edit();
+                    break;
+                }
+
                 if(axisLock == AxisLock::AXIS_LOCK_Y) {
                     axisLock = AxisLock::AXIS_LOCK_NONE;
                 } else {
@@ -315,6 +500,15 @@ void Game::init() {
                 break;
 
             case SDL_SCANCODE_Z:
+                if(isKeyHeld[SDL_SCANCODE_LCTRL]) {
+                    if(isKeyHeld[SDL_SCANCODE_LSHIFT]) {
+                        redo_edit();
+                    } else {
+                        undo_edit();
+                    }
+                    break;
+                }
+
                 if(axisLock == AxisLock::AXIS_LOCK_Z) {
                     axisLock = AxisLock::AXIS_LOCK_NONE;
                 } else {
@@ -343,9 +537,15 @@ void Game::init() {
                 return;
             }
 
+            if(currentTool == ToolType::TOOL_BRUSH && isKeyHeld[SDL_SCANCODE_LCTRL]) {
+                pick_paint_mask();
+            }
+
             if(currentTool == ToolType::TOOL_MOVE) {
-                moveVoxels = world->getConnectedVoxels(brushHit->block);
+                moveVoxels = world->selectConnected(brushHit->block);
                 moveVoxelsStart = brushHit->block;
+                moveVoxelsPreviewed = false;
+                toolPreviewDirty = true;
             }
         }
         if(button == SDL_BUTTON_RIGHT) {
@@ -373,28 +573,12 @@ void Game::init() {
                 return;
             }
 
-            std::vector<unsigned char> tempBlockIds(moveVoxels.size());
-
-            for(size_t i = 0; i < moveVoxels.size(); i++) {
-                const auto& pos = moveVoxels[i];
-                unsigned char blockId = world->getBlock(pos.x, pos.y, pos.z);
-
-                tempBlockIds[i] = blockId;
-                world->setBlock(pos.x, pos.y, pos.z, 0);
-            }
-
-            for(size_t i = 0; i < moveVoxels.size(); i++) {
-                if(tempBlockIds[i] == 0) {
-                    continue;
-                }
-
-                const auto& voxelPos = moveVoxels[i];
-                glm::ivec3 newPos = voxelPos + delta;
-
-                world->setBlock(newPos.x, newPos.y, newPos.z, tempBlockIds[i]);
-            }
+            editHistory.begin(*world);
+            world->moveSelection(moveVoxels, delta);
+            editHistory.commit();
 
             moveVoxels.clear();
+            toolPreviewDirty = true;
         }
 
         if(button == SDL_BUTTON_RIGHT) {
@@ -450,6 +634,7 @@ void Game::init() {
     });*/
     
     lastTime = std::chrono::high_resolution_clock::now();
+    lastAutosaveTime = std::chrono::high_resolution_clock::now();
 }
 
 void Game::loop() {
@@ -462,11 +647,17 @@ void Game::loop() {
 
     if(std::chrono::duration<double>(currentTime - lastTime).count() >= 1.0) {
         fpsText->setContent("FPS: " + std::to_string(static_cast<int>(frameCounter)));
+        update_mesh_memory_text();
 
         lastTime = currentTime;
         frameCounter = 0.0;
     }
 
+    if(std::chrono::duration<double>(currentTime - lastAutosaveTime).count() >= WORLD_AUTOSAVE_INTERVAL) {
+        autosave_world();
+        lastAutosaveTime = currentTime;
+    }
+
     drawCallText->setContent("Draw Calls: " + std::to_string(deltaDrawCalls));
     
     cameraText->setContent(
@@ -533,58 +724,73 @@ void Game::loop() {
         worldCamera.rotation = glm::vec3(0.0f, 0.0f, 0.0f);
     }*/
 
-    static glm::vec3 lineStart;
-    static glm::vec3 lineEnd;
+    bool isStrokeTool = currentTool == ToolType::TOOL_PLACE || currentTool == ToolType::TOOL_BRUSH || currentTool == ToolType::TOOL_ERASE;
+    // Ctrl+click picks the paint mask instead
+    if(currentTool == ToolType::TOOL_BRUSH && isKeyHeld[SDL_SCANCODE_LCTRL] && !brushStroke.isActive()) {
+        isStrokeTool = false;
+    }
 
-    if(window->getMouseButtonState(SDL_BUTTON_LEFT)) {
-        if(canPressMouse[SDL_BUTTON_LEFT] && brushHit.has_value()) {
-            if(currentTool == ToolType::TOOL_PLACE) {
-                auto voxels = getVoxelsForTool(*world, brushHit->block + brushHit->side, brushSize, toolShape);
-                world->setBlocks(voxels, blockType + 1);
-            } else if(currentTool == ToolType::TOOL_BRUSH) {
-                auto voxels = getVoxelsForTool(*world, brushHit->block, brushSize, toolShape);
-                for(const auto& voxel : voxels) {
-                    if(world->getBlock(voxel.x, voxel.y, voxel.z) != 0) {
-                        world->setBlock(voxel.x, voxel.y, voxel.z, blockType + 1);
-                    }
+    if(window->getMouseButtonState(SDL_BUTTON_LEFT) && isStrokeTool) {
+        if(brushHit.has_value()) {
+            glm::ivec3 center = currentTool == ToolType::TOOL_PLACE ? brushHit->block + brushHit->side : brushHit->block;
+
+            if(!brushStroke.isActive()) {
+                BrushStrokeMode mode = BrushStrokeMode::STROKE_PLACE;
+                if(currentTool == ToolType::TOOL_BRUSH) {
+                    mode = BrushStrokeMode::STROKE_PAINT;
+                } else if(currentTool == ToolType::TOOL_ERASE) {
+                    mode = BrushStrokeMode::STROKE_ERASE;
                 }
-            } else if(currentTool == ToolType::TOOL_ERASE) {
-                auto voxels = getVoxelsForTool(*world, brushHit->block, brushSize, toolShape);
-                world->setBlocks(voxels, 0);
-            } else if(currentTool == ToolType::TOOL_LINE) {
-                int x = brushHit->block.x + brushHit->side.x;
-                int y = brushHit->block.y + brushHit->side.y;
-                int z = brushHit->block.z + brushHit->side.z;
 
-                if(x >= 0 && y >= 0 && z >= 0) {
-                    if(!lineInProgress) {
-                        lineStart = glm::vec3(static_cast<float>(x), static_cast<float>(y), static_cast<float>(z));
-                        lineInProgress = true;
-                    } else {
-                        lineEnd = glm::vec3(static_cast<float>(x), static_cast<float>(y), static_cast<float>(z));
-
-                        world->forVoxelsInLine(
-                            glm::ivec3(
-                                static_cast<int>(lineStart.x),
-                                static_cast<int>(lineStart.y),
-                                static_cast<int>(lineStart.z)
-                            ),
-                            glm::ivec3(
-                                static_cast<int>(lineEnd.x),
-                                static_cast<int>(lineEnd.y),
-                                static_cast<int>(lineEnd.z)
-                            ),
-                            [&](int px, int py, int pz) {
-                                world->setBlock(px, py, pz, blockType + 1);
-                            }
-                        );
-
-                        lineInProgress = false;
-                    }
+                // the stroke stays in the layer of voxels it starts in
+                strokeCenter = center;
+                strokeSide = brushHit->side;
+                strokeAxis = strokeSide.x != 0 ? 0 : (strokeSide.z != 0 ? 2 : 1);
+
+                editHistory.begin(*world);
+                brushStroke.begin(*world, center, brushSize, toolShape, mode, blockType + 1, paintMask.isEmpty() ? nullptr : &paintMask);
+            } else {
+                brushStroke.moveTo(center);
+            }
+        }
+
+        // everything the stroke covered since the last frame in one go
+        if(brushStroke.flush() > 0) {
+            toolPreviewDirty = true;
+        }
+    } else if(brushStroke.isActive()) {
+        brushStroke.end();
+        editHistory.commit();
+        toolPreviewDirty = true;
+    }
+
+    if(window->getMouseButtonState(SDL_BUTTON_LEFT)) {
+        if(canPressMouse[SDL_BUTTON_LEFT] && brushHit.has_value() && currentTool == ToolType::TOOL_LINE) {
+            editHistory.begin(*world);
+
+            int x = brushHit->block.x + brushHit->side.x;
+            int y = brushHit->block.y + brushHit->side.y;
+            int z = brushHit->block.z + brushHit->side.z;
+
+            if(x >= 0 && y >= 0 && z >= 0) {
+                if(!lineInProgress) {
+                    lineStart = glm::ivec3(x, y, z);
+                    lineInProgress = true;
+                } else {
+                    // thick lines and capsules with the brush size and shape
+                    BrushStroke line;
+                    line.begin(*world, lineStart, brushSize, toolShape, BrushStrokeMode::STROKE_PLACE, blockType + 1);
+                    line.moveTo(glm::ivec3(x, y, z));
+                    line.end();
+
+                    lineInProgress = false;
                 }
             }
 
+            editHistory.commit();
+
             canPressMouse[SDL_BUTTON_LEFT] = false;
+            toolPreviewDirty = true;
         }
     } else {
         canPressMouse[SDL_BUTTON_LEFT] = true;
@@ -675,18 +881,16 @@ void Game::loop() {
                 t
             };
         }
+    } else if(brushStroke.isActive()) {
+        // picking the world would hit the voxels the stroke just wrote, so
+        // Place would pile up towards the camera and Erase dig in
+        brushHit = find_stroke_plane_hit();
     } else {
         if(rayBlockHit.has_value()) {
             if(currentTool == ToolType::TOOL_MOVE) {
-                bool isInMoveVoxels = false;
-                for(const auto& voxelPos : moveVoxels) {
-                    if(voxelPos == rayBlockHit->block) {
-                        isInMoveVoxels = true;
-                        break;
-                    }
-                }
+                bool isInMoveVoxels = moveVoxels.contains(rayBlockHit->block);
 
-                if(!moveVoxels.empty() && isInMoveVoxels) {
+                if(isInMoveVoxels) {
                     brushHit = std::nullopt;
                 } else {
                     brushHit = rayBlockHit;
@@ -787,70 +991,24 @@ void Game::loop() {
         }
     }
 
-    toolWorld->removeAllChunks();
-    toolWorldMesh->clearChunkMeshes();
+    ToolPreviewState previewState;
+    previewState.tool = currentTool;
+    previewState.shape = toolShape;
+    previewState.brushSize = brushSize;
+    previewState.blockType = blockType;
+    previewState.hasHit = brushHit.has_value();
     if(brushHit.has_value()) {
-        if(currentTool == ToolType::TOOL_PLACE) {
-            auto voxels = getVoxelsForTool(*world, brushHit->block + brushHit->side, brushSize, toolShape);
-            toolWorld->setBlocks(voxels, blockType + 1);
-        } else if(currentTool == ToolType::TOOL_ERASE) {
-                auto voxels = getVoxelsForTool(*world, brushHit->block, brushSize, toolShape);
-                toolWorld->setBlocks(voxels, 1);
-        } else if(currentTool == ToolType::TOOL_BRUSH) {
-                auto voxels = getVoxelsForTool(*world, brushHit->block, brushSize, toolShape);
-                
-                for(const auto& voxel : voxels) {
-                    if(world->getBlock(voxel.x, voxel.y, voxel.z) != 0) {
-                        toolWorld->setBlock(voxel.x, voxel.y, voxel.z, blockType + 1);
-                    }
-                }
-        } else if(currentTool == ToolType::TOOL_LINE) {
-                int x = brushHit->block.x + brushHit->side.x;
-                int y = brushHit->block.y + brushHit->side.y;
-                int z = brushHit->block.z + brushHit->side.z;
-
-                if(x >= 0 && y >= 0 && z >= 0) {
-                    if(lineInProgress) {
-                        world->forVoxelsInLine(
-                            glm::ivec3(
-                                static_cast<int>(lineStart.x),
-                                static_cast<int>(lineStart.y),
-                                static_cast<int>(lineStart.z)
-                            ),
-                            glm::ivec3(x, y, z),
-                            [&](int px, int py, int pz) {
-                                if(px >= 0 && py >= 0 && pz >= 0) {
-                                    toolWorld->setBlock(px, py, pz, blockType + 1);
-                                }
-                            }
-                        );
-                    } else {
-                        toolWorld->setBlock(x, y, z, blockType + 1);
-                    }
-                }
-        } else if(currentTool == ToolType::TOOL_MOVE) {
-            if(!moveVoxels.empty()) {
-                auto pos = brushHit->block + brushHit->side;
+        previewState.block = brushHit->block;
+        previewState.side = brushHit->side;
+    }
+    previewState.lineInProgress = lineInProgress;
+    previewState.lineStart = lineStart;
 
-                if(pos.x < 0 || pos.y < 0 || pos.z < 0) {
-                    return;
-                }
+    if(toolPreviewDirty || previewState != toolPreviewState) {
+        update_tool_preview();
 
-                glm::ivec3 delta = pos - moveVoxelsStart;
-                if(delta.y < 0) {
-                    delta.y = 0;
-                }
-
-                for(const auto& voxelPos : moveVoxels) {
-                    toolWorld->setBlock(
-                        voxelPos.x + delta.x,
-                        voxelPos.y + delta.y,
-                        voxelPos.z + delta.z,
-                        world->getBlock(voxelPos.x, voxelPos.y, voxelPos.z)
-                    );
-                }
-            }   
-        }
+        toolPreviewState = previewState;
+        toolPreviewDirty = false;
     }
 
     lastMousePos = currentMouse;
@@ -860,11 +1018,11 @@ void Game::loop() {
     );
 
     toolShapeText->setContent(
-        std::string("Tool Shape: ") + (toolShape == ToolShape::SHAPE_CUBE ? "Cube" : "Sphere")
+        std::string("Tool Shape: ") + get_tool_shape_name(toolShape)
     );
 
-    worldMesh->update();
-    toolWorldMesh->update();
+    worldStreamer->update(*worldCamera);
+    worldMesh->update(*worldCamera, static_cast<float>(window->getFramebufferHeight()));
 
     renderer->setViewport(0, 0, window->getFramebufferWidth(), window->getFramebufferHeight());
 
@@ -918,38 +1076,31 @@ void Game::loop() {
             )
         );
 
+        uint32_t indexCount = chunkMesh->getDrawIndexCount();
+        if(indexCount == 0) {
+            continue;
+        }
+
         voxelShader.setUniformMat4("u_Model", glm::value_ptr(model));
-        renderer->drawVAO(chunkMesh->getVertexArray());
+        renderer->drawVAO(chunkMesh->getVertexArray(chunkMesh->getDrawLod()), gfx::RenderMode::TRIANGLES, indexCount, 0);
     }
 
-    voxelShader.setUniformInt("u_UseLight", 0);
+    renderer->useShader(voxelInstancedShader);
+    voxelInstancedShader.setUniformMat4("u_Model", glm::value_ptr(glm::translate(glm::mat4(1.0f), toolPreview->getOffset())));
+    voxelInstancedShader.setUniformMat4("u_View", glm::value_ptr(worldCamera->getViewMatrix()));
+    voxelInstancedShader.setUniformMat4("u_Projection", glm::value_ptr(worldCamera->getProjectionMatrix()));
+    voxelInstancedShader.setUniformInt("u_UseLight", 0);
+    voxelInstancedShader.setUniformVec3("u_LightDir", -1.0f, 0.5f, 0.2f);
     if(currentTool == ToolType::TOOL_ERASE) {
-        voxelShader.setUniformInt("u_UseTexture", 0);
-        voxelShader.setUniformVec4("u_ColorTint", 0.6f, 0.2f, 0.2f, 0.5f);
+        voxelInstancedShader.setUniformInt("u_UseTexture", 0);
+        voxelInstancedShader.setUniformVec4("u_ColorTint", 0.6f, 0.2f, 0.2f, 0.5f);
     } else {
-        voxelShader.setUniformInt("u_UseTexture", 1);
-        voxelShader.setUniformVec4("u_ColorTint", 1.0f, 1.0f, 1.0f, 0.7f);
+        voxelInstancedShader.setUniformInt("u_UseTexture", 1);
+        voxelInstancedShader.setUniformVec4("u_ColorTint", 1.0f, 1.0f, 1.0f, 0.7f);
     }
 
     renderer->enablePolygonOffsetFill(-1.0f, -1.0f);
-    for(const auto& [id, chunkMesh] : toolWorldMesh->getChunkMeshes()) {
-        auto chunkPtr = chunkMesh->getChunk();
-        if(chunkPtr->getBlockCount() == 0) {
-            continue;
-        }
-        
-        glm::mat4 model = glm::translate(
-            glm::mat4(1.0f),
-            glm::vec3(
-                chunkPtr->getX() * CHUNK_SIZE,
-                chunkPtr->getY() * CHUNK_SIZE,
-                chunkPtr->getZ() * CHUNK_SIZE
-            )
-        );
-
-        voxelShader.setUniformMat4("u_Model", glm::value_ptr(model));
-        renderer->drawVAO(chunkMesh->getVertexArray());
-    }
+    renderer->drawVAOInstanced(toolPreview->getVertexArray(), toolPreview->getInstanceCount());
     renderer->disablePolygonOffsetFill();
 
     if(showBoundingBox) {
@@ -989,6 +1140,7 @@ void Game::loop() {
     );*/
     //uiRenderer->renderSprite(basic2DShader, *uiBackgroundSprite);
     uiRenderer->renderSprite(basic2DShader, *sprite);
+    uiRenderer->flush();
 
     textRenderer->renderText(textShader, *fpsText);
     textRenderer->renderText(textShader, *cameraText);
@@ -997,9 +1149,12 @@ void Game::loop() {
     textRenderer->renderText(textShader, *brushSizeText);
     textRenderer->renderText(textShader, *currentPaletteText);
     textRenderer->renderText(textShader, *drawCallText);
+    textRenderer->renderText(textShader, *meshMemoryText);
+    textRenderer->renderText(textShader, *meshLodMemoryText);
     textRenderer->renderText(textShader, *currentToolText);
     textRenderer->renderText(textShader, *axisLockText);
     textRenderer->renderText(textShader, *toolShapeText);
+    textRenderer->flush();
 }
 
 void Game::construct_ui() {
@@ -1017,6 +1172,8 @@ void Game::construct_ui() {
 
     fpsText->position = glm::vec3(window->getWidth() - 10.0f, window->getHeight() - 10.0f, 0.0f);
     drawCallText->position = glm::vec3(window->getWidth() - 10.0f, window->getHeight() - 30.0f, 0.0f);
+    meshMemoryText->position = glm::vec3(window->getWidth() - 10.0f, window->getHeight() - 50.0f, 0.0f);
+    meshLodMemoryText->position = glm::vec3(window->getWidth() - 10.0f, window->getHeight() - 70.0f, 0.0f);
 
     brushSizeText->position = glm::vec3(10.0f, 10.0f, 0.0f);
     currentPaletteText->position = glm::vec3(10.0f, 30.0f, 0.0f);
@@ -1078,6 +1235,33 @@ void Game::update_current_tool_text() {
     currentToolText->setContent("Tool: " + toolName);
 };
 
+std::string formatMegabytes(size_t bytes) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.1f", static_cast<double>(bytes) / (1024.0 * 1024.0));
+
+    return buffer;
+}
+
+void Game::update_mesh_memory_text() {
+    const auto& stats = worldMesh->getMemoryStats();
+
+    meshMemoryText->setContent(
+        "Mesh Memory: " + formatMegabytes(stats.totalBytes) +
+        " MB (peak " + formatMegabytes(stats.peakTotalBytes) + " MB)"
+    );
+
+    std::string lodText = "LOD ";
+    for(int lod = 0; lod < CHUNK_LOD_COUNT; ++lod) {
+        if(lod > 0) {
+            lodText += " / ";
+        }
+
+        lodText += formatMegabytes(stats.currentBytes[lod]) + " (" + formatMegabytes(stats.peakBytes[lod]) + ")";
+    }
+
+    meshLodMemoryText->setContent(lodText + " MB");
+}
+
 void Game::update_axis_lock_text() {
     std::string lockName;
     switch(axisLock) {
@@ -1098,6 +1282,92 @@ void Game::update_axis_lock_text() {
     axisLockText->setContent("Axis Lock: " + lockName);
 };
 
+std::optional<WorldRayHit> Game::find_stroke_plane_hit() const {
+    if(mouseRay.direction[strokeAxis] == 0.0f) {
+        return std::nullopt;
+    }
+
+    // through the middle of the layer
+    float t = (strokeCenter[strokeAxis] + 0.5f - mouseRay.origin[strokeAxis]) / mouseRay.direction[strokeAxis];
+    if(t < 0.0f || t > 256.0f) {
+        return std::nullopt;
+    }
+
+    glm::vec3 point = mouseRay.origin + mouseRay.direction * t;
+    glm::ivec3 voxel(
+        static_cast<int>(std::floor(point.x)),
+        static_cast<int>(std::floor(point.y)),
+        static_cast<int>(std::floor(point.z))
+    );
+    voxel[strokeAxis] = strokeCenter[strokeAxis];
+
+    // Place strokes are centered on block + side
+    WorldRayHit hit;
+    hit.block = currentTool == ToolType::TOOL_PLACE ? voxel - strokeSide : voxel;
+    hit.side = strokeSide;
+    hit.distance = t;
+
+    return hit;
+}
+
+void Game::update_tool_preview() {
+    if(!brushHit.has_value()) {
+        toolPreview->clear();
+        moveVoxelsPreviewed = false;
+        return;
+    }
+
+    if(currentTool == ToolType::TOOL_PLACE) {
+        auto voxels = getVoxelsForTool(*world, brushHit->block + brushHit->side, brushSize, toolShape);
+        toolPreview->setVoxels(voxels, blockType + 1);
+    } else if(currentTool == ToolType::TOOL_ERASE) {
+        auto voxels = getVoxelsForTool(*world, brushHit->block, brushSize, toolShape);
+        toolPreview->setVoxels(voxels, 1);
+    } else if(currentTool == ToolType::TOOL_BRUSH) {
+        auto voxels = getVoxelsForTool(*world, brushHit->block, brushSize, toolShape);
+
+        std::vector<glm::ivec3> painted;
+        for(const auto& voxel : voxels) {
+            if(world->getBlock(voxel.x, voxel.y, voxel.z) != 0 && (paintMask.isEmpty() || paintMask.contains(voxel))) {
+                painted.push_back(voxel);
+            }
+        }
+
+        toolPreview->setVoxels(painted, blockType + 1);
+    } else if(currentTool == ToolType::TOOL_LINE) {
+        glm::ivec3 pos = brushHit->block + brushHit->side;
+        if(pos.x < 0 || pos.y < 0 || pos.z < 0) {
+            toolPreview->clear();
+            return;
+        }
+
+        VoxelSelection line;
+        BrushStroke::sweep(line, lineInProgress ? lineStart : pos, pos, brushSize, toolShape);
+
+        toolPreview->setVoxels(line.toVector(), blockType + 1);
+    } else if(currentTool == ToolType::TOOL_MOVE) {
+        auto pos = brushHit->block + brushHit->side;
+        if(moveVoxels.isEmpty() || pos.x < 0 || pos.y < 0 || pos.z < 0) {
+            toolPreview->clear();
+            moveVoxelsPreviewed = false;
+            return;
+        }
+
+        glm::ivec3 delta = pos - moveVoxelsStart;
+        if(delta.y < 0) {
+            delta.y = 0;
+        }
+
+        // the voxels only change when picked up, moving them is a translation
+        if(!moveVoxelsPreviewed) {
+            toolPreview->setVoxels(*world, moveVoxels);
+            moveVoxelsPreviewed = true;
+        }
+
+        toolPreview->setOffset(glm::vec3(delta));
+    }
+}
+
 void Game::set_current_palette_sprite_uvs(int index) {
     const int colorsPerRow = 256;
     const float uvSize = 1.0f / colorsPerRow;
@@ -1138,7 +1408,223 @@ void Game::regenerate_palette() {
     delete[] data;
 };
 
+void Game::autosave_world() {
+    if(worldSaver->isSaving()) {
+        return;
+    }
+
+    if(worldSaver->getJournalSize() >= WORLD_JOURNAL_COMPACT_SIZE) {
+        worldSaver->save(*world, worldSavePath);
+    } else {
+        worldSaver->appendJournal(*world, worldSavePath);
+    }
+}
+
+void Game::undo_edit() {
+    auto start = std::chrono::high_resolution_clock::now();
+    if(!editHistory.undo(*world)) {
+        return;
+    }
+
+    clear_paint_mask();
+
+    double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    std::cout << "Undo in " << milliseconds << " ms, " << editHistory.getUndoCount() << " steps left ("
+              << editHistory.getMemoryUsage() << " bytes of history)" << std::endl;
+
+    toolPreviewDirty = true;
+}
+
+void Game::redo_edit() {
+    if(!editHistory.redo(*world)) {
+        return;
+    }
+
+    clear_paint_mask();
+
+    toolPreviewDirty = true;
+}
+
+void Game::report_components() {
+    auto start = std::chrono::high_resolution_clock::now();
+    auto components = WorldComponents::label(*world, core::ThreadPool::getDefault());
+    double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    std::cout << "Found " << components.getComponentCount() << " connected components in " << milliseconds << " ms" << std::endl;
+
+    // largest first, only the biggest few are worth listing
+    size_t listed = 0;
+    for(const auto& component : components.getComponents()) {
+        if(!component.isFloating()) {
+            continue;
+        }
+
+        if(listed++ == 5) {
+            break;
+        }
+
+        std::cout << "  floating: " << component.voxelCount << " voxels from ("
+                  << component.min.x << ", " << component.min.y << ", " << component.min.z << ") to ("
+                  << component.max.x << ", " << component.max.y << ", " << component.max.z << ")" << std::endl;
+    }
+}
+
+void Game::import_vox() {
+    std::string path = core::FileSystem::getDataPath() + VOX_IMPORT_FILE;
+
+    // the model's corner goes where a block would be placed, or the origin
+    glm::ivec3 origin = brushHit.has_value() ? brushHit->block + brushHit->side : glm::ivec3(0, 0, 0);
+    origin = glm::max(origin, glm::ivec3(0, 0, 0));
+
+    editHistory.begin(*world);
+
+    try {
+        auto start = std::chrono::high_resolution_clock::now();
+        auto result = importVoxFile(*world, path, origin, color_palette);
+        double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+        std::cout << "Imported " << result.voxelCount << " voxels from " << result.modelCount << " models of " << path
+                  << " into " << result.chunkCount << " chunks in " << milliseconds << " ms" << std::endl;
+        if(result.skippedVoxelCount > 0) {
+            std::cout << "Skipped " << result.skippedVoxelCount << " voxels outside of the world." << std::endl;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to import " << path << ": " << e.what() << std::endl;
+    }
+
+    editHistory.commit();
+    clear_paint_mask();
+}
+
+void Game::generate_world() {
+    WorldGeneratorSettings settings;
+    settings.seed = worldGeneratorSeed;
+    WorldGenerator generator(settings);
+
+    editHistory.begin(*world);
+
+    try {
+        auto start = std::chrono::high_resolution_clock::now();
+        size_t chunkCount = generator.generate(*world, glm::ivec3(0, 0, 0), GENERATED_WORLD_CHUNKS - glm::ivec3(1), core::ThreadPool::getDefault());
+        double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+        std::cout << "Generated " << chunkCount << " chunks from seed " << settings.seed << " in " << milliseconds << " ms" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to generate world: " << e.what() << std::endl;
+    }
+
+    editHistory.commit();
+    clear_paint_mask();
+}
+
+void Game::pick_paint_mask() {
+    const glm::ivec3& block = brushHit->block;
+    if(world->getBlock(block.x, block.y, block.z) == 0) {
+        clear_paint_mask();
+        return;
+    }
+
+    VoxelSelection connected = world->selectConnected(block);
+    if(isKeyHeld[SDL_SCANCODE_LSHIFT]) {
+        paintMask.unite(connected);
+    } else {
+        paintMask = std::move(connected);
+    }
+
+    std::cout << "Paint mask: " << paintMask.getCount() << " voxels" << std::endl;
+}
+
+// the mask selects voxels as they were, after bulk edits it would select arbitrary ones
+void Game::clear_paint_mask() {
+    if(paintMask.isEmpty()) {
+        return;
+    }
+
+    paintMask.clear();
+    std::cout << "Paint mask cleared" << std::endl;
+    toolPreviewDirty = true;
+}
+
+void Game::paint_mask() {
+    if(paintMask.isEmpty()) {
+        return;
+    }
+
+    editHistory.begin(*world);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    size_t painted = world->fillSelection(paintMask, blockType + 1, true);
+    double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    editHistory.commit();
+
+    std::cout << "Painted " << painted << " voxels in " << milliseconds << " ms" << std::endl;
+    toolPreviewDirty = true;
+}
+
+void Game::stamp_shape(bool carve) {
+    if(!brushHit.has_value()) {
+        return;
+    }
+
+    int size = std::max(brushSize, 1) * SHAPE_STAMP_SCALE;
+    glm::vec3 center = glm::vec3(carve ? brushHit->block : brushHit->block + brushHit->side * size);
+
+    VoxelShape shape = BrushStroke::getShape(center, size, toolShape);
+    if(!carve) {
+        shape = shape.subtract(BrushStroke::getShape(center, size - SHAPE_STAMP_WALL, toolShape));
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    VoxelSelection selection = shape.select(&core::ThreadPool::getDefault());
+
+    editHistory.begin(*world);
+    size_t changed = world->fillSelection(selection, carve ? 0 : blockType + 1);
+    editHistory.commit();
+
+    clear_paint_mask();
+
+    double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    std::cout << (carve ? "Carved " : "Stamped ") << get_tool_shape_name(toolShape) << ", " << changed << " voxels in " << milliseconds << " ms" << std::endl;
+    toolPreviewDirty = true;
+}
+
+void Game::save_clipboard() {
+    std::string path = core::FileSystem::getDataPath() + CLIPBOARD_FILE;
+
+    try {
+        clipboard.saveToFile(path);
+        std::cout << "Saved " << clipboard.getVoxelCount() << " clipboard voxels to " << path << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to save clipboard: " << e.what() << std::endl;
+    }
+}
+
+void Game::load_clipboard() {
+    std::string path = core::FileSystem::getDataPath() + CLIPBOARD_FILE;
+
+    try {
+        clipboard = VoxelClipboard::loadFromFile(path);
+        std::cout << "Loaded " << clipboard.getVoxelCount() << " clipboard voxels from " << path << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to load clipboard: " << e.what() << std::endl;
+    }
+}
+
+void Game::export_vox() {
+    std::string path = core::FileSystem::getDataPath() + VOX_EXPORT_FILE;
+
+    try {
+        size_t voxelCount = exportVoxFile(*world, path, color_palette);
+        std::cout << "Exported " << voxelCount << " voxels to " << path << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to export " << path << ": " << e.what() << std::endl;
+    }
+}
+
 void Game::shutdown() {
-    auto worldAsset = World::saveToAsset(*world);
-    worldAsset.saveToFile("arrow.dat");
+    worldSaver->wait();
+    worldSaver->save(*world, worldSavePath);
+    worldSaver->wait();
 }
\ No newline at end of file
@@ -3,12 +3,21 @@
 #include <SDL3/SDL_main.h>
 
 #include "game.hpp"
+#include "benchmarks.hpp"
 
 struct AppState {
     Game* game;
 };
 
 SDL_AppResult SDL_AppInit(void** appstate, int argc, char** argv) {
+    // benchmarks run headless and exit before any window is created
+    for (int i = 1; i < argc; ++i) {
+        int exitCode = 0;
+        if (runBenchmark(argv[i], exitCode)) {
+            return exitCode == 0 ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+        }
+    }
+
     if (!SDL_Init(SDL_INIT_VIDEO)){
         return SDL_APP_FAILURE;
     }
@@ -48,8 +57,12 @@ SDL_AppResult SDL_AppEvent(void* appstate, SDL_Event* event) {
 void SDL_AppQuit(void* appstate, SDL_AppResult result) {
     AppState* state = static_cast<AppState*>(appstate);
 
-    state->game->shutdown();
-    delete state->game;
+    // no game was created when a benchmark ran instead
+    if (state) {
+        state->game->shutdown();
+        delete state->game;
+        delete state;
+    }
 
     SDL_Quit();
 }
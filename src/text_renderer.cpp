@@ -2,160 +2,220 @@
 
 #include "engine/core/core.hpp"
 
-void computeTextDimensions(const Text& text, float& outWidth, float& outHeight) {
-    auto& content = text.getContent();
-    auto font = text.getFont();
-    auto fontSize = text.getFontSize();
+#include <cmath>
 
-    float width = 0.0f;
+// once the cache grows past this, layouts not used since the last flush are dropped
+const size_t MAX_CACHED_LAYOUTS = 256;
+
+void TextRenderer::buildLayout(const std::string& content, const assets::Font::FontPage& fontPage, TextLayout& outLayout) {
+    auto& vertices = outLayout.vertices;
+    vertices.clear();
+    vertices.reserve(content.size() * 4);
+
+    float x = 0.0f;
+    float y = 0.0f;
     float height = 0.0f;
 
-    auto& fontPage = font->getPage(fontSize);
+    for(char c : content) {
+        auto character = fontPage.getGlyph(c);
+        if(!character) {
+            continue;
+        }
+
+        float xpos = x + character->bearing_x;
+        float ypos = y - (character->height - character->bearing_y);
+
+        float w = character->width;
+        float h = character->height;
+
+        float uv_x = static_cast<float>(character->offset_x) / fontPage.width;
+        float uv_y = static_cast<float>(fontPage.height - character->offset_y - character->height) / fontPage.height;
+        float uv_w = static_cast<float>(character->width) / fontPage.width;
+        float uv_h = static_cast<float>(character->height) / fontPage.height;
 
-    for(int i = 0; i < content.size(); ++i) {
-        char c = content[i];
-        auto& character = fontPage.glyphs.at(c);
+        vertices.push_back({ glm::vec2(xpos, ypos), glm::vec2(uv_x, uv_y) });
+        vertices.push_back({ glm::vec2(xpos + w, ypos), glm::vec2(uv_x + uv_w, uv_y) });
+        vertices.push_back({ glm::vec2(xpos + w, ypos + h), glm::vec2(uv_x + uv_w, uv_y + uv_h) });
+        vertices.push_back({ glm::vec2(xpos, ypos + h), glm::vec2(uv_x, uv_y + uv_h) });
 
-        width += (float)character.advance_x;
-        height = std::max(height, (float)character.height);
+        x += (float)character->advance_x;
+        y += (float)character->advance_y;
+
+        height = std::max(height, h);
     }
 
-    outWidth = width;
-    outHeight = height;
+    outLayout.size = glm::vec2(x, height);
 }
 
-void updateTextVao(gfx::VertexArray& vao, Text& text) {
-    auto& content = text.getContent();
-    auto font = text.getFont();
-    auto fontSize = text.getFontSize();
+unique<gfx::VertexArray> createTextBatchVAO() {
+    auto vao = std::make_unique<gfx::VertexArray>();
 
-    const int numVertices = content.size() * 4;
-    int numIndices = content.size() * 6;
+    auto vertexBuffer = std::make_unique<gfx::VertexBuffer>(gfx::BufferLayout({
+        { gfx::BufferDataType::FLOAT2 }, // position
+        { gfx::BufferDataType::FLOAT2 }  // texcoord
+    }), gfx::BufferUsage::STREAM);
+    auto indexBuffer = std::make_unique<gfx::IndexBuffer>();
 
-    auto vertexBuffer = vao.getVertexBuffer().get();
-    auto indexBuffer = vao.getIndexBuffer().get();
+    vao->setVertexBuffer(std::move(vertexBuffer));
+    vao->setIndexBuffer(std::move(indexBuffer));
 
-    float* vertices = new float[numVertices * 4]; // 4 floats per vertex (x, y, u, v)
-    unsigned int* indices = new unsigned int[numIndices];
+    return vao;
+}
 
-    auto& fontPage = font->getPage(fontSize);
+TextRenderer::TextRenderer(gfx::Renderer& renderer, const Camera& camera)
+    : _renderer(renderer), _camera(camera) {
+    _batchVAO = createTextBatchVAO();
+    reserveIndices(512);
+}
 
-    float x = 0.0f;
-    float y = 0.0f;
-    int vertexOffset = 0;
-    int indexOffset = 0;
+const gfx::Texture& TextRenderer::getPageTexture(const assets::Font::FontPage& page) {
+    auto it = _fontPageTextures.find(&page);
+    if(it != _fontPageTextures.end()) {
+        return *it->second;
+    }
+
+    auto texture = std::make_unique<gfx::Texture>(page.atlas, page.width, page.height, 1);
+    if(!texture) {
+        throw std::runtime_error("Failed to create font page texture.");
+    }
+
+    auto& result = *texture;
+    _fontPageTextures[&page] = std::move(texture);
 
-    for(int i = 0; i < content.size(); ++i) {
-        char c = content[i];
-        auto& character = fontPage.glyphs.at(c);
+    return result;
+}
+
+const TextRenderer::TextLayout& TextRenderer::getLayout(Text& text) {
+    auto textIt = _textLayouts.find(&text);
+    if(!text._dirty && textIt != _textLayouts.end()) {
+        textIt->second->lastUsedFrame = _frame;
+        return *textIt->second;
+    }
 
-        float xpos = x + character.bearing_x;
-        float ypos = y - (character.height - character.bearing_y);
+    TextLayoutKey key { text.getContent(), text.getFont().get(), text.getFontSize() };
 
-        float w = character.width;
-        float h = character.height;
+    auto it = _layouts.find(key);
+    if(it == _layouts.end()) {
+        auto& page = text.getFont()->getPage(text.getFontSize());
 
-        float uv_x = static_cast<float>(character.offset_x) / fontPage.width;
-        float uv_y = static_cast<float>(fontPage.height - character.offset_y - character.height) / fontPage.height;
-        float uv_w = static_cast<float>(character.width) / fontPage.width;
-        float uv_h = static_cast<float>(character.height) / fontPage.height;
+        TextLayout layout;
+        buildLayout(text.getContent(), page, layout);
+        layout.texture = &getPageTexture(page);
 
-        vertices[vertexOffset + 0] = xpos;
-        vertices[vertexOffset + 1] = ypos;
-        vertices[vertexOffset + 2] = uv_x;
-        vertices[vertexOffset + 3] = uv_y;
+        it = _layouts.emplace(std::move(key), std::move(layout)).first;
+    }
 
-        vertices[vertexOffset + 4] = xpos + w;
-        vertices[vertexOffset + 5] = ypos;
-        vertices[vertexOffset + 6] = uv_x + uv_w;
-        vertices[vertexOffset + 7] = uv_y;
+    it->second.lastUsedFrame = _frame;
 
-        vertices[vertexOffset + 8] = xpos + w;
-        vertices[vertexOffset + 9] = ypos + h;
-        vertices[vertexOffset + 10] = uv_x + uv_w;
-        vertices[vertexOffset + 11] = uv_y + uv_h;
+    _textLayouts[&text] = &it->second;
+    text.size = it->second.size;
+    text._dirty = false;
 
-        vertices[vertexOffset + 12] = xpos;
-        vertices[vertexOffset + 13] = ypos + h;
-        vertices[vertexOffset + 14] = uv_x;
-        vertices[vertexOffset + 15] = uv_y + uv_h;
+    return it->second;
+}
 
-        indices[indexOffset + 0] = i * 4 + 0;
-        indices[indexOffset + 1] = i * 4 + 1;
-        indices[indexOffset + 2] = i * 4 + 2;
-        indices[indexOffset + 3] = i * 4 + 2;
-        indices[indexOffset + 4] = i * 4 + 3;
-        indices[indexOffset + 5] = i * 4 + 0;
+void TextRenderer::renderText(gfx::Shader& shader, Text& text) {
+    if(_batchShader != &shader) {
+        flush();
+        _batchShader = &shader;
+    }
 
-        x += (float)character.advance_x;
-        y += (float)character.advance_y;
+    const auto& layout = getLayout(text);
+    if(layout.vertices.empty()) {
+        return;
+    }
 
-        vertexOffset += 16;
-        indexOffset += 6;
+    TextBatch* batch = nullptr;
+    for(auto& candidate : _batches) {
+        if(candidate.texture == layout.texture) {
+            batch = &candidate;
+            break;
+        }
     }
 
-    float width, height;
-    computeTextDimensions(text, width, height);
+    if(!batch) {
+        _batches.push_back({ layout.texture, {} });
+        batch = &_batches.back();
+    }
 
-    text.size = glm::vec2(width, height);
+    auto correctedPosition = text.position - (text.anchor * text.size);
+    float radians = glm::radians(text.rotation);
+    float cosAngle = std::cos(radians);
+    float sinAngle = std::sin(radians);
 
-    vertexBuffer->setData(vertices, numVertices * 4 * sizeof(float));
-    indexBuffer->setData(indices, numIndices * sizeof(unsigned int));
+    for(const auto& vertex : layout.vertices) {
+        glm::vec2 rotated(
+            vertex.position.x * cosAngle - vertex.position.y * sinAngle,
+            vertex.position.x * sinAngle + vertex.position.y * cosAngle
+        );
 
-    delete[] vertices;
-    delete[] indices;
+        batch->vertices.push_back({ correctedPosition + rotated, vertex.uv });
+    }
 }
 
-unique<gfx::VertexArray> createTextVAO(const Text& text) {
-    auto vao = std::make_unique<gfx::VertexArray>();
-    
-    auto vertexBuffer = std::make_unique<gfx::VertexBuffer>(gfx::BufferLayout({
-        { gfx::BufferDataType::FLOAT2 }, // position
-        { gfx::BufferDataType::FLOAT2 }  // texcoord
-    }));
-    auto indexBuffer = std::make_unique<gfx::IndexBuffer>();
+void TextRenderer::reserveIndices(uint32_t quadCount) {
+    if(quadCount <= _indexCapacity) {
+        return;
+    }
 
-    vao->setVertexBuffer(std::move(vertexBuffer));
-    vao->setIndexBuffer(std::move(indexBuffer));
+    uint32_t capacity = std::max(quadCount, _indexCapacity * 2);
+    std::vector<unsigned int> indices(capacity * 6);
 
-    return vao;
+    for(uint32_t i = 0; i < capacity; ++i) {
+        indices[i * 6 + 0] = i * 4 + 0;
+        indices[i * 6 + 1] = i * 4 + 1;
+        indices[i * 6 + 2] = i * 4 + 2;
+        indices[i * 6 + 3] = i * 4 + 2;
+        indices[i * 6 + 4] = i * 4 + 3;
+        indices[i * 6 + 5] = i * 4 + 0;
+    }
+
+    _batchVAO->getIndexBuffer()->setData(indices.data(), static_cast<uint32_t>(indices.size() * sizeof(unsigned int)));
+    _indexCapacity = capacity;
 }
 
-void TextRenderer::renderText(gfx::Shader& shader, Text& text) {
-    if(_textVaos.find(&text) == _textVaos.end()) {
-        _textVaos[&text] = createTextVAO(text);
-        updateTextVao(*_textVaos[&text], text);
+void TextRenderer::flush() {
+    _frame++;
 
-        text._dirty = false;
-    }
+    if(_layouts.size() > MAX_CACHED_LAYOUTS) {
+        _textLayouts.clear();
 
-    auto page = text.getFont()->getPage(text.getFontSize());
-    auto it = _fontPageTextures.find(&page);
-    if(it == _fontPageTextures.end()) {
-        auto texture = std::make_unique<gfx::Texture>(page.atlas, page.width, page.height, 1);
-        if(!texture) {
-            throw std::runtime_error("Failed to create font page texture.");
+        for(auto it = _layouts.begin(); it != _layouts.end(); ) {
+            if(it->second.lastUsedFrame + 1 < _frame) {
+                it = _layouts.erase(it);
+            } else {
+                ++it;
+            }
         }
+    }
 
-        _fontPageTextures[&page] = std::move(texture);
+    if(_batches.empty() || !_batchShader) {
+        _batches.clear();
+        return;
     }
 
-    if(text._dirty) {
-        updateTextVao(*_textVaos[&text], text);
-        text._dirty = false;
+    _vertices.clear();
+    for(const auto& batch : _batches) {
+        _vertices.insert(_vertices.end(), batch.vertices.begin(), batch.vertices.end());
     }
 
-    auto correctedPosition = text.position - (text.anchor * text.size);
-    auto model = glm::translate(glm::mat4(1.0f), glm::vec3(correctedPosition, 0.0f)) *
-                 glm::rotate(glm::mat4(1.0f), glm::radians(text.rotation), glm::vec3(0.0f, 0.0f, 1.0f)) *
-                 glm::scale(glm::mat4(1.0f), glm::vec3(1.0f, 1.0f, 1.0f));
+    reserveIndices(static_cast<uint32_t>(_vertices.size() / 4));
+    _batchVAO->getVertexBuffer()->setData(_vertices.data(), static_cast<uint32_t>(_vertices.size() * sizeof(TextVertex)));
+
+    _renderer.useShader(*_batchShader);
+    _batchShader->setUniformMat4("u_Projection", glm::value_ptr(_camera.getProjectionMatrix()));
+    _batchShader->setUniformMat4("u_View", glm::value_ptr(_camera.getViewMatrix()));
+    _batchShader->setUniformMat4("u_Model", glm::value_ptr(glm::mat4(1.0f)));
 
-    _renderer.useShader(shader);
-    _renderer.bindTexture(0, *_fontPageTextures[&page]);
+    uint32_t quadOffset = 0;
+    for(const auto& batch : _batches) {
+        uint32_t quadCount = static_cast<uint32_t>(batch.vertices.size() / 4);
 
-    shader.setUniformMat4("u_Projection", glm::value_ptr(_camera.getProjectionMatrix()));
-    shader.setUniformMat4("u_View", glm::value_ptr(_camera.getViewMatrix()));
-    shader.setUniformMat4("u_Model", glm::value_ptr(model));
+        _renderer.bindTexture(0, *batch.texture);
+        _renderer.drawVAO(*_batchVAO, gfx::RenderMode::TRIANGLES, quadCount * 6, quadOffset * 6);
 
-    _renderer.drawVAO(*_textVaos[&text], gfx::RenderMode::TRIANGLES);
-}
\ No newline at end of file
+        quadOffset += quadCount;
+    }
+
+    _batches.clear();
+}
@@ -0,0 +1,163 @@
+#include "tool_preview.hpp"
+#include "chunk_mesh.hpp"
+#include "world.hpp"
+
+ToolPreview::ToolPreview() {
+    float vertices[6 * 4 * 7];
+    unsigned int indices[6 * 6];
+
+    unsigned int vertex_count = 0;
+    unsigned int index_count = 0;
+
+    // the texture slot carries the face index, the shader uses it to test the instance face mask
+    for (int face = 0; face < 6; ++face) {
+        emitFace(vertices, indices, vertex_count, index_count, face, static_cast<float>(face), 0.0f, 0.0f, 0.0f);
+    }
+
+    auto vbo = std::make_unique<gfx::VertexBuffer>(
+        gfx::BufferLayout({
+            { gfx::BufferDataType::FLOAT3 },
+            { gfx::BufferDataType::FLOAT },
+            { gfx::BufferDataType::FLOAT3 }
+        })
+    );
+    vbo->setData(vertices, vertex_count * 7 * sizeof(float));
+
+    auto ibo = std::make_unique<gfx::IndexBuffer>();
+    ibo->setData(indices, index_count * sizeof(unsigned int));
+
+    auto instanceBuffer = std::make_unique<gfx::VertexBuffer>(
+        gfx::BufferLayout({
+            { gfx::BufferDataType::FLOAT3 }, // position
+            { gfx::BufferDataType::FLOAT },  // texture id
+            { gfx::BufferDataType::FLOAT }   // visible face mask
+        }),
+        gfx::BufferUsage::DYNAMIC
+    );
+
+    _vao = std::make_unique<gfx::VertexArray>();
+    _vao->setVertexBuffer(std::move(vbo));
+    _vao->setIndexBuffer(std::move(ibo));
+    _vao->setInstanceBuffer(std::move(instanceBuffer));
+}
+
+void ToolPreview::setVoxels(const std::vector<glm::ivec3>& voxels, unsigned char blockId) {
+    _instances.clear();
+    _offset = glm::vec3(0.0f);
+    _instances.reserve(voxels.size());
+
+    for(const auto& voxel : voxels) {
+        if(voxel.x < 0 || voxel.y < 0 || voxel.z < 0) {
+            continue;
+        }
+
+        _instances.push_back({ glm::vec3(voxel), static_cast<float>(blockId - 1), 0.0f });
+    }
+
+    upload();
+}
+
+void ToolPreview::setVoxels(const std::vector<glm::ivec3>& voxels, const std::vector<unsigned char>& blockIds) {
+    _instances.clear();
+    _offset = glm::vec3(0.0f);
+    _instances.reserve(voxels.size());
+
+    for(size_t i = 0; i < voxels.size(); ++i) {
+        const auto& voxel = voxels[i];
+        if(blockIds[i] == 0 || voxel.x < 0 || voxel.y < 0 || voxel.z < 0) {
+            continue;
+        }
+
+        _instances.push_back({ glm::vec3(voxel), static_cast<float>(blockIds[i] - 1), 0.0f });
+    }
+
+    upload();
+}
+
+void ToolPreview::setVoxels(const World& world, const VoxelSelection& selection) {
+    _instances.clear();
+    _instances.reserve(selection.getCount());
+    _offset = glm::vec3(0.0f);
+
+    selection.forEachChunk([&](const glm::ivec3& coords, const SelectionBits& bits) {
+        const Chunk* chunk = world.getChunk(coords.x, coords.y, coords.z);
+        if(!chunk) {
+            return;
+        }
+
+        const auto& blocks = chunk->getBlocks();
+        glm::ivec3 base = coords * CHUNK_SIZE;
+
+        for(int word = 0; word < SELECTION_CHUNK_WORDS; ++word) {
+            for(uint64_t selected = bits[word]; selected != 0; selected &= selected - 1) {
+                int index = word * 64 + countTrailingZeros(selected);
+                unsigned char block = blocks[index];
+                if(block == 0) {
+                    continue;
+                }
+
+                glm::ivec3 local(index % CHUNK_SIZE, (index / CHUNK_SIZE) % CHUNK_SIZE, index / (CHUNK_SIZE * CHUNK_SIZE));
+                int mask = 0;
+
+                for(int face = 0; face < 6; ++face) {
+                    glm::ivec3 neighbor = local + FACE_DIRECTIONS[face];
+
+                    bool inside = neighbor.x >= 0 && neighbor.y >= 0 && neighbor.z >= 0
+                        && neighbor.x < CHUNK_SIZE && neighbor.y < CHUNK_SIZE && neighbor.z < CHUNK_SIZE;
+
+                    bool occupied;
+                    if(inside) {
+                        int neighborIndex = neighbor.z * CHUNK_SIZE * CHUNK_SIZE + neighbor.y * CHUNK_SIZE + neighbor.x;
+                        occupied = ((bits[neighborIndex / 64] >> (neighborIndex % 64)) & 1) && blocks[neighborIndex] != 0;
+                    } else {
+                        glm::ivec3 voxel = base + neighbor;
+                        occupied = selection.contains(voxel) && world.getBlock(voxel.x, voxel.y, voxel.z) != 0;
+                    }
+
+                    if(!occupied) {
+                        mask |= 1 << face;
+                    }
+                }
+
+                _instances.push_back({ glm::vec3(base + local), static_cast<float>(block - 1), static_cast<float>(mask) });
+            }
+        }
+    });
+
+    _instanceCount = static_cast<uint32_t>(_instances.size());
+    if(_instanceCount > 0) {
+        _vao->getInstanceBuffer()->setData(_instances.data(), _instanceCount * sizeof(Instance));
+    }
+}
+
+void ToolPreview::clear() {
+    _instances.clear();
+    _instanceCount = 0;
+    _offset = glm::vec3(0.0f);
+}
+
+void ToolPreview::upload() {
+    // instances are at non-negative coordinates, setVoxels drops the others
+    VoxelSelection occupied;
+    for(const auto& instance : _instances) {
+        occupied.add(glm::ivec3(instance.position));
+    }
+
+    for(auto& instance : _instances) {
+        glm::ivec3 voxel(instance.position);
+        int mask = 0;
+
+        for(int face = 0; face < 6; ++face) {
+            if(!occupied.contains(voxel + FACE_DIRECTIONS[face])) {
+                mask |= 1 << face;
+            }
+        }
+
+        instance.faceMask = static_cast<float>(mask);
+    }
+
+    _instanceCount = static_cast<uint32_t>(_instances.size());
+    if(_instanceCount > 0) {
+        _vao->getInstanceBuffer()->setData(_instances.data(), _instanceCount * sizeof(Instance));
+    }
+}
@@ -0,0 +1,748 @@
+#include "vox_format.hpp"
+#include "engine/core/binary.hpp"
+#include "engine/core/mapped_file.hpp"
+
+#include <climits>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <tuple>
+#include <unordered_map>
+
+static constexpr uint32_t getVoxChunkId(const char* id) {
+    return static_cast<uint32_t>(id[0]) | (static_cast<uint32_t>(id[1]) << 8) |
+           (static_cast<uint32_t>(id[2]) << 16) | (static_cast<uint32_t>(id[3]) << 24);
+}
+
+const uint32_t VOX_CHUNK_MAIN = getVoxChunkId("MAIN");
+const uint32_t VOX_CHUNK_SIZE = getVoxChunkId("SIZE");
+const uint32_t VOX_CHUNK_XYZI = getVoxChunkId("XYZI");
+const uint32_t VOX_CHUNK_RGBA = getVoxChunkId("RGBA");
+const uint32_t VOX_CHUNK_TRANSFORM = getVoxChunkId("nTRN");
+const uint32_t VOX_CHUNK_GROUP = getVoxChunkId("nGRP");
+const uint32_t VOX_CHUNK_SHAPE = getVoxChunkId("nSHP");
+
+// scene graphs nested deeper than this are treated as cyclic
+const int VOX_MAX_SCENE_DEPTH = 64;
+// palette entry written for color indices without a block color
+const uint32_t VOX_UNUSED_COLOR = 0xFF808080;
+
+// Rotation and translation of a scene graph node, in file coordinates. The
+// rotation is a signed permutation, so boxes stay axis aligned.
+struct VoxTransform {
+    glm::ivec3 rows[3] = { glm::ivec3(1, 0, 0), glm::ivec3(0, 1, 0), glm::ivec3(0, 0, 1) };
+    glm::ivec3 translation = glm::ivec3(0);
+
+    glm::ivec3 apply(const glm::ivec3& v) const {
+        return glm::ivec3(
+            rows[0].x * v.x + rows[0].y * v.y + rows[0].z * v.z,
+            rows[1].x * v.x + rows[1].y * v.y + rows[1].z * v.z,
+            rows[2].x * v.x + rows[2].y * v.y + rows[2].z * v.z
+        ) + translation;
+    }
+};
+
+enum class VoxNodeType {
+    TRANSFORM,
+    GROUP,
+    SHAPE
+};
+
+struct VoxNode {
+    VoxNodeType type;
+    VoxTransform transform;
+    // child nodes, or model ids for shapes
+    std::vector<int> children;
+};
+
+struct VoxModel {
+    glm::ivec3 size;
+    // x, y, z and color index per voxel, pointing into the file
+    const char* voxels;
+    uint32_t voxelCount;
+};
+
+struct VoxScene {
+    std::vector<VoxModel> models;
+    std::unordered_map<int, VoxNode> nodes;
+
+    std::array<uint32_t, 256> colors = {};
+    bool hasPalette = false;
+};
+
+struct VoxPlacement {
+    const VoxModel* model;
+    VoxTransform transform;
+    // models placed by the scene graph are positioned by their center
+    bool centered;
+};
+
+// MagicaVoxel is z up, the world is y up
+static glm::ivec3 voxToWorld(const glm::ivec3& p) {
+    return glm::ivec3(p.x, p.z, -p.y - 1);
+}
+
+static glm::ivec3 worldToVox(const glm::ivec3& p) {
+    return glm::ivec3(p.x, -p.z - 1, p.y);
+}
+
+static int floorDiv(int value, int divisor) {
+    return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+}
+
+static VoxTransform combineVoxTransforms(const VoxTransform& parent, const VoxTransform& child) {
+    VoxTransform result;
+
+    for(int row = 0; row < 3; ++row) {
+        for(int column = 0; column < 3; ++column) {
+            result.rows[row][column] =
+                parent.rows[row].x * child.rows[0][column] +
+                parent.rows[row].y * child.rows[1][column] +
+                parent.rows[row].z * child.rows[2][column];
+        }
+    }
+
+    result.translation = parent.apply(child.translation);
+
+    return result;
+}
+
+// bits 0-1 and 2-3 are the columns of the non-zero entries of the first two
+// rows, bits 4-6 make the entries of the three rows negative
+static void decodeVoxRotation(int bits, VoxTransform& transform) {
+    int first = bits & 3;
+    int second = (bits >> 2) & 3;
+    if(first > 2 || second > 2 || first == second) {
+        throw std::runtime_error("Corrupt .vox file: invalid rotation.");
+    }
+
+    int columns[3] = { first, second, 3 - first - second };
+    for(int row = 0; row < 3; ++row) {
+        transform.rows[row] = glm::ivec3(0);
+        transform.rows[row][columns[row]] = (bits >> (4 + row)) & 1 ? -1 : 1;
+    }
+}
+
+static std::unordered_map<std::string, std::string> readVoxDict(core::BinaryReader& reader) {
+    uint32_t count = reader.read<uint32_t>();
+
+    // every entry takes at least two length prefixes
+    if(count > reader.getRemaining() / 8) {
+        throw std::runtime_error("Corrupt .vox file: dictionary larger than its chunk.");
+    }
+
+    std::unordered_map<std::string, std::string> dict;
+    for(uint32_t i = 0; i < count; ++i) {
+        std::string key = reader.readString();
+        dict[key] = reader.readString();
+    }
+
+    return dict;
+}
+
+static void readVoxNode(uint32_t id, core::BinaryReader& reader, VoxScene& scene) {
+    int nodeId = reader.read<int32_t>();
+    readVoxDict(reader);
+
+    VoxNode node;
+
+    if(id == VOX_CHUNK_TRANSFORM) {
+        node.type = VoxNodeType::TRANSFORM;
+        node.children.push_back(reader.read<int32_t>());
+
+        reader.read<int32_t>(); // reserved
+        reader.read<int32_t>(); // layer
+
+        uint32_t frameCount = reader.read<uint32_t>();
+        for(uint32_t frame = 0; frame < frameCount; ++frame) {
+            auto attributes = readVoxDict(reader);
+            if(frame != 0) {
+                continue;
+            }
+
+            auto translation = attributes.find("_t");
+            if(translation != attributes.end()) {
+                std::istringstream stream(translation->second);
+                stream >> node.transform.translation.x >> node.transform.translation.y >> node.transform.translation.z;
+            }
+
+            auto rotation = attributes.find("_r");
+            if(rotation != attributes.end()) {
+                decodeVoxRotation(std::stoi(rotation->second), node.transform);
+            }
+        }
+    } else if(id == VOX_CHUNK_GROUP) {
+        node.type = VoxNodeType::GROUP;
+
+        uint32_t childCount = reader.read<uint32_t>();
+        if(childCount > reader.getRemaining() / 4) {
+            throw std::runtime_error("Corrupt .vox file: group larger than its chunk.");
+        }
+
+        for(uint32_t i = 0; i < childCount; ++i) {
+            node.children.push_back(reader.read<int32_t>());
+        }
+    } else {
+        node.type = VoxNodeType::SHAPE;
+
+        uint32_t modelCount = reader.read<uint32_t>();
+        for(uint32_t i = 0; i < modelCount; ++i) {
+            node.children.push_back(reader.read<int32_t>());
+            readVoxDict(reader);
+        }
+    }
+
+    scene.nodes[nodeId] = std::move(node);
+}
+
+// Walks the chunks of the file once. Voxel data is not copied, models point
+// into data, which has to outlive the scene.
+static VoxScene parseVox(const char* data, size_t size) {
+    core::BinaryReader reader(data, size);
+
+    if(reader.read<uint32_t>() != VOX_MAGIC) {
+        throw std::runtime_error("Not a .vox file: invalid magic.");
+    }
+
+    // 150 and 200 share the chunk layout, 200 adds the scene graph
+    reader.read<uint32_t>();
+
+    if(reader.read<uint32_t>() != VOX_CHUNK_MAIN) {
+        throw std::runtime_error("Corrupt .vox file: missing MAIN chunk.");
+    }
+
+    uint32_t mainContentSize = reader.read<uint32_t>();
+    uint32_t mainChildrenSize = reader.read<uint32_t>();
+    reader.skip(mainContentSize);
+
+    core::BinaryReader children(reader.skip(mainChildrenSize), mainChildrenSize);
+
+    VoxScene scene;
+    std::optional<glm::ivec3> modelSize;
+
+    while(children.getRemaining() > 0) {
+        uint32_t id = children.read<uint32_t>();
+        uint32_t contentSize = children.read<uint32_t>();
+        uint32_t childrenSize = children.read<uint32_t>();
+
+        core::BinaryReader content(children.skip(contentSize), contentSize);
+        children.skip(childrenSize);
+
+        if(id == VOX_CHUNK_SIZE) {
+            glm::ivec3 size;
+            size.x = content.read<int32_t>();
+            size.y = content.read<int32_t>();
+            size.z = content.read<int32_t>();
+
+            if(size.x < 1 || size.y < 1 || size.z < 1 || size.x > VOX_MAX_MODEL_SIZE || size.y > VOX_MAX_MODEL_SIZE || size.z > VOX_MAX_MODEL_SIZE) {
+                throw std::runtime_error("Corrupt .vox file: invalid model size.");
+            }
+
+            modelSize = size;
+        } else if(id == VOX_CHUNK_XYZI) {
+            if(!modelSize.has_value()) {
+                throw std::runtime_error("Corrupt .vox file: voxels without a model size.");
+            }
+
+            VoxModel model;
+            model.size = *modelSize;
+            model.voxelCount = content.read<uint32_t>();
+            model.voxels = content.skip(static_cast<size_t>(model.voxelCount) * 4);
+
+            scene.models.push_back(model);
+            modelSize.reset();
+        } else if(id == VOX_CHUNK_RGBA) {
+            // entry i is the color of index i + 1, the last entry is unused
+            for(int i = 0; i < 255; ++i) {
+                scene.colors[i + 1] = content.read<uint32_t>();
+            }
+
+            scene.hasPalette = true;
+        } else if(id == VOX_CHUNK_TRANSFORM || id == VOX_CHUNK_GROUP || id == VOX_CHUNK_SHAPE) {
+            readVoxNode(id, content, scene);
+        }
+    }
+
+    return scene;
+}
+
+static void collectVoxPlacements(const VoxScene& scene, int nodeId, const VoxTransform& parent, int depth, std::vector<VoxPlacement>& placements) {
+    if(depth > VOX_MAX_SCENE_DEPTH) {
+        throw std::runtime_error("Corrupt .vox file: scene graph too deep.");
+    }
+
+    auto it = scene.nodes.find(nodeId);
+    if(it == scene.nodes.end()) {
+        throw std::runtime_error("Corrupt .vox file: missing scene node " + std::to_string(nodeId) + ".");
+    }
+
+    const VoxNode& node = it->second;
+
+    if(node.type == VoxNodeType::SHAPE) {
+        for(int modelId : node.children) {
+            if(modelId < 0 || modelId >= static_cast<int>(scene.models.size())) {
+                throw std::runtime_error("Corrupt .vox file: shape references missing model " + std::to_string(modelId) + ".");
+            }
+
+            placements.push_back({ &scene.models[modelId], parent, true });
+        }
+
+        return;
+    }
+
+    VoxTransform transform = node.type == VoxNodeType::TRANSFORM ? combineVoxTransforms(parent, node.transform) : parent;
+    for(int child : node.children) {
+        collectVoxPlacements(scene, child, transform, depth + 1, placements);
+    }
+}
+
+static glm::ivec3 placeVoxel(const VoxPlacement& placement, const glm::ivec3& voxel) {
+    glm::ivec3 offset = placement.centered ? placement.model->size / 2 : glm::ivec3(0);
+    return voxToWorld(placement.transform.apply(voxel - offset));
+}
+
+std::array<unsigned char, 256> createVoxPaletteMap(const std::array<uint32_t, 256>& voxColors, const std::vector<glm::vec4>& blockColors) {
+    std::array<unsigned char, 256> map = {};
+    if(blockColors.empty()) {
+        return map;
+    }
+
+    for(int i = 1; i < 256; ++i) {
+        glm::vec3 color(
+            static_cast<float>(voxColors[i] & 0xFF) / 255.0f,
+            static_cast<float>((voxColors[i] >> 8) & 0xFF) / 255.0f,
+            static_cast<float>((voxColors[i] >> 16) & 0xFF) / 255.0f
+        );
+
+        float bestDistance = std::numeric_limits<float>::max();
+        for(size_t block = 0; block < blockColors.size() && block < 255; ++block) {
+            glm::vec3 difference = glm::vec3(blockColors[block]) - color;
+            float distance = glm::dot(difference, difference);
+
+            if(distance < bestDistance) {
+                bestDistance = distance;
+                map[i] = static_cast<unsigned char>(block + 1);
+            }
+        }
+    }
+
+    return map;
+}
+
+VoxImportResult importVox(World& world, const char* data, size_t size, const glm::ivec3& origin, const std::vector<glm::vec4>& blockColors) {
+    VoxScene scene = parseVox(data, size);
+
+    std::array<unsigned char, 256> palette = {};
+    if(scene.hasPalette) {
+        palette = createVoxPaletteMap(scene.colors, blockColors);
+    } else if(!blockColors.empty()) {
+        size_t blockCount = std::min<size_t>(blockColors.size(), 255);
+        for(size_t i = 1; i < 256; ++i) {
+            palette[i] = static_cast<unsigned char>((i - 1) % blockCount + 1);
+        }
+    }
+
+    std::vector<VoxPlacement> placements;
+    if(scene.nodes.empty()) {
+        // files without a scene graph put every model at the origin
+        for(const auto& model : scene.models) {
+            placements.push_back({ &model, VoxTransform(), false });
+        }
+    } else {
+        collectVoxPlacements(scene, 0, VoxTransform(), 0, placements);
+    }
+
+    VoxImportResult result;
+    result.modelCount = placements.size();
+
+    // world space box of every placed model, the corners are enough since
+    // rotations keep boxes axis aligned
+    struct PlacedBox {
+        glm::ivec3 min;
+        glm::ivec3 max;
+    };
+
+    std::vector<PlacedBox> boxes;
+    glm::ivec3 sceneMin(INT_MAX);
+
+    for(const auto& placement : placements) {
+        glm::ivec3 a = placeVoxel(placement, glm::ivec3(0));
+        glm::ivec3 b = placeVoxel(placement, placement.model->size - 1);
+
+        boxes.push_back({ glm::min(a, b), glm::max(a, b) });
+
+        if(placement.model->voxelCount > 0) {
+            sceneMin = glm::min(sceneMin, boxes.back().min);
+        }
+    }
+
+    if(sceneMin.x == INT_MAX) {
+        return result;
+    }
+
+    glm::ivec3 offset = origin - sceneMin;
+
+    for(size_t p = 0; p < placements.size(); ++p) {
+        const VoxPlacement& placement = placements[p];
+        const VoxModel& model = *placement.model;
+        if(model.voxelCount == 0) {
+            continue;
+        }
+
+        glm::ivec3 boxMin = boxes[p].min + offset;
+        glm::ivec3 boxMax = boxes[p].max + offset;
+        if(boxMax.x < 0 || boxMax.y < 0 || boxMax.z < 0) {
+            result.skippedVoxelCount += model.voxelCount;
+            continue;
+        }
+
+        // voxels are staged per chunk first, 0 marks voxels the model leaves empty
+        glm::ivec3 chunkMin = glm::max(boxMin, glm::ivec3(0)) / CHUNK_SIZE;
+        glm::ivec3 chunkMax = boxMax / CHUNK_SIZE;
+        glm::ivec3 chunkRange = chunkMax - chunkMin + 1;
+
+        std::vector<std::unique_ptr<ChunkBlocks>> staged(static_cast<size_t>(chunkRange.x) * chunkRange.y * chunkRange.z);
+
+        // placing is linear, a voxel lands at base plus one table entry per axis
+        glm::ivec3 base = placeVoxel(placement, glm::ivec3(0)) + offset;
+        std::array<std::vector<glm::ivec3>, 3> axisOffsets;
+
+        for(int axis = 0; axis < 3; ++axis) {
+            glm::ivec3 step(0);
+            step[axis] = 1;
+
+            glm::ivec3 direction = placeVoxel(placement, step) + offset - base;
+            for(int i = 0; i < model.size[axis]; ++i) {
+                axisOffsets[axis].push_back(direction * i);
+            }
+        }
+
+        // kept in locals, the block stores may alias anything reached through a pointer
+        const glm::ivec3 size = model.size;
+        const glm::ivec3* offsetsX = axisOffsets[0].data();
+        const glm::ivec3* offsetsY = axisOffsets[1].data();
+        const glm::ivec3* offsetsZ = axisOffsets[2].data();
+        size_t written = 0;
+        size_t skipped = 0;
+
+        const unsigned char* voxels = reinterpret_cast<const unsigned char*>(model.voxels);
+        for(uint32_t i = 0; i < model.voxelCount; ++i) {
+            const unsigned char* voxel = voxels + i * 4;
+            unsigned char block = palette[voxel[3]];
+
+            if(block == 0 || voxel[0] >= size.x || voxel[1] >= size.y || voxel[2] >= size.z) {
+                skipped++;
+                continue;
+            }
+
+            const glm::ivec3& offsetX = offsetsX[voxel[0]];
+            const glm::ivec3& offsetY = offsetsY[voxel[1]];
+            const glm::ivec3& offsetZ = offsetsZ[voxel[2]];
+
+            int x = base.x + offsetX.x + offsetY.x + offsetZ.x;
+            int y = base.y + offsetX.y + offsetY.y + offsetZ.y;
+            int z = base.z + offsetX.z + offsetY.z + offsetZ.z;
+            if(x < 0 || y < 0 || z < 0) {
+                skipped++;
+                continue;
+            }
+
+            // unsigned from here, so dividing is a shift
+            unsigned int positionX = static_cast<unsigned int>(x);
+            unsigned int positionY = static_cast<unsigned int>(y);
+            unsigned int positionZ = static_cast<unsigned int>(z);
+
+            size_t chunkIndex =
+                (static_cast<size_t>(positionZ / CHUNK_SIZE - chunkMin.z) * chunkRange.y + (positionY / CHUNK_SIZE - chunkMin.y)) * chunkRange.x +
+                (positionX / CHUNK_SIZE - chunkMin.x);
+
+            auto& blocks = staged[chunkIndex];
+            if(!blocks) {
+                blocks = std::make_unique<ChunkBlocks>();
+            }
+
+            (*blocks)[(positionZ % CHUNK_SIZE) * CHUNK_SIZE * CHUNK_SIZE + (positionY % CHUNK_SIZE) * CHUNK_SIZE + positionX % CHUNK_SIZE] = block;
+
+            written++;
+        }
+
+        result.voxelCount += written;
+        result.skippedVoxelCount += skipped;
+
+        for(int z = 0; z < chunkRange.z; ++z) {
+            for(int y = 0; y < chunkRange.y; ++y) {
+                for(int x = 0; x < chunkRange.x; ++x) {
+                    const auto& blocks = staged[(static_cast<size_t>(z) * chunkRange.y + y) * chunkRange.x + x];
+                    if(!blocks) {
+                        continue;
+                    }
+
+                    world.editChunk(chunkMin.x + x, chunkMin.y + y, chunkMin.z + z, [&blocks](unsigned char* out) {
+                        const unsigned char* in = blocks->data();
+                        for(size_t i = 0; i < CHUNK_VOLUME; ++i) {
+                            out[i] = in[i] ? in[i] : out[i];
+                        }
+                    });
+
+                    result.chunkCount++;
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+VoxImportResult importVoxFile(World& world, const std::string& path, const glm::ivec3& origin, const std::vector<glm::vec4>& blockColors) {
+    auto file = core::MappedFile::open(path);
+    return importVox(world, file->getData(), file->getSize(), origin, blockColors);
+}
+
+static void writeVoxChunk(core::BinaryWriter& writer, uint32_t id, const std::string& content, const std::string& children = std::string()) {
+    writer.write<uint32_t>(id);
+    writer.write<uint32_t>(static_cast<uint32_t>(content.size()));
+    writer.write<uint32_t>(static_cast<uint32_t>(children.size()));
+    writer.writeBytes(content.data(), content.size());
+    writer.writeBytes(children.data(), children.size());
+}
+
+static void writeVoxDict(core::BinaryWriter& writer, const std::vector<std::pair<std::string, std::string>>& entries) {
+    writer.write<uint32_t>(static_cast<uint32_t>(entries.size()));
+    for(const auto& [key, value] : entries) {
+        writer.writeString(key);
+        writer.writeString(value);
+    }
+}
+
+size_t exportVox(const World& world, const std::vector<glm::vec4>& blockColors, std::string& out) {
+    WorldSnapshot snapshot = world.takeSnapshot();
+
+    struct ExportChunk {
+        glm::ivec3 coords;
+        const unsigned char* blocks;
+    };
+
+    std::vector<ExportChunk> chunks;
+    chunks.reserve(snapshot.chunks.size() + snapshot.regionChunks.size());
+
+    for(const auto& chunk : snapshot.chunks) {
+        chunks.push_back({ glm::ivec3(chunk.x, chunk.y, chunk.z), chunk.blocks->data() });
+    }
+
+    std::vector<ChunkBlocks> regionBlocks(snapshot.regionChunks.size());
+    for(size_t i = 0; i < snapshot.regionChunks.size(); ++i) {
+        snapshot.region->readChunkAt(snapshot.regionChunks[i], regionBlocks[i].data());
+        chunks.push_back({ snapshot.region->getChunkCoords(snapshot.regionChunks[i]), regionBlocks[i].data() });
+    }
+
+    // one model per 256^3 tile of file coordinates, voxels packed as
+    // x, y, z relative to the tile and the color index in the high byte
+    struct ExportModel {
+        glm::ivec3 min = glm::ivec3(INT_MAX);
+        glm::ivec3 max = glm::ivec3(INT_MIN);
+        std::vector<uint32_t> voxels;
+    };
+
+    std::map<std::tuple<int, int, int>, ExportModel> models;
+    size_t voxelCount = 0;
+
+    for(const auto& chunk : chunks) {
+        if(countSolidBlocks(chunk.blocks, CHUNK_VOLUME) == 0) {
+            continue;
+        }
+
+        // chunks never straddle tiles, 256 is a multiple of the chunk size
+        glm::ivec3 chunkOrigin = chunk.coords * CHUNK_SIZE;
+        glm::ivec3 fileOrigin = worldToVox(chunkOrigin);
+        glm::ivec3 tile(floorDiv(fileOrigin.x, VOX_MAX_MODEL_SIZE), floorDiv(fileOrigin.y, VOX_MAX_MODEL_SIZE), floorDiv(fileOrigin.z, VOX_MAX_MODEL_SIZE));
+        glm::ivec3 tileOrigin = tile * VOX_MAX_MODEL_SIZE;
+
+        ExportModel& model = models[std::make_tuple(tile.x, tile.y, tile.z)];
+        size_t modelVoxels = model.voxels.size();
+
+        // block (x, y, z) of the chunk is at (origin.x + x, origin.y - z, origin.z + y) in the tile
+        glm::ivec3 origin = fileOrigin - tileOrigin;
+        int minX = INT_MAX, minY = INT_MAX, minZ = INT_MAX;
+        int maxX = INT_MIN, maxY = INT_MIN, maxZ = INT_MIN;
+
+        for(int z = 0; z < CHUNK_SIZE; ++z) {
+            for(int y = 0; y < CHUNK_SIZE; ++y) {
+                const unsigned char* row = chunk.blocks + z * CHUNK_SIZE * CHUNK_SIZE + y * CHUNK_SIZE;
+                uint32_t rowPacked = static_cast<uint32_t>(origin.x) | (static_cast<uint32_t>(origin.y - z) << 8) | (static_cast<uint32_t>(origin.z + y) << 16);
+
+                for(int x = 0; x < CHUNK_SIZE; ++x) {
+                    if(row[x] == 0) {
+                        continue;
+                    }
+
+                    minX = std::min(minX, x);
+                    maxX = std::max(maxX, x);
+                    minY = std::min(minY, y);
+                    maxY = std::max(maxY, y);
+                    minZ = std::min(minZ, z);
+                    maxZ = std::max(maxZ, z);
+
+                    model.voxels.push_back((rowPacked + static_cast<uint32_t>(x)) | (static_cast<uint32_t>(row[x]) << 24));
+                }
+            }
+        }
+
+        model.min = glm::min(model.min, glm::ivec3(origin.x + minX, origin.y - maxZ, origin.z + minY));
+        model.max = glm::max(model.max, glm::ivec3(origin.x + maxX, origin.y - minZ, origin.z + maxY));
+
+        voxelCount += model.voxels.size() - modelVoxels;
+    }
+
+    std::string children;
+    core::BinaryWriter childWriter(children);
+
+    std::vector<glm::ivec3> translations;
+
+    for(const auto& [key, model] : models) {
+        glm::ivec3 tileOrigin = glm::ivec3(std::get<0>(key), std::get<1>(key), std::get<2>(key)) * VOX_MAX_MODEL_SIZE;
+        glm::ivec3 size = model.max - model.min + 1;
+
+        std::string content;
+        core::BinaryWriter writer(content);
+        writer.write<int32_t>(size.x);
+        writer.write<int32_t>(size.y);
+        writer.write<int32_t>(size.z);
+        writeVoxChunk(childWriter, VOX_CHUNK_SIZE, content);
+
+        content.clear();
+        content.reserve(4 + model.voxels.size() * 4);
+        writer.write<uint32_t>(static_cast<uint32_t>(model.voxels.size()));
+
+        uint32_t minPacked = static_cast<uint32_t>(model.min.x) | (static_cast<uint32_t>(model.min.y) << 8) | (static_cast<uint32_t>(model.min.z) << 16);
+        size_t voxelsStart = content.size();
+        content.resize(voxelsStart + model.voxels.size() * 4);
+
+        char* bytes = &content[voxelsStart];
+        for(uint32_t voxel : model.voxels) {
+            // per byte subtraction, the minimum never exceeds any coordinate
+            uint32_t packed = voxel - minPacked;
+
+            bytes[0] = static_cast<char>(packed & 0xFF);
+            bytes[1] = static_cast<char>((packed >> 8) & 0xFF);
+            bytes[2] = static_cast<char>((packed >> 16) & 0xFF);
+            bytes[3] = static_cast<char>(packed >> 24);
+            bytes += 4;
+        }
+
+        writeVoxChunk(childWriter, VOX_CHUNK_XYZI, content);
+
+        // scene graph translations are to the model center
+        translations.push_back(tileOrigin + model.min + size / 2);
+    }
+
+    if(models.empty()) {
+        // MagicaVoxel expects at least one model
+        std::string content;
+        core::BinaryWriter writer(content);
+        writer.write<int32_t>(1);
+        writer.write<int32_t>(1);
+        writer.write<int32_t>(1);
+        writeVoxChunk(childWriter, VOX_CHUNK_SIZE, content);
+
+        content.clear();
+        writer.write<uint32_t>(0);
+        writeVoxChunk(childWriter, VOX_CHUNK_XYZI, content);
+
+        translations.push_back(glm::ivec3(0));
+    }
+
+    // root transform, a group and a transform and shape per model
+    {
+        std::string content;
+        core::BinaryWriter writer(content);
+        writer.write<int32_t>(0);
+        writeVoxDict(writer, {});
+        writer.write<int32_t>(1);
+        writer.write<int32_t>(-1);
+        writer.write<int32_t>(-1);
+        writer.write<uint32_t>(1);
+        writeVoxDict(writer, {});
+        writeVoxChunk(childWriter, VOX_CHUNK_TRANSFORM, content);
+
+        content.clear();
+        writer.write<int32_t>(1);
+        writeVoxDict(writer, {});
+        writer.write<uint32_t>(static_cast<uint32_t>(translations.size()));
+        for(size_t i = 0; i < translations.size(); ++i) {
+            writer.write<int32_t>(static_cast<int32_t>(2 + i * 2));
+        }
+        writeVoxChunk(childWriter, VOX_CHUNK_GROUP, content);
+    }
+
+    for(size_t i = 0; i < translations.size(); ++i) {
+        int32_t transformId = static_cast<int32_t>(2 + i * 2);
+
+        std::string content;
+        core::BinaryWriter writer(content);
+        writer.write<int32_t>(transformId);
+        writeVoxDict(writer, {});
+        writer.write<int32_t>(transformId + 1);
+        writer.write<int32_t>(-1);
+        writer.write<int32_t>(0);
+        writer.write<uint32_t>(1);
+        writeVoxDict(writer, { { "_t", std::to_string(translations[i].x) + " " + std::to_string(translations[i].y) + " " + std::to_string(translations[i].z) } });
+        writeVoxChunk(childWriter, VOX_CHUNK_TRANSFORM, content);
+
+        content.clear();
+        writer.write<int32_t>(transformId + 1);
+        writeVoxDict(writer, {});
+        writer.write<uint32_t>(1);
+        writer.write<int32_t>(static_cast<int32_t>(i));
+        writeVoxDict(writer, {});
+        writeVoxChunk(childWriter, VOX_CHUNK_SHAPE, content);
+    }
+
+    {
+        std::string content;
+        core::BinaryWriter writer(content);
+
+        for(int index = 1; index <= 256; ++index) {
+            uint32_t color = VOX_UNUSED_COLOR;
+
+            if(index <= static_cast<int>(blockColors.size()) && index < 256) {
+                const glm::vec4& blockColor = blockColors[index - 1];
+                color = 0;
+
+                for(int channel = 0; channel < 4; ++channel) {
+                    color |= static_cast<uint32_t>(glm::clamp(blockColor[channel], 0.0f, 1.0f) * 255.0f + 0.5f) << (channel * 8);
+                }
+            }
+
+            writer.write<uint32_t>(color);
+        }
+
+        writeVoxChunk(childWriter, VOX_CHUNK_RGBA, content);
+    }
+
+    core::BinaryWriter writer(out);
+    writer.write<uint32_t>(VOX_MAGIC);
+    writer.write<uint32_t>(VOX_VERSION);
+    writeVoxChunk(writer, VOX_CHUNK_MAIN, std::string(), children);
+
+    return voxelCount;
+}
+
+size_t exportVoxFile(const World& world, const std::string& path, const std::vector<glm::vec4>& blockColors) {
+    std::string buffer;
+    size_t voxelCount = exportVox(world, blockColors, buffer);
+
+    std::ofstream file(path, std::ios::binary | std::ios::out | std::ios::trunc);
+    if(!file) {
+        throw std::runtime_error("Failed to open file for writing: " + path);
+    }
+
+    file.write(buffer.data(), buffer.size());
+    if(!file) {
+        throw std::runtime_error("Failed to write to file: " + path);
+    }
+
+    return voxelCount;
+}
@@ -0,0 +1,627 @@
+#include "voxel_clipboard.hpp"
+#include "engine/core/binary.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+// larger boxes are rejected when loading, keeps brick counts in range
+const int MAX_CLIPBOARD_SIZE = 1 << 16;
+
+static int getBrickCellIndex(int x, int y, int z) {
+    return (z * CLIPBOARD_BRICK_SIZE + y) * CLIPBOARD_BRICK_SIZE + x;
+}
+
+static size_t getPackedBrickSize(int bits) {
+    return static_cast<size_t>(CLIPBOARD_BRICK_VOLUME) * bits / 8;
+}
+
+void VoxelClipboard::encode(const glm::ivec3& size, const std::function<void(const glm::ivec3& brickOrigin, unsigned char* blocks)>& fill) {
+    _palette = { 0 };
+    _bricks.clear();
+    _data.clear();
+    _voxelCount = 0;
+
+    if(size.x <= 0 || size.y <= 0 || size.z <= 0) {
+        _size = glm::ivec3(0);
+        _brickCounts = glm::ivec3(0);
+        return;
+    }
+
+    _size = size;
+    _brickCounts = (size + CLIPBOARD_BRICK_SIZE - 1) / CLIPBOARD_BRICK_SIZE;
+    _bricks.reserve(static_cast<size_t>(_brickCounts.x) * _brickCounts.y * _brickCounts.z);
+
+    // palette index per block id, -1 until the id is first seen
+    std::array<int, 256> paletteIndices;
+    paletteIndices.fill(-1);
+    paletteIndices[0] = 0;
+
+    std::array<unsigned char, CLIPBOARD_BRICK_VOLUME> blocks;
+    std::array<unsigned char, CLIPBOARD_BRICK_VOLUME> indices;
+
+    for(int z = 0; z < _brickCounts.z; ++z) {
+        for(int y = 0; y < _brickCounts.y; ++y) {
+            for(int x = 0; x < _brickCounts.x; ++x) {
+                blocks.fill(0);
+                fill(glm::ivec3(x, y, z) * CLIPBOARD_BRICK_SIZE, blocks.data());
+
+                int maxIndex = 0;
+                bool single = true;
+
+                for(int i = 0; i < CLIPBOARD_BRICK_VOLUME; ++i) {
+                    int& index = paletteIndices[blocks[i]];
+                    if(index < 0) {
+                        index = static_cast<int>(_palette.size());
+                        _palette.push_back(blocks[i]);
+                    }
+
+                    indices[i] = static_cast<unsigned char>(index);
+                    maxIndex = std::max(maxIndex, index);
+                    single = single && indices[i] == indices[0];
+
+                    if(blocks[i] != 0) {
+                        _voxelCount++;
+                    }
+                }
+
+                Brick brick;
+                brick.offset = static_cast<uint32_t>(_data.size());
+
+                if(single) {
+                    brick.bits = 0;
+                    brick.value = indices[0];
+                } else {
+                    brick.bits = maxIndex < 2 ? 1 : maxIndex < 4 ? 2 : maxIndex < 16 ? 4 : 8;
+                    brick.value = 0;
+
+                    _data.resize(_data.size() + getPackedBrickSize(brick.bits), 0);
+
+                    uint8_t* packed = _data.data() + brick.offset;
+                    for(int i = 0; i < CLIPBOARD_BRICK_VOLUME; ++i) {
+                        int bit = i * brick.bits;
+                        packed[bit >> 3] |= static_cast<uint8_t>(indices[i] << (bit & 7));
+                    }
+                }
+
+                _bricks.push_back(brick);
+            }
+        }
+    }
+}
+
+void VoxelClipboard::decodeBrick(const Brick& brick, unsigned char* blocks) const {
+    if(brick.bits == 0) {
+        std::memset(blocks, _palette[brick.value], CLIPBOARD_BRICK_VOLUME);
+        return;
+    }
+
+    const uint8_t* packed = _data.data() + brick.offset;
+    int mask = (1 << brick.bits) - 1;
+
+    for(int i = 0; i < CLIPBOARD_BRICK_VOLUME; ++i) {
+        int bit = i * brick.bits;
+        blocks[i] = _palette[(packed[bit >> 3] >> (bit & 7)) & mask];
+    }
+}
+
+unsigned char VoxelClipboard::getBlock(const glm::ivec3& local) const {
+    if(local.x < 0 || local.y < 0 || local.z < 0 || local.x >= _size.x || local.y >= _size.y || local.z >= _size.z) {
+        return 0;
+    }
+
+    const Brick& brick = getBrick(local.x / CLIPBOARD_BRICK_SIZE, local.y / CLIPBOARD_BRICK_SIZE, local.z / CLIPBOARD_BRICK_SIZE);
+    if(brick.bits == 0) {
+        return _palette[brick.value];
+    }
+
+    int bit = getBrickCellIndex(local.x % CLIPBOARD_BRICK_SIZE, local.y % CLIPBOARD_BRICK_SIZE, local.z % CLIPBOARD_BRICK_SIZE) * brick.bits;
+    return _palette[(_data[brick.offset + (bit >> 3)] >> (bit & 7)) & ((1 << brick.bits) - 1)];
+}
+
+void VoxelClipboard::forEachVoxel(const std::function<void(const glm::ivec3& local, unsigned char block)>& action) const {
+    std::array<unsigned char, CLIPBOARD_BRICK_VOLUME> blocks;
+
+    for(int bz = 0; bz < _brickCounts.z; ++bz) {
+        for(int by = 0; by < _brickCounts.y; ++by) {
+            for(int bx = 0; bx < _brickCounts.x; ++bx) {
+                const Brick& brick = getBrick(bx, by, bz);
+                if(brick.bits == 0 && brick.value == 0) {
+                    continue;
+                }
+
+                decodeBrick(brick, blocks.data());
+
+                glm::ivec3 brickOrigin = glm::ivec3(bx, by, bz) * CLIPBOARD_BRICK_SIZE;
+                glm::ivec3 extent = glm::min(glm::ivec3(CLIPBOARD_BRICK_SIZE), _size - brickOrigin);
+
+                for(int z = 0; z < extent.z; ++z) {
+                    for(int y = 0; y < extent.y; ++y) {
+                        for(int x = 0; x < extent.x; ++x) {
+                            unsigned char block = blocks[getBrickCellIndex(x, y, z)];
+                            if(block != 0) {
+                                action(brickOrigin + glm::ivec3(x, y, z), block);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+size_t VoxelClipboard::getMemoryUsage() const {
+    return _palette.size() + _bricks.size() * sizeof(Brick) + _data.size();
+}
+
+VoxelClipboard VoxelClipboard::copyVoxels(const World& world, const std::vector<glm::ivec3>& voxels) {
+    VoxelClipboard clipboard;
+
+    struct CopiedVoxel {
+        glm::ivec3 position;
+        unsigned char block;
+    };
+
+    std::vector<CopiedVoxel> copied;
+    copied.reserve(voxels.size());
+
+    glm::ivec3 min(std::numeric_limits<int>::max());
+    glm::ivec3 max(std::numeric_limits<int>::min());
+
+    for(const auto& voxel : voxels) {
+        unsigned char block = world.getBlock(voxel.x, voxel.y, voxel.z);
+        if(block == 0) {
+            continue;
+        }
+
+        copied.push_back({ voxel, block });
+        min = glm::min(min, voxel);
+        max = glm::max(max, voxel);
+    }
+
+    if(copied.empty()) {
+        return clipboard;
+    }
+
+    glm::ivec3 size = max - min + 1;
+    SparseBricks bricks;
+
+    for(const auto& voxel : copied) {
+        setSparseBrickCell(bricks, size, voxel.position - min, voxel.block);
+    }
+
+    clipboard.encodeSparse(size, bricks);
+    clipboard._origin = min;
+
+    return clipboard;
+}
+
+VoxelClipboard VoxelClipboard::copySelection(const World& world, const VoxelSelection& selection) {
+    VoxelClipboard clipboard;
+
+    if(selection.isEmpty()) {
+        return clipboard;
+    }
+
+    glm::ivec3 min = selection.getMin();
+    glm::ivec3 size = selection.getMax() - min + 1;
+    SparseBricks bricks;
+
+    selection.forEachChunk([&](const glm::ivec3& coords, const SelectionBits& bits) {
+        const Chunk* chunk = world.getChunk(coords.x, coords.y, coords.z);
+        if(!chunk) {
+            return;
+        }
+
+        const auto& blocks = chunk->getBlocks();
+        glm::ivec3 offset = coords * CHUNK_SIZE - min;
+
+        for(size_t i = 0; i < SELECTION_CHUNK_WORDS; ++i) {
+            uint64_t word = bits[i];
+
+            while(word != 0) {
+                int index = static_cast<int>(i * 64) + countTrailingZeros(word);
+                word &= word - 1;
+
+                if(blocks[index] == 0) {
+                    continue;
+                }
+
+                glm::ivec3 local(
+                    offset.x + index % CHUNK_SIZE,
+                    offset.y + (index / CHUNK_SIZE) % CHUNK_SIZE,
+                    offset.z + index / (CHUNK_SIZE * CHUNK_SIZE)
+                );
+
+                setSparseBrickCell(bricks, size, local, blocks[index]);
+            }
+        }
+    });
+
+    clipboard.encodeSparse(size, bricks);
+    clipboard._origin = min;
+
+    return clipboard;
+}
+
+void VoxelClipboard::setSparseBrickCell(SparseBricks& bricks, const glm::ivec3& size, const glm::ivec3& local, unsigned char block) {
+    glm::ivec3 brickCounts = (size + CLIPBOARD_BRICK_SIZE - 1) / CLIPBOARD_BRICK_SIZE;
+    glm::ivec3 brick = local / CLIPBOARD_BRICK_SIZE;
+    glm::ivec3 cell = local - brick * CLIPBOARD_BRICK_SIZE;
+
+    // zeroed when first used
+    auto& blocks = bricks[(static_cast<size_t>(brick.z) * brickCounts.y + brick.y) * brickCounts.x + brick.x];
+    blocks[getBrickCellIndex(cell.x, cell.y, cell.z)] = block;
+}
+
+void VoxelClipboard::encodeSparse(const glm::ivec3& size, const SparseBricks& bricks) {
+    glm::ivec3 brickCounts = (size + CLIPBOARD_BRICK_SIZE - 1) / CLIPBOARD_BRICK_SIZE;
+
+    encode(size, [&](const glm::ivec3& brickOrigin, unsigned char* blocks) {
+        glm::ivec3 brick = brickOrigin / CLIPBOARD_BRICK_SIZE;
+
+        auto it = bricks.find((static_cast<size_t>(brick.z) * brickCounts.y + brick.y) * brickCounts.x + brick.x);
+        if(it != bricks.end()) {
+            std::memcpy(blocks, it->second.data(), CLIPBOARD_BRICK_VOLUME);
+        }
+    });
+}
+
+VoxelClipboard VoxelClipboard::copyBox(const World& world, const glm::ivec3& min, const glm::ivec3& max) {
+    VoxelClipboard clipboard;
+
+    glm::ivec3 low = glm::min(min, max);
+    glm::ivec3 high = glm::max(min, max);
+    glm::ivec3 size = high - low + 1;
+
+    // bricks then start on brick boundaries of the world, so each one lies in a single chunk
+    bool aligned = low.x >= 0 && low.y >= 0 && low.z >= 0 &&
+                   low.x % CLIPBOARD_BRICK_SIZE == 0 && low.y % CLIPBOARD_BRICK_SIZE == 0 && low.z % CLIPBOARD_BRICK_SIZE == 0;
+
+    clipboard.encode(size, [&](const glm::ivec3& brickOrigin, unsigned char* blocks) {
+        glm::ivec3 start = low + brickOrigin;
+        glm::ivec3 extent = glm::min(glm::ivec3(CLIPBOARD_BRICK_SIZE), size - brickOrigin);
+
+        if(aligned) {
+            const Chunk* chunk = world.getChunkContainingBlock(start.x, start.y, start.z);
+            if(!chunk) {
+                return;
+            }
+
+            const ChunkBlocks& chunkBlocks = chunk->getBlocks();
+            glm::ivec3 inChunk(start.x % CHUNK_SIZE, start.y % CHUNK_SIZE, start.z % CHUNK_SIZE);
+
+            for(int z = 0; z < extent.z; ++z) {
+                for(int y = 0; y < extent.y; ++y) {
+                    std::memcpy(
+                        blocks + getBrickCellIndex(0, y, z),
+                        chunkBlocks.data() + (inChunk.z + z) * CHUNK_SIZE * CHUNK_SIZE + (inChunk.y + y) * CHUNK_SIZE + inChunk.x,
+                        extent.x
+                    );
+                }
+            }
+
+            return;
+        }
+
+        for(int z = 0; z < extent.z; ++z) {
+            for(int y = 0; y < extent.y; ++y) {
+                for(int x = 0; x < extent.x; ++x) {
+                    blocks[getBrickCellIndex(x, y, z)] = world.getBlock(start.x + x, start.y + y, start.z + z);
+                }
+            }
+        }
+    });
+
+    clipboard._origin = low;
+
+    return clipboard;
+}
+
+void VoxelClipboard::paste(World& world, const glm::ivec3& position) const {
+    write(world, position, false);
+}
+
+void VoxelClipboard::erase(World& world, const glm::ivec3& position) const {
+    write(world, position, true);
+}
+
+void VoxelClipboard::write(World& world, const glm::ivec3& position, bool erase) const {
+    if(isEmpty()) {
+        return;
+    }
+
+    glm::ivec3 end = position + _size;
+    if(end.x <= 0 || end.y <= 0 || end.z <= 0) {
+        return;
+    }
+
+    glm::ivec3 chunkMin = glm::max(position, glm::ivec3(0)) / CHUNK_SIZE;
+    glm::ivec3 chunkMax = (end - 1) / CHUNK_SIZE;
+
+    std::array<unsigned char, CLIPBOARD_BRICK_VOLUME> decoded;
+
+    for(int cz = chunkMin.z; cz <= chunkMax.z; ++cz) {
+        for(int cy = chunkMin.y; cy <= chunkMax.y; ++cy) {
+            for(int cx = chunkMin.x; cx <= chunkMax.x; ++cx) {
+                glm::ivec3 chunkOrigin = glm::ivec3(cx, cy, cz) * CHUNK_SIZE;
+
+                // part of the box inside this chunk, in box coordinates, high exclusive
+                glm::ivec3 low = glm::max(chunkOrigin - position, glm::ivec3(0));
+                glm::ivec3 high = glm::min(chunkOrigin + CHUNK_SIZE - position, _size);
+
+                glm::ivec3 brickLow = low / CLIPBOARD_BRICK_SIZE;
+                glm::ivec3 brickHigh = (high - 1) / CLIPBOARD_BRICK_SIZE;
+
+                bool hasVoxels = false;
+                for(int bz = brickLow.z; bz <= brickHigh.z && !hasVoxels; ++bz) {
+                    for(int by = brickLow.y; by <= brickHigh.y && !hasVoxels; ++by) {
+                        for(int bx = brickLow.x; bx <= brickHigh.x && !hasVoxels; ++bx) {
+                            const Brick& brick = getBrick(bx, by, bz);
+                            hasVoxels = brick.bits != 0 || brick.value != 0;
+                        }
+                    }
+                }
+
+                // don't create chunks only to leave them empty
+                if(!hasVoxels) {
+                    continue;
+                }
+
+                glm::ivec3 offset = position - chunkOrigin;
+
+                world.editChunk(cx, cy, cz, [&](unsigned char* blocks) {
+                    for(int bz = brickLow.z; bz <= brickHigh.z; ++bz) {
+                        for(int by = brickLow.y; by <= brickHigh.y; ++by) {
+                            for(int bx = brickLow.x; bx <= brickHigh.x; ++bx) {
+                                const Brick& brick = getBrick(bx, by, bz);
+                                if(brick.bits == 0 && brick.value == 0) {
+                                    continue;
+                                }
+
+                                glm::ivec3 brickOrigin = glm::ivec3(bx, by, bz) * CLIPBOARD_BRICK_SIZE;
+                                glm::ivec3 from = glm::max(low, brickOrigin);
+                                glm::ivec3 to = glm::min(high, brickOrigin + CLIPBOARD_BRICK_SIZE);
+
+                                if(brick.bits == 0) {
+                                    unsigned char block = erase ? 0 : _palette[brick.value];
+
+                                    for(int z = from.z; z < to.z; ++z) {
+                                        for(int y = from.y; y < to.y; ++y) {
+                                            int index = (z + offset.z) * CHUNK_SIZE * CHUNK_SIZE + (y + offset.y) * CHUNK_SIZE + from.x + offset.x;
+                                            std::memset(blocks + index, block, to.x - from.x);
+                                        }
+                                    }
+
+                                    continue;
+                                }
+
+                                decodeBrick(brick, decoded.data());
+
+                                for(int z = from.z; z < to.z; ++z) {
+                                    for(int y = from.y; y < to.y; ++y) {
+                                        for(int x = from.x; x < to.x; ++x) {
+                                            unsigned char block = decoded[getBrickCellIndex(x - brickOrigin.x, y - brickOrigin.y, z - brickOrigin.z)];
+                                            if(block != 0) {
+                                                blocks[(z + offset.z) * CHUNK_SIZE * CHUNK_SIZE + (y + offset.y) * CHUNK_SIZE + x + offset.x] = erase ? 0 : block;
+                                            }
+                                        }
+                                    }
+                                }
+                            }
+                        }
+                    }
+                });
+            }
+        }
+    }
+}
+
+template<typename Source>
+VoxelClipboard VoxelClipboard::transformed(const glm::ivec3& size, const Source& source) const {
+    VoxelClipboard result;
+
+    result.encode(size, [&](const glm::ivec3& brickOrigin, unsigned char* blocks) {
+        glm::ivec3 extent = glm::min(glm::ivec3(CLIPBOARD_BRICK_SIZE), size - brickOrigin);
+
+        for(int z = 0; z < extent.z; ++z) {
+            for(int y = 0; y < extent.y; ++y) {
+                for(int x = 0; x < extent.x; ++x) {
+                    blocks[getBrickCellIndex(x, y, z)] = getBlock(source(brickOrigin + glm::ivec3(x, y, z)));
+                }
+            }
+        }
+    });
+
+    result._origin = _origin;
+
+    return result;
+}
+
+VoxelClipboard VoxelClipboard::rotated(int quarterTurns) const {
+    const glm::ivec3 size = _size;
+
+    switch(((quarterTurns % 4) + 4) % 4) {
+        case 1:
+            // x turns into z, z into -x
+            return transformed(glm::ivec3(size.z, size.y, size.x), [size](const glm::ivec3& p) {
+                return glm::ivec3(p.z, p.y, size.z - 1 - p.x);
+            });
+        case 2:
+            return transformed(size, [size](const glm::ivec3& p) {
+                return glm::ivec3(size.x - 1 - p.x, p.y, size.z - 1 - p.z);
+            });
+        case 3:
+            return transformed(glm::ivec3(size.z, size.y, size.x), [size](const glm::ivec3& p) {
+                return glm::ivec3(size.x - 1 - p.z, p.y, p.x);
+            });
+        default:
+            return *this;
+    }
+}
+
+VoxelClipboard VoxelClipboard::mirrored(int axis) const {
+    if(axis < 0 || axis > 2) {
+        throw std::invalid_argument("VoxelClipboard: mirror axis out of range.");
+    }
+
+    const glm::ivec3 size = _size;
+
+    return transformed(size, [size, axis](const glm::ivec3& p) {
+        glm::ivec3 mirrored = p;
+        mirrored[axis] = size[axis] - 1 - p[axis];
+        return mirrored;
+    });
+}
+
+void VoxelClipboard::saveToBuffer(std::string& out) const {
+    core::BinaryWriter writer(out);
+
+    writer.write<uint32_t>(VOXEL_CLIPBOARD_MAGIC);
+    writer.write<uint16_t>(VOXEL_CLIPBOARD_VERSION);
+    writer.write<uint16_t>(0);
+
+    for(int axis = 0; axis < 3; ++axis) {
+        writer.write<int32_t>(_size[axis]);
+    }
+
+    for(int axis = 0; axis < 3; ++axis) {
+        writer.write<int32_t>(_origin[axis]);
+    }
+
+    writer.write<uint16_t>(static_cast<uint16_t>(_palette.size()));
+    writer.writeBytes(_palette.data(), _palette.size());
+
+    for(const auto& brick : _bricks) {
+        writer.write<uint8_t>(brick.bits);
+        writer.write<uint8_t>(brick.value);
+    }
+
+    writer.write<uint32_t>(static_cast<uint32_t>(_data.size()));
+    writer.writeBytes(_data.data(), _data.size());
+}
+
+VoxelClipboard VoxelClipboard::loadFromBuffer(const char* data, size_t size) {
+    core::BinaryReader reader(data, size);
+
+    if(reader.read<uint32_t>() != VOXEL_CLIPBOARD_MAGIC) {
+        throw std::runtime_error("Not a clipboard file: invalid magic.");
+    }
+
+    uint16_t version = reader.read<uint16_t>();
+    if(version != VOXEL_CLIPBOARD_VERSION) {
+        throw std::runtime_error("Unsupported clipboard file version " + std::to_string(version) + ".");
+    }
+
+    reader.read<uint16_t>(); // flags
+
+    VoxelClipboard clipboard;
+
+    for(int axis = 0; axis < 3; ++axis) {
+        clipboard._size[axis] = reader.read<int32_t>();
+        if(clipboard._size[axis] < 0 || clipboard._size[axis] > MAX_CLIPBOARD_SIZE) {
+            throw std::runtime_error("Corrupt clipboard file: invalid size.");
+        }
+    }
+
+    for(int axis = 0; axis < 3; ++axis) {
+        clipboard._origin[axis] = reader.read<int32_t>();
+    }
+
+    if(clipboard._size.x == 0 || clipboard._size.y == 0 || clipboard._size.z == 0) {
+        clipboard._size = glm::ivec3(0);
+    }
+
+    uint16_t paletteSize = reader.read<uint16_t>();
+    if(paletteSize < 1 || paletteSize > 256) {
+        throw std::runtime_error("Corrupt clipboard file: invalid palette size.");
+    }
+
+    clipboard._palette.resize(paletteSize);
+    reader.readBytes(clipboard._palette.data(), paletteSize);
+    if(clipboard._palette[0] != 0) {
+        throw std::runtime_error("Corrupt clipboard file: palette index 0 has to be empty.");
+    }
+
+    clipboard._brickCounts = (clipboard._size + CLIPBOARD_BRICK_SIZE - 1) / CLIPBOARD_BRICK_SIZE;
+    size_t brickCount = static_cast<size_t>(clipboard._brickCounts.x) * clipboard._brickCounts.y * clipboard._brickCounts.z;
+    if(brickCount > reader.getRemaining() / 2) {
+        throw std::runtime_error("Corrupt clipboard file: brick table larger than the file.");
+    }
+
+    clipboard._bricks.resize(brickCount);
+
+    size_t offset = 0;
+    for(auto& brick : clipboard._bricks) {
+        brick.bits = reader.read<uint8_t>();
+        brick.value = reader.read<uint8_t>();
+        brick.offset = static_cast<uint32_t>(offset);
+
+        if(brick.bits != 0 && brick.bits != 1 && brick.bits != 2 && brick.bits != 4 && brick.bits != 8) {
+            throw std::runtime_error("Corrupt clipboard file: invalid brick bit width.");
+        }
+
+        if(brick.value >= paletteSize) {
+            throw std::runtime_error("Corrupt clipboard file: palette index out of range.");
+        }
+
+        offset += getPackedBrickSize(brick.bits);
+    }
+
+    uint32_t dataSize = reader.read<uint32_t>();
+    if(dataSize != offset) {
+        throw std::runtime_error("Corrupt clipboard file: brick data size mismatch.");
+    }
+
+    clipboard._data.resize(dataSize);
+    reader.readBytes(clipboard._data.data(), dataSize);
+
+    // packed indices are checked against the palette once here, decoding trusts them
+    for(const auto& brick : clipboard._bricks) {
+        if(brick.bits == 0 || paletteSize > (1 << brick.bits)) {
+            continue;
+        }
+
+        const uint8_t* packed = clipboard._data.data() + brick.offset;
+        for(int i = 0; i < CLIPBOARD_BRICK_VOLUME; ++i) {
+            int bit = i * brick.bits;
+            if(((packed[bit >> 3] >> (bit & 7)) & ((1 << brick.bits) - 1)) >= paletteSize) {
+                throw std::runtime_error("Corrupt clipboard file: palette index out of range.");
+            }
+        }
+    }
+
+    clipboard.forEachVoxel([&clipboard](const glm::ivec3&, unsigned char) {
+        clipboard._voxelCount++;
+    });
+
+    return clipboard;
+}
+
+void VoxelClipboard::saveToFile(const std::string& path) const {
+    std::string buffer;
+    saveToBuffer(buffer);
+
+    std::ofstream file(path, std::ios::binary | std::ios::out | std::ios::trunc);
+    if(!file) {
+        throw std::runtime_error("Failed to open file for writing: " + path);
+    }
+
+    file.write(buffer.data(), buffer.size());
+    if(!file) {
+        throw std::runtime_error("Failed to write to file: " + path);
+    }
+}
+
+VoxelClipboard VoxelClipboard::loadFromFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary | std::ios::in);
+    if(!file) {
+        throw std::runtime_error("Failed to open file for reading: " + path);
+    }
+
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+
+    std::string data = buffer.str();
+    return loadFromBuffer(data.data(), data.size());
+}
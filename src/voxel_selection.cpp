@@ -0,0 +1,441 @@
+#include "voxel_selection.hpp"
+#include "world.hpp"
+
+// word and shift of the 16 bits of row y, z within a chunk bitmap
+static inline size_t getRowWord(int localY, int localZ) {
+    return static_cast<size_t>(localZ) * (CHUNK_SIZE * CHUNK_SIZE / 64) + localY / 4;
+}
+
+static inline int getRowShift(int localY) {
+    return (localY % 4) * CHUNK_SIZE;
+}
+
+// the lowest and highest voxel of every row in a word
+const uint64_t ROW_LOW_BITS = 0x0001000100010001ull;
+const uint64_t ROW_HIGH_BITS = 0x8000800080008000ull;
+
+const SelectionBits EMPTY_SELECTION_BITS = {};
+
+// grows min and max, in chunk local coordinates, by the voxels set in word
+static void extendWordBounds(int word, uint64_t bits, glm::ivec3& min, glm::ivec3& max) {
+    // a word is four rows of the same z
+    for(int row = 0; row < 4; ++row) {
+        uint64_t mask = (bits >> (row * CHUNK_SIZE)) & 0xFFFF;
+        if(mask == 0) {
+            continue;
+        }
+
+        int y = (word % 4) * 4 + row;
+        int z = word / 4;
+
+        min = glm::ivec3(std::min(min.x, countTrailingZeros(mask)), std::min(min.y, y), std::min(min.z, z));
+        max = glm::ivec3(std::max(max.x, 63 - countLeadingZeros(mask)), std::max(max.y, y), std::max(max.z, z));
+    }
+}
+
+bool VoxelSelection::contains(int x, int y, int z) const {
+    if(x < 0 || y < 0 || z < 0) {
+        return false;
+    }
+
+    return (getRow(x / CHUNK_SIZE, y, z) >> (x % CHUNK_SIZE)) & 1;
+}
+
+bool VoxelSelection::add(int x, int y, int z) {
+    if(x < 0 || y < 0 || z < 0) {
+        return false;
+    }
+
+    return addRow(x / CHUNK_SIZE, y, z, static_cast<uint16_t>(1u << (x % CHUNK_SIZE))) > 0;
+}
+
+uint16_t VoxelSelection::getRow(int chunkX, int y, int z) const {
+    if(chunkX < 0 || y < 0 || z < 0) {
+        return 0;
+    }
+
+    const SelectionBits* bits = getChunkBits(chunkX, y / CHUNK_SIZE, z / CHUNK_SIZE);
+    if(!bits) {
+        return 0;
+    }
+
+    int localY = y % CHUNK_SIZE;
+    int localZ = z % CHUNK_SIZE;
+
+    return static_cast<uint16_t>((*bits)[getRowWord(localY, localZ)] >> getRowShift(localY));
+}
+
+size_t VoxelSelection::addRow(int chunkX, int y, int z, uint16_t mask) {
+    if(mask == 0 || chunkX < 0 || y < 0 || z < 0) {
+        return 0;
+    }
+
+    int localY = y % CHUNK_SIZE;
+    int localZ = z % CHUNK_SIZE;
+
+    auto& word = getOrCreateChunkBits(chunkX, y / CHUNK_SIZE, z / CHUNK_SIZE)[getRowWord(localY, localZ)];
+    uint64_t added = (static_cast<uint64_t>(mask) << getRowShift(localY)) & ~word;
+    if(added == 0) {
+        return 0;
+    }
+
+    word |= added;
+
+    size_t count = static_cast<size_t>(countSetBits(added));
+    int firstX = chunkX * CHUNK_SIZE + countTrailingZeros(mask);
+    int lastX = chunkX * CHUNK_SIZE + 63 - countLeadingZeros(mask);
+
+    extendBounds(glm::ivec3(firstX, y, z), glm::ivec3(lastX, y, z));
+    _count += count;
+
+    return count;
+}
+
+size_t VoxelSelection::addSpan(int minX, int maxX, int y, int z) {
+    minX = std::max(minX, 0);
+    if(minX > maxX || y < 0 || z < 0) {
+        return 0;
+    }
+
+    size_t added = 0;
+
+    for(int chunkX = minX / CHUNK_SIZE; chunkX <= maxX / CHUNK_SIZE; ++chunkX) {
+        int first = std::max(minX - chunkX * CHUNK_SIZE, 0);
+        int last = std::min(maxX - chunkX * CHUNK_SIZE, CHUNK_SIZE - 1);
+
+        uint32_t mask = ((1u << (last + 1)) - 1) & ~((1u << first) - 1);
+        added += addRow(chunkX, y, z, static_cast<uint16_t>(mask));
+    }
+
+    return added;
+}
+
+size_t VoxelSelection::addChunkBits(const glm::ivec3& chunk, const SelectionBits& bits) {
+    if(chunk.x < 0 || chunk.y < 0 || chunk.z < 0) {
+        return 0;
+    }
+
+    SelectionBits* target = nullptr;
+    size_t added = 0;
+
+    glm::ivec3 min(CHUNK_SIZE);
+    glm::ivec3 max(-1);
+
+    for(int word = 0; word < SELECTION_CHUNK_WORDS; ++word) {
+        if(bits[word] == 0) {
+            continue;
+        }
+
+        if(!target) {
+            target = &getOrCreateChunkBits(chunk.x, chunk.y, chunk.z);
+        }
+
+        uint64_t newBits = bits[word] & ~(*target)[word];
+        if(newBits == 0) {
+            continue;
+        }
+
+        (*target)[word] |= newBits;
+        added += static_cast<size_t>(countSetBits(newBits));
+
+        extendWordBounds(word, newBits, min, max);
+    }
+
+    if(added > 0) {
+        glm::ivec3 base = chunk * CHUNK_SIZE;
+        extendBounds(base + min, base + max);
+        _count += added;
+    }
+
+    return added;
+}
+
+void VoxelSelection::clear() {
+    _chunks.clear();
+    _count = 0;
+    _min = glm::ivec3(0);
+    _max = glm::ivec3(0);
+}
+
+void VoxelSelection::unite(const VoxelSelection& other) {
+    for(const auto& [key, chunk] : other._chunks) {
+        addChunkBits(chunk.coords, chunk.bits);
+    }
+}
+
+void VoxelSelection::intersect(const VoxelSelection& other) {
+    for(auto& [key, chunk] : _chunks) {
+        auto it = other._chunks.find(key);
+        const SelectionBits& otherBits = it != other._chunks.end() ? it->second.bits : EMPTY_SELECTION_BITS;
+
+        for(int word = 0; word < SELECTION_CHUNK_WORDS; ++word) {
+            chunk.bits[word] &= otherBits[word];
+        }
+    }
+
+    recount();
+}
+
+void VoxelSelection::subtract(const VoxelSelection& other) {
+    for(auto& [key, chunk] : _chunks) {
+        auto it = other._chunks.find(key);
+        if(it == other._chunks.end()) {
+            continue;
+        }
+
+        for(int word = 0; word < SELECTION_CHUNK_WORDS; ++word) {
+            chunk.bits[word] &= ~it->second.bits[word];
+        }
+    }
+
+    recount();
+}
+
+void VoxelSelection::invert(const glm::ivec3& min, const glm::ivec3& max) {
+    glm::ivec3 low = glm::max(min, glm::ivec3(0));
+    if(low.x > max.x || low.y > max.y || low.z > max.z) {
+        clear();
+        return;
+    }
+
+    std::unordered_map<uint64_t, SelectionChunk> inverted;
+
+    glm::ivec3 minChunk = low / CHUNK_SIZE;
+    glm::ivec3 maxChunk = max / CHUNK_SIZE;
+
+    for(int chunkZ = minChunk.z; chunkZ <= maxChunk.z; ++chunkZ) {
+        for(int chunkY = minChunk.y; chunkY <= maxChunk.y; ++chunkY) {
+            for(int chunkX = minChunk.x; chunkX <= maxChunk.x; ++chunkX) {
+                glm::ivec3 coords(chunkX, chunkY, chunkZ);
+                glm::ivec3 base = coords * CHUNK_SIZE;
+
+                // the part of the box in this chunk, local coordinates
+                glm::ivec3 first = glm::max(low - base, glm::ivec3(0));
+                glm::ivec3 last = glm::min(max - base, glm::ivec3(CHUNK_SIZE - 1));
+                uint64_t rowMask = ((1u << (last.x + 1)) - 1) & ~((1u << first.x) - 1);
+
+                const SelectionBits* selected = getChunkBits(chunkX, chunkY, chunkZ);
+
+                SelectionChunk chunk;
+                chunk.coords = coords;
+                chunk.bits.fill(0);
+
+                for(int z = first.z; z <= last.z; ++z) {
+                    for(int y = first.y; y <= last.y; ++y) {
+                        chunk.bits[getRowWord(y, z)] |= rowMask << getRowShift(y);
+                    }
+                }
+
+                if(selected) {
+                    for(int word = 0; word < SELECTION_CHUNK_WORDS; ++word) {
+                        chunk.bits[word] &= ~(*selected)[word];
+                    }
+                }
+
+                inverted.emplace(getChunkKey(chunkX, chunkY, chunkZ), chunk);
+            }
+        }
+    }
+
+    _chunks = std::move(inverted);
+    recount();
+}
+
+void VoxelSelection::grow() {
+    morph(true);
+}
+
+void VoxelSelection::shrink() {
+    morph(false);
+}
+
+size_t VoxelSelection::getMemoryUsage() const {
+    return _chunks.size() * sizeof(SelectionChunk);
+}
+
+const SelectionBits* VoxelSelection::getChunkBits(int x, int y, int z) const {
+    auto it = _chunks.find(getChunkKey(x, y, z));
+    if(it == _chunks.end()) {
+        return nullptr;
+    }
+
+    return &it->second.bits;
+}
+
+void VoxelSelection::forEachChunk(const std::function<void(const glm::ivec3& chunk, const SelectionBits& bits)>& action) const {
+    for(const auto& [key, chunk] : _chunks) {
+        action(chunk.coords, chunk.bits);
+    }
+}
+
+void VoxelSelection::forEachVoxel(const std::function<void(const glm::ivec3& voxel)>& action) const {
+    for(const auto& [key, chunk] : _chunks) {
+        glm::ivec3 base = chunk.coords * CHUNK_SIZE;
+
+        for(size_t i = 0; i < SELECTION_CHUNK_WORDS; ++i) {
+            uint64_t word = chunk.bits[i];
+
+            while(word != 0) {
+                int index = static_cast<int>(i * 64) + countTrailingZeros(word);
+                word &= word - 1;
+
+                action(glm::ivec3(
+                    base.x + index % CHUNK_SIZE,
+                    base.y + (index / CHUNK_SIZE) % CHUNK_SIZE,
+                    base.z + index / (CHUNK_SIZE * CHUNK_SIZE)
+                ));
+            }
+        }
+    }
+}
+
+std::vector<glm::ivec3> VoxelSelection::toVector() const {
+    std::vector<glm::ivec3> voxels;
+    voxels.reserve(_count);
+
+    forEachVoxel([&](const glm::ivec3& voxel) {
+        voxels.push_back(voxel);
+    });
+
+    return voxels;
+}
+
+SelectionBits& VoxelSelection::getOrCreateChunkBits(int x, int y, int z) {
+    auto [it, inserted] = _chunks.try_emplace(getChunkKey(x, y, z));
+    if(inserted) {
+        it->second.coords = glm::ivec3(x, y, z);
+        it->second.bits.fill(0);
+    }
+
+    return it->second.bits;
+}
+
+void VoxelSelection::morph(bool grow) {
+    // growing spills into the neighbours of selected chunks
+    std::vector<glm::ivec3> targets;
+    targets.reserve(_chunks.size() * (grow ? 7 : 1));
+
+    for(const auto& [key, chunk] : _chunks) {
+        targets.push_back(chunk.coords);
+
+        if(!grow) {
+            continue;
+        }
+
+        for(int face = 0; face < 6; ++face) {
+            glm::ivec3 neighbor = chunk.coords + FACE_DIRECTIONS[face];
+            if(neighbor.x >= 0 && neighbor.y >= 0 && neighbor.z >= 0 && !_chunks.count(getChunkKey(neighbor.x, neighbor.y, neighbor.z))) {
+                targets.push_back(neighbor);
+            }
+        }
+    }
+
+    auto bitsAt = [&](const glm::ivec3& coords) -> const SelectionBits& {
+        if(coords.x < 0 || coords.y < 0 || coords.z < 0) {
+            return EMPTY_SELECTION_BITS;
+        }
+
+        const SelectionBits* bits = getChunkBits(coords.x, coords.y, coords.z);
+        return bits ? *bits : EMPTY_SELECTION_BITS;
+    };
+
+    std::unordered_map<uint64_t, SelectionChunk> morphed;
+    morphed.reserve(targets.size());
+
+    for(const auto& coords : targets) {
+        auto key = getChunkKey(coords.x, coords.y, coords.z);
+        if(morphed.count(key)) {
+            continue;
+        }
+
+        const SelectionBits& self = bitsAt(coords);
+        const SelectionBits& left = bitsAt(coords - glm::ivec3(1, 0, 0));
+        const SelectionBits& right = bitsAt(coords + glm::ivec3(1, 0, 0));
+        const SelectionBits& bottom = bitsAt(coords - glm::ivec3(0, 1, 0));
+        const SelectionBits& top = bitsAt(coords + glm::ivec3(0, 1, 0));
+        const SelectionBits& front = bitsAt(coords - glm::ivec3(0, 0, 1));
+        const SelectionBits& back = bitsAt(coords + glm::ivec3(0, 0, 1));
+
+        SelectionChunk chunk;
+        chunk.coords = coords;
+
+        bool any = false;
+        for(int word = 0; word < SELECTION_CHUNK_WORDS; ++word) {
+            int z = word / 4;
+            int quarter = word % 4;
+            uint64_t bits = self[word];
+
+            // each is the bit of the face neighbour on that side, per voxel
+            uint64_t fromLeft = ((bits << 1) & ~ROW_LOW_BITS) | ((left[word] >> 15) & ROW_LOW_BITS);
+            uint64_t fromRight = ((bits >> 1) & ~ROW_HIGH_BITS) | ((right[word] << 15) & ROW_HIGH_BITS);
+            uint64_t fromBelow = (bits << CHUNK_SIZE) | ((quarter > 0 ? self[word - 1] : bottom[z * 4 + 3]) >> 48);
+            uint64_t fromAbove = (bits >> CHUNK_SIZE) | ((quarter < 3 ? self[word + 1] : top[z * 4]) << 48);
+            uint64_t fromFront = z > 0 ? self[word - 4] : front[(CHUNK_SIZE - 1) * 4 + quarter];
+            uint64_t fromBack = z < CHUNK_SIZE - 1 ? self[word + 4] : back[quarter];
+
+            if(grow) {
+                chunk.bits[word] = bits | fromLeft | fromRight | fromBelow | fromAbove | fromFront | fromBack;
+            } else {
+                chunk.bits[word] = bits & fromLeft & fromRight & fromBelow & fromAbove & fromFront & fromBack;
+            }
+
+            any |= chunk.bits[word] != 0;
+        }
+
+        if(any) {
+            morphed.emplace(key, chunk);
+        }
+    }
+
+    _chunks = std::move(morphed);
+    recount();
+}
+
+void VoxelSelection::recount() {
+    _count = 0;
+
+    for(auto it = _chunks.begin(); it != _chunks.end();) {
+        glm::ivec3 min(CHUNK_SIZE);
+        glm::ivec3 max(-1);
+        size_t count = 0;
+
+        for(int word = 0; word < SELECTION_CHUNK_WORDS; ++word) {
+            uint64_t bits = it->second.bits[word];
+            if(bits != 0) {
+                count += static_cast<size_t>(countSetBits(bits));
+                extendWordBounds(word, bits, min, max);
+            }
+        }
+
+        if(count == 0) {
+            it = _chunks.erase(it);
+            continue;
+        }
+
+        glm::ivec3 base = it->second.coords * CHUNK_SIZE;
+        extendBounds(base + min, base + max);
+        _count += count;
+
+        ++it;
+    }
+
+    if(_count == 0) {
+        _min = glm::ivec3(0);
+        _max = glm::ivec3(0);
+    }
+}
+
+void VoxelSelection::extendBounds(const glm::ivec3& min, const glm::ivec3& max) {
+    if(_count == 0) {
+        _min = min;
+        _max = max;
+        return;
+    }
+
+    _min.x = std::min(_min.x, min.x);
+    _min.y = std::min(_min.y, min.y);
+    _min.z = std::min(_min.z, min.z);
+    _max.x = std::max(_max.x, max.x);
+    _max.y = std::max(_max.y, max.y);
+    _max.z = std::max(_max.z, max.z);
+}
@@ -0,0 +1,445 @@
+#include "voxel_shape.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// margin on the culling tests for float rounding
+const float SHAPE_CULL_EPSILON = 1e-3f;
+
+static float length2(float x, float y) {
+    return std::sqrt(x * x + y * y);
+}
+
+static float length3(float x, float y, float z) {
+    return std::sqrt(x * x + y * y + z * z);
+}
+
+// polynomial smooth minimum, within smoothness of each other the two blend
+static float smoothMin(float a, float b, float smoothness) {
+    if(smoothness <= 0.0f) {
+        return std::min(a, b);
+    }
+
+    float h = std::max(smoothness - std::abs(a - b), 0.0f) / smoothness;
+    return std::min(a, b) - h * h * smoothness * 0.25f;
+}
+
+VoxelShape VoxelShape::sphere(const glm::vec3& center, float radius) {
+    Node node;
+    node.primitive = ShapePrimitive::PRIMITIVE_SPHERE;
+    node.a = center;
+    node.radius = radius;
+    node.boundsMin = center - glm::vec3(radius);
+    node.boundsMax = center + glm::vec3(radius);
+
+    return primitive(node);
+}
+
+VoxelShape VoxelShape::box(const glm::vec3& center, const glm::vec3& halfSize) {
+    Node node;
+    node.primitive = ShapePrimitive::PRIMITIVE_BOX;
+    node.a = center;
+    node.b = halfSize;
+    node.boundsMin = center - halfSize;
+    node.boundsMax = center + halfSize;
+
+    return primitive(node);
+}
+
+VoxelShape VoxelShape::cylinder(const glm::vec3& center, float radius, float halfHeight) {
+    Node node;
+    node.primitive = ShapePrimitive::PRIMITIVE_CYLINDER;
+    node.a = center;
+    node.radius = radius;
+    node.size = halfHeight;
+    node.boundsMin = center - glm::vec3(radius, halfHeight, radius);
+    node.boundsMax = center + glm::vec3(radius, halfHeight, radius);
+
+    return primitive(node);
+}
+
+VoxelShape VoxelShape::cone(const glm::vec3& baseCenter, float radius, float height) {
+    Node node;
+    node.primitive = ShapePrimitive::PRIMITIVE_CONE;
+    // evaluated around the middle of its height
+    node.a = baseCenter + glm::vec3(0.0f, height * 0.5f, 0.0f);
+    node.radius = radius;
+    node.size = height * 0.5f;
+    node.boundsMin = baseCenter - glm::vec3(radius, 0.0f, radius);
+    node.boundsMax = baseCenter + glm::vec3(radius, height, radius);
+
+    return primitive(node);
+}
+
+VoxelShape VoxelShape::capsule(const glm::vec3& start, const glm::vec3& end, float radius) {
+    Node node;
+    node.primitive = ShapePrimitive::PRIMITIVE_CAPSULE;
+    node.a = start;
+    node.b = end;
+    node.radius = radius;
+    node.boundsMin = glm::min(start, end) - glm::vec3(radius);
+    node.boundsMax = glm::max(start, end) + glm::vec3(radius);
+
+    return primitive(node);
+}
+
+VoxelShape VoxelShape::torus(const glm::vec3& center, float majorRadius, float minorRadius) {
+    Node node;
+    node.primitive = ShapePrimitive::PRIMITIVE_TORUS;
+    node.a = center;
+    node.radius = majorRadius;
+    node.size = minorRadius;
+
+    glm::vec3 extent(majorRadius + minorRadius, minorRadius, majorRadius + minorRadius);
+    node.boundsMin = center - extent;
+    node.boundsMax = center + extent;
+
+    return primitive(node);
+}
+
+VoxelShape VoxelShape::unite(const VoxelShape& other, float smoothness) const {
+    return combine(other, ShapeOperation::OPERATION_UNION, smoothness);
+}
+
+VoxelShape VoxelShape::subtract(const VoxelShape& other, float smoothness) const {
+    return combine(other, ShapeOperation::OPERATION_SUBTRACT, smoothness);
+}
+
+VoxelShape VoxelShape::intersect(const VoxelShape& other, float smoothness) const {
+    return combine(other, ShapeOperation::OPERATION_INTERSECT, smoothness);
+}
+
+VoxelShape VoxelShape::primitive(const Node& node) {
+    VoxelShape shape;
+    shape._nodes.push_back(node);
+    shape._nodes.back().type = NodeType::NODE_PRIMITIVE;
+
+    return shape;
+}
+
+VoxelShape VoxelShape::combine(const VoxelShape& other, ShapeOperation operation, float smoothness) const {
+    VoxelShape shape = *this;
+
+    size_t offset = shape._nodes.size();
+    for(Node node : other._nodes) {
+        if(node.type == NodeType::NODE_OPERATION) {
+            node.left += offset;
+            node.right += offset;
+        }
+
+        shape._nodes.push_back(node);
+    }
+
+    const Node& left = _nodes.back();
+    const Node& right = other._nodes.back();
+
+    Node node;
+    node.type = NodeType::NODE_OPERATION;
+    node.operation = operation;
+    node.left = offset - 1;
+    node.right = shape._nodes.size() - 1;
+    node.smoothness = smoothness;
+
+    if(operation == ShapeOperation::OPERATION_UNION) {
+        // a smooth union fills in up to a quarter of the smoothness
+        glm::vec3 blend(std::max(smoothness, 0.0f) * 0.25f);
+        node.boundsMin = glm::min(left.boundsMin, right.boundsMin) - blend;
+        node.boundsMax = glm::max(left.boundsMax, right.boundsMax) + blend;
+    } else if(operation == ShapeOperation::OPERATION_INTERSECT) {
+        node.boundsMin = glm::max(left.boundsMin, right.boundsMin);
+        node.boundsMax = glm::min(left.boundsMax, right.boundsMax);
+    } else {
+        node.boundsMin = left.boundsMin;
+        node.boundsMax = left.boundsMax;
+    }
+
+    shape._nodes.push_back(node);
+
+    return shape;
+}
+
+float VoxelShape::getDistance(const glm::vec3& point) const {
+    if(_nodes.empty()) {
+        return std::numeric_limits<float>::infinity();
+    }
+
+    return evaluate(_nodes.size() - 1, point.x, point.y, point.z);
+}
+
+bool VoxelShape::getBounds(glm::ivec3& outMin, glm::ivec3& outMax) const {
+    if(_nodes.empty()) {
+        return false;
+    }
+
+    const Node& root = _nodes.back();
+    outMin = glm::ivec3(
+        static_cast<int>(std::floor(root.boundsMin.x)),
+        static_cast<int>(std::floor(root.boundsMin.y)),
+        static_cast<int>(std::floor(root.boundsMin.z))
+    );
+    outMax = glm::ivec3(
+        static_cast<int>(std::ceil(root.boundsMax.x)),
+        static_cast<int>(std::ceil(root.boundsMax.y)),
+        static_cast<int>(std::ceil(root.boundsMax.z))
+    );
+
+    return outMin.x <= outMax.x && outMin.y <= outMax.y && outMin.z <= outMax.z;
+}
+
+VoxelSelection VoxelShape::select(core::ThreadPool* pool) const {
+    VoxelSelection selection;
+
+    glm::ivec3 min, max;
+    if(!getBounds(min, max) || max.x < 0 || max.y < 0 || max.z < 0) {
+        return selection;
+    }
+
+    glm::ivec3 minChunk = glm::max(min, glm::ivec3(0)) / CHUNK_SIZE;
+    glm::ivec3 maxChunk = max / CHUNK_SIZE;
+
+    std::vector<glm::ivec3> inside;
+    std::vector<glm::ivec3> surface;
+    cullChunks(minChunk, maxChunk, inside, surface);
+
+    SelectionBits full;
+    full.fill(~0ull);
+    for(const auto& chunk : inside) {
+        selection.addChunkBits(chunk, full);
+    }
+
+    std::vector<SelectionBits> surfaceBits(surface.size());
+    auto evaluateRange = [&](size_t begin, size_t end) {
+        for(size_t i = begin; i < end; ++i) {
+            evaluateChunk(surface[i], surfaceBits[i]);
+        }
+    };
+
+    if(pool && surface.size() > 1) {
+        pool->parallelFor(surface.size(), evaluateRange);
+    } else {
+        evaluateRange(0, surface.size());
+    }
+
+    for(size_t i = 0; i < surface.size(); ++i) {
+        selection.addChunkBits(surface[i], surfaceBits[i]);
+    }
+
+    return selection;
+}
+
+void VoxelShape::forEachSpan(const std::function<void(int minX, int maxX, int y, int z)>& action) const {
+    glm::ivec3 min, max;
+    if(!getBounds(min, max)) {
+        return;
+    }
+
+    float rowCenter = (min.x + max.x) * 0.5f;
+    float rowHalfLength = (max.x - min.x) * 0.5f;
+
+    for(int z = min.z; z <= max.z; ++z) {
+        for(int y = min.y; y <= max.y; ++y) {
+            float fy = static_cast<float>(y);
+            float fz = static_cast<float>(z);
+
+            if(evaluate(_nodes.size() - 1, rowCenter, fy, fz) > rowHalfLength + SHAPE_CULL_EPSILON) {
+                continue;
+            }
+
+            int runStart = 0;
+            bool inRun = false;
+
+            for(int x = min.x; x <= max.x; ++x) {
+                bool inside = evaluate(_nodes.size() - 1, static_cast<float>(x), fy, fz) <= 0.0f;
+
+                if(inside && !inRun) {
+                    runStart = x;
+                    inRun = true;
+                } else if(!inside && inRun) {
+                    action(runStart, x - 1, y, z);
+                    inRun = false;
+                }
+            }
+
+            if(inRun) {
+                action(runStart, max.x, y, z);
+            }
+        }
+    }
+}
+
+float VoxelShape::evaluate(size_t index, float x, float y, float z) const {
+    const Node& node = _nodes[index];
+
+    if(node.type == NodeType::NODE_OPERATION) {
+        float left = evaluate(node.left, x, y, z);
+        float right = evaluate(node.right, x, y, z);
+
+        switch(node.operation) {
+            case ShapeOperation::OPERATION_UNION:
+                return smoothMin(left, right, node.smoothness);
+            case ShapeOperation::OPERATION_SUBTRACT:
+                return -smoothMin(-left, right, node.smoothness);
+            case ShapeOperation::OPERATION_INTERSECT:
+                return -smoothMin(-left, -right, node.smoothness);
+        }
+
+        return left;
+    }
+
+    float px = x - node.a.x;
+    float py = y - node.a.y;
+    float pz = z - node.a.z;
+
+    switch(node.primitive) {
+        case ShapePrimitive::PRIMITIVE_SPHERE:
+            return length3(px, py, pz) - node.radius;
+
+        case ShapePrimitive::PRIMITIVE_BOX: {
+            float qx = std::abs(px) - node.b.x;
+            float qy = std::abs(py) - node.b.y;
+            float qz = std::abs(pz) - node.b.z;
+
+            float outside = length3(std::max(qx, 0.0f), std::max(qy, 0.0f), std::max(qz, 0.0f));
+            float inside = std::min(std::max(qx, std::max(qy, qz)), 0.0f);
+            return outside + inside;
+        }
+
+        case ShapePrimitive::PRIMITIVE_CYLINDER: {
+            float dx = length2(px, pz) - node.radius;
+            float dy = std::abs(py) - node.size;
+
+            return std::min(std::max(dx, dy), 0.0f) + length2(std::max(dx, 0.0f), std::max(dy, 0.0f));
+        }
+
+        case ShapePrimitive::PRIMITIVE_CONE: {
+            // capped cone from radius at -size to a point at +size
+            float halfHeight = node.size;
+            float radius = node.radius;
+
+            float qx = length2(px, pz);
+            float qy = py;
+
+            // closest point on the cap
+            float capX = qx - std::min(qx, qy < 0.0f ? radius : 0.0f);
+            float capY = std::abs(qy) - halfHeight;
+
+            // closest point on the slanted side, from the apex (0, h) along (-r, 2h)
+            float sideX = -radius;
+            float sideY = 2.0f * halfHeight;
+            float sideLengthSquared = sideX * sideX + sideY * sideY;
+            float t = sideLengthSquared > 0.0f ? std::clamp(((0.0f - qx) * sideX + (halfHeight - qy) * sideY) / sideLengthSquared, 0.0f, 1.0f) : 0.0f;
+            float slantX = qx + sideX * t;
+            float slantY = qy - halfHeight + sideY * t;
+
+            float sign = (slantX < 0.0f && capY < 0.0f) ? -1.0f : 1.0f;
+            return sign * std::sqrt(std::min(capX * capX + capY * capY, slantX * slantX + slantY * slantY));
+        }
+
+        case ShapePrimitive::PRIMITIVE_CAPSULE: {
+            float dx = node.b.x - node.a.x;
+            float dy = node.b.y - node.a.y;
+            float dz = node.b.z - node.a.z;
+
+            float lengthSquared = dx * dx + dy * dy + dz * dz;
+            float t = lengthSquared > 0.0f ? std::clamp((px * dx + py * dy + pz * dz) / lengthSquared, 0.0f, 1.0f) : 0.0f;
+
+            return length3(px - dx * t, py - dy * t, pz - dz * t) - node.radius;
+        }
+
+        case ShapePrimitive::PRIMITIVE_TORUS:
+            return length2(length2(px, pz) - node.radius, py) - node.size;
+    }
+
+    return std::numeric_limits<float>::infinity();
+}
+
+void VoxelShape::evaluateChunk(const glm::ivec3& chunk, SelectionBits& outBits) const {
+    outBits.fill(0);
+
+    const size_t root = _nodes.size() - 1;
+    const float brickHalfDiagonal = (SHAPE_BRICK_SIZE - 1) * 0.5f * std::sqrt(3.0f);
+    const uint64_t brickRow = (1ull << SHAPE_BRICK_SIZE) - 1;
+
+    glm::ivec3 base = chunk * CHUNK_SIZE;
+
+    for(int brickZ = 0; brickZ < CHUNK_SIZE; brickZ += SHAPE_BRICK_SIZE) {
+        for(int brickY = 0; brickY < CHUNK_SIZE; brickY += SHAPE_BRICK_SIZE) {
+            for(int brickX = 0; brickX < CHUNK_SIZE; brickX += SHAPE_BRICK_SIZE) {
+                float center = (SHAPE_BRICK_SIZE - 1) * 0.5f;
+                float distance = evaluate(root, base.x + brickX + center, base.y + brickY + center, base.z + brickZ + center);
+
+                if(distance > brickHalfDiagonal + SHAPE_CULL_EPSILON) {
+                    continue;
+                }
+
+                bool full = distance < -brickHalfDiagonal - SHAPE_CULL_EPSILON;
+
+                for(int z = brickZ; z < brickZ + SHAPE_BRICK_SIZE; ++z) {
+                    for(int y = brickY; y < brickY + SHAPE_BRICK_SIZE; ++y) {
+                        int row = z * CHUNK_SIZE + y;
+                        uint64_t& word = outBits[row / 4];
+                        int shift = (row % 4) * CHUNK_SIZE + brickX;
+
+                        if(full) {
+                            word |= brickRow << shift;
+                            continue;
+                        }
+
+                        for(int x = brickX; x < brickX + SHAPE_BRICK_SIZE; ++x) {
+                            if(evaluate(root, static_cast<float>(base.x + x), static_cast<float>(base.y + y), static_cast<float>(base.z + z)) <= 0.0f) {
+                                word |= 1ull << (shift + x - brickX);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+void VoxelShape::cullChunks(const glm::ivec3& min, const glm::ivec3& max, std::vector<glm::ivec3>& outInside, std::vector<glm::ivec3>& outSurface) const {
+    glm::vec3 low(min * CHUNK_SIZE);
+    glm::vec3 high(max * CHUNK_SIZE + CHUNK_SIZE - 1);
+
+    glm::vec3 center = (low + high) * 0.5f;
+    glm::vec3 extent = high - low;
+    float halfDiagonal = 0.5f * length3(extent.x, extent.y, extent.z);
+
+    float distance = evaluate(_nodes.size() - 1, center.x, center.y, center.z);
+
+    if(distance > halfDiagonal + SHAPE_CULL_EPSILON) {
+        return;
+    }
+
+    if(distance < -halfDiagonal - SHAPE_CULL_EPSILON) {
+        for(int z = min.z; z <= max.z; ++z) {
+            for(int y = min.y; y <= max.y; ++y) {
+                for(int x = min.x; x <= max.x; ++x) {
+                    outInside.emplace_back(x, y, z);
+                }
+            }
+        }
+
+        return;
+    }
+
+    glm::ivec3 size = max - min;
+    if(size == glm::ivec3(0)) {
+        outSurface.push_back(min);
+        return;
+    }
+
+    // halve the longest side
+    int axis = 0;
+    if(size.y > size[axis]) axis = 1;
+    if(size.z > size[axis]) axis = 2;
+
+    glm::ivec3 splitMax = max;
+    glm::ivec3 splitMin = min;
+    splitMax[axis] = min[axis] + size[axis] / 2;
+    splitMin[axis] = splitMax[axis] + 1;
+
+    cullChunks(min, splitMax, outInside, outSurface);
+    cullChunks(splitMin, max, outInside, outSurface);
+}
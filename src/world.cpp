@@ -1,5 +1,6 @@
 #include "world.hpp"
 #include "world_asset.hpp"
+#include "engine/core/filesystem.hpp"
 
 #include <iostream>
 
@@ -14,9 +15,18 @@ Chunk* World::createChunk(int x, int y, int z) {
         return nullptr;
     }
 
+    if(_chunkEditCallback) {
+        _chunkEditCallback(glm::ivec3(x, y, z), getChunk(x, y, z));
+    }
+
     auto key = getChunkKey(x, y, z);
     auto chunk = std::make_unique<Chunk>(x, y, z, this);
     _chunks[key] = std::move(chunk);
+    _regionChunkRevisions.erase(key);
+
+    if(_region) {
+        _consumedRegionChunks.insert(key);
+    }
 
     return _chunks[key].get();
 }
@@ -26,15 +36,50 @@ void World::removeChunk(int x, int y, int z) {
         return;
     }
 
+    if(_chunkEditCallback) {
+        _chunkEditCallback(glm::ivec3(x, y, z), getChunk(x, y, z));
+    }
+
     auto key = getChunkKey(x, y, z);
     _chunks.erase(key);
+    _regionChunkRevisions.erase(key);
+    _removedChunks[key] = glm::ivec3(x, y, z);
+
+    if(_region) {
+        _consumedRegionChunks.insert(key);
+    }
 }
 
 void World::removeAllChunks() {
+    for(const auto& [key, chunk] : _chunks) {
+        _removedChunks[key] = glm::ivec3(chunk->getX(), chunk->getY(), chunk->getZ());
+    }
+
+    if(_region) {
+        for(size_t i = 0; i < _region->getChunkCount(); ++i) {
+            auto coords = _region->getChunkCoords(i);
+            _removedChunks[getChunkKey(coords.x, coords.y, coords.z)] = coords;
+        }
+    }
+
     _chunks.clear();
+
+    _region.reset();
+    _consumedRegionChunks.clear();
+    _regionChunkRevisions.clear();
+    _blockArrays.clear();
 }
 
 Chunk* World::getChunk(int x, int y, int z) const {
+    Chunk* chunk = getLoadedChunk(x, y, z);
+    if(chunk || !_region) {
+        return chunk;
+    }
+
+    return loadRegionChunk(x, y, z);
+}
+
+Chunk* World::getLoadedChunk(int x, int y, int z) const {
     if(x < 0 || y < 0 || z < 0) {
         return nullptr;
     }
@@ -48,6 +93,407 @@ Chunk* World::getChunk(int x, int y, int z) const {
     return nullptr;
 }
 
+void World::setRegion(std::unique_ptr<WorldRegion> region) {
+    _region = std::move(region);
+    _consumedRegionChunks.clear();
+    _regionChunkRevisions.clear();
+
+    // chunks already in memory win over the region
+    if(_region) {
+        for(const auto& [key, chunk] : _chunks) {
+            _consumedRegionChunks.insert(key);
+        }
+    }
+}
+
+WorldSnapshot World::takeSnapshot() const {
+    WorldSnapshot snapshot;
+    snapshot.chunks.reserve(_chunks.size());
+
+    for(const auto& [key, chunk] : _chunks) {
+        snapshot.chunks.push_back({ chunk->getX(), chunk->getY(), chunk->getZ(), chunk->getRevision(), chunk->shareBlocks() });
+    }
+
+    if(_region) {
+        snapshot.name = _region->getName();
+        snapshot.region = _region;
+
+        for(size_t i = 0; i < _region->getChunkCount(); ++i) {
+            auto coords = _region->getChunkCoords(i);
+            if(_consumedRegionChunks.find(getChunkKey(coords.x, coords.y, coords.z)) == _consumedRegionChunks.end()) {
+                snapshot.regionChunks.push_back(i);
+            }
+        }
+    }
+
+    for(const auto& [key, coords] : _removedChunks) {
+        if(_chunks.find(key) == _chunks.end()) {
+            snapshot.removedChunks.push_back(coords);
+        }
+    }
+
+    return snapshot;
+}
+
+WorldSnapshot World::takeChanges() {
+    WorldSnapshot changes;
+
+    for(const auto& [key, chunk] : _chunks) {
+        if(!chunk->isModified()) {
+            continue;
+        }
+
+        changes.chunks.push_back({ chunk->getX(), chunk->getY(), chunk->getZ(), chunk->getRevision(), chunk->shareBlocks() });
+        chunk->markSaved();
+    }
+
+    changes.removedChunks.reserve(_removedChunks.size());
+    for(const auto& [key, coords] : _removedChunks) {
+        changes.removedChunks.push_back(coords);
+    }
+
+    _removedChunks.clear();
+
+    return changes;
+}
+
+void World::clearChanges() {
+    for(const auto& [key, chunk] : _chunks) {
+        chunk->markSaved();
+    }
+
+    _removedChunks.clear();
+}
+
+void World::markSnapshotSaved(const WorldSnapshot& snapshot) {
+    // revisions are unique, an equal one means the chunk wasn't edited since
+    for(const auto& entry : snapshot.chunks) {
+        auto it = _chunks.find(getChunkKey(entry.x, entry.y, entry.z));
+        if(it != _chunks.end() && it->second->getRevision() == entry.revision) {
+            it->second->markSaved();
+        }
+    }
+
+    // chunks created again since are in the world and saved with it
+    for(const auto& coords : snapshot.removedChunks) {
+        uint64_t key = getChunkKey(coords.x, coords.y, coords.z);
+        if(_chunks.find(key) == _chunks.end()) {
+            _removedChunks.erase(key);
+        }
+    }
+}
+
+void World::adoptSavedRegion(std::unique_ptr<WorldRegion> region, const WorldSnapshot& snapshot) {
+    // worlds without a region didn't track these
+    for(const auto& [key, chunk] : _chunks) {
+        _consumedRegionChunks.insert(key);
+    }
+
+    for(const auto& [key, coords] : _removedChunks) {
+        _consumedRegionChunks.insert(key);
+    }
+
+    _region = std::move(region);
+
+    // older entries stay valid, a chunk streamed in during the save is the same in the new file
+    for(const auto& entry : snapshot.chunks) {
+        auto key = getChunkKey(entry.x, entry.y, entry.z);
+        auto it = _chunks.find(key);
+        if(it != _chunks.end() && it->second->getRevision() == entry.revision) {
+            _regionChunkRevisions[key] = entry.revision;
+        }
+    }
+}
+
+Chunk* World::loadRegionChunk(int x, int y, int z) const {
+    if(!isRegionChunkAvailable(x, y, z)) {
+        return nullptr;
+    }
+
+    ChunkBlocks blocks;
+    if(!_region->readChunk(x, y, z, blocks.data())) {
+        return nullptr;
+    }
+
+    return installRegionChunk(x, y, z, blocks.data());
+}
+
+bool World::isRegionChunkAvailable(int x, int y, int z) const {
+    if(!_region || x < 0 || y < 0 || z < 0) {
+        return false;
+    }
+
+    return _consumedRegionChunks.find(getChunkKey(x, y, z)) == _consumedRegionChunks.end();
+}
+
+Chunk* World::installRegionChunk(int x, int y, int z, const unsigned char* blocks) const {
+    if(!isRegionChunkAvailable(x, y, z)) {
+        return nullptr;
+    }
+
+    auto key = getChunkKey(x, y, z);
+    _consumedRegionChunks.insert(key);
+
+    // the region is an implementation detail of lookups, so loading a chunk
+    // is allowed from const accessors
+    auto chunk = std::make_unique<Chunk>(x, y, z, const_cast<World*>(this));
+    chunk->assignBlocks(blocks);
+    // same as on disk
+    chunk->markSaved();
+
+    if(_deduplicateChunks) {
+        deduplicateChunk(chunk.get());
+    }
+
+    _regionChunkRevisions[key] = chunk->getRevision();
+
+    Chunk* result = chunk.get();
+    _chunks[key] = std::move(chunk);
+
+    // neighbours meshed their border against air until now
+    markNeighborsDirty(x, y, z);
+
+    return result;
+}
+
+bool World::unloadChunk(int x, int y, int z) {
+    Chunk* chunk = getLoadedChunk(x, y, z);
+    if(!chunk) {
+        return false;
+    }
+
+    auto key = getChunkKey(x, y, z);
+    auto it = _regionChunkRevisions.find(key);
+    if(it == _regionChunkRevisions.end() || it->second != chunk->getRevision()) {
+        return false;
+    }
+
+    _regionChunkRevisions.erase(it);
+    _consumedRegionChunks.erase(key);
+    _chunks.erase(key);
+
+    markNeighborsDirty(x, y, z);
+
+    return true;
+}
+
+size_t World::loadAllRegionChunks(core::ThreadPool& pool) {
+    if(!_region) {
+        return 0;
+    }
+
+    std::vector<size_t> indices;
+    std::vector<glm::ivec3> coords;
+
+    for(size_t i = 0; i < _region->getChunkCount(); ++i) {
+        auto chunkCoords = _region->getChunkCoords(i);
+        if(isRegionChunkAvailable(chunkCoords.x, chunkCoords.y, chunkCoords.z)) {
+            indices.push_back(i);
+            coords.push_back(chunkCoords);
+        }
+    }
+
+    std::vector<std::unique_ptr<Chunk>> chunks(indices.size());
+
+    pool.parallelFor(indices.size(), [&](size_t begin, size_t end) {
+        for(size_t i = begin; i < end; ++i) {
+            auto chunk = std::make_unique<Chunk>(coords[i].x, coords[i].y, coords[i].z, this);
+            chunk->fillBlocks([&](unsigned char* blocks) {
+                _region->readChunkAt(indices[i], blocks);
+            });
+
+            // same as on disk
+            chunk->markSaved();
+            if(_deduplicateChunks) {
+                // hashed here, on the pool, the lookups happen below
+                chunk->getBlocksHash();
+            }
+
+            chunks[i] = std::move(chunk);
+        }
+    });
+
+    bool hadChunks = !_chunks.empty();
+    _chunks.reserve(_chunks.size() + chunks.size());
+
+    for(auto& chunk : chunks) {
+        auto key = getChunkKey(chunk->getX(), chunk->getY(), chunk->getZ());
+
+        if(_deduplicateChunks) {
+            deduplicateChunk(chunk.get());
+        }
+
+        _consumedRegionChunks.insert(key);
+        _regionChunkRevisions[key] = chunk->getRevision();
+        _chunks[key] = std::move(chunk);
+    }
+
+    // chunks loaded before meshed their border against air
+    if(hadChunks) {
+        for(const auto& chunkCoords : coords) {
+            markNeighborsDirty(chunkCoords.x, chunkCoords.y, chunkCoords.z);
+        }
+    }
+
+    return chunks.size();
+}
+
+size_t World::fillChunks(const std::vector<glm::ivec3>& coords, const std::function<bool(const glm::ivec3& coords, unsigned char* blocks)>& fill, core::ThreadPool& pool) {
+    std::vector<std::unique_ptr<Chunk>> chunks(coords.size());
+
+    pool.parallelFor(coords.size(), [&](size_t begin, size_t end) {
+        for(size_t i = begin; i < end; ++i) {
+            if(coords[i].x < 0 || coords[i].y < 0 || coords[i].z < 0) {
+                continue;
+            }
+
+            auto chunk = std::make_unique<Chunk>(coords[i].x, coords[i].y, coords[i].z, this);
+
+            bool keep = false;
+            chunk->fillBlocks([&](unsigned char* blocks) {
+                keep = fill(coords[i], blocks);
+            });
+
+            if(!keep || chunk->getBlockCount() == 0) {
+                continue;
+            }
+
+            if(_deduplicateChunks) {
+                // hashed here, on the pool, the lookups happen below
+                chunk->getBlocksHash();
+            }
+
+            chunks[i] = std::move(chunk);
+        }
+    });
+
+    bool hadChunks = !_chunks.empty();
+    _chunks.reserve(_chunks.size() + chunks.size());
+
+    size_t filled = 0;
+    std::vector<glm::ivec3> changed;
+
+    for(size_t i = 0; i < coords.size(); ++i) {
+        const auto& chunkCoords = coords[i];
+        if(chunkCoords.x < 0 || chunkCoords.y < 0 || chunkCoords.z < 0) {
+            continue;
+        }
+
+        auto key = getChunkKey(chunkCoords.x, chunkCoords.y, chunkCoords.z);
+
+        // only existing chunks need to be looked up, for the edit callback
+        // and to remove the ones left as air
+        Chunk* previous = (hadChunks || _region) ? getChunk(chunkCoords.x, chunkCoords.y, chunkCoords.z) : nullptr;
+        if(!chunks[i] && !previous) {
+            continue;
+        }
+
+        if(_chunkEditCallback) {
+            _chunkEditCallback(chunkCoords, previous);
+        }
+
+        if(_region) {
+            _consumedRegionChunks.insert(key);
+        }
+        _regionChunkRevisions.erase(key);
+
+        if(chunks[i]) {
+            if(_deduplicateChunks) {
+                deduplicateChunk(chunks[i].get());
+            }
+
+            _chunks[key] = std::move(chunks[i]);
+            _removedChunks.erase(key);
+            filled++;
+        } else {
+            _chunks.erase(key);
+            _removedChunks[key] = chunkCoords;
+        }
+
+        changed.push_back(chunkCoords);
+    }
+
+    // chunks that were there before meshed their border against the old blocks
+    if(hadChunks) {
+        for(const auto& chunkCoords : changed) {
+            markNeighborsDirty(chunkCoords.x, chunkCoords.y, chunkCoords.z);
+        }
+    }
+
+    return filled;
+}
+
+void World::setChunkEditCallback(std::function<void(const glm::ivec3& coords, const Chunk* chunk)> callback) {
+    _chunkEditCallback = std::move(callback);
+}
+
+void World::setChunkDeduplication(bool enabled) {
+    _deduplicateChunks = enabled;
+
+    if(enabled) {
+        deduplicateChunks();
+    } else {
+        _blockArrays.clear();
+    }
+}
+
+size_t World::deduplicateChunks() {
+    // rebuilt from the chunks as they are now, entries for arrays edited
+    // since they were added would only miss
+    _blockArrays.clear();
+
+    size_t shared = 0;
+    for(const auto& [key, chunk] : _chunks) {
+        shared += deduplicateChunk(chunk.get());
+    }
+
+    return shared;
+}
+
+bool World::deduplicateChunk(Chunk* chunk) const {
+    auto& entry = _blockArrays[chunk->getBlocksHash()];
+    auto blocks = entry.lock();
+    auto current = chunk->shareBlocks();
+
+    if(blocks == current) {
+        return false;
+    }
+
+    if(blocks && chunk->adoptBlocks(blocks)) {
+        return true;
+    }
+
+    // nothing to share yet, or a different array with the same hash
+    entry = current;
+    return false;
+}
+
+WorldStorageStats World::getStorageStats() const {
+    std::unordered_set<const ChunkBlocks*> arrays;
+    arrays.reserve(_chunks.size());
+
+    for(const auto& [key, chunk] : _chunks) {
+        arrays.insert(&chunk->getBlocks());
+    }
+
+    WorldStorageStats stats;
+    stats.chunkCount = _chunks.size();
+    stats.blockArrayCount = arrays.size();
+    stats.blockBytes = arrays.size() * sizeof(ChunkBlocks);
+    stats.savedBytes = (stats.chunkCount - stats.blockArrayCount) * sizeof(ChunkBlocks);
+
+    return stats;
+}
+
+void World::markNeighborsDirty(int x, int y, int z) const {
+    for(int face = 0; face < 6; ++face) {
+        Chunk* neighbor = getLoadedChunk(x + FACE_DIRECTIONS[face].x, y + FACE_DIRECTIONS[face].y, z + FACE_DIRECTIONS[face].z);
+        if(neighbor) {
+            neighbor->setDirty(true);
+        }
+    }
+}
+
 Chunk* World::getChunkContainingBlock(int x, int y, int z) const {
     if(x < 0 || y < 0 || z < 0) {
         return nullptr;
@@ -95,7 +541,30 @@ void World::setBlock(int x, int y, int z, unsigned char blockId) {
     int localY = y % CHUNK_SIZE;
     int localZ = z % CHUNK_SIZE;
 
+    if(chunk->getBlock(localX, localY, localZ) == blockId) {
+        return;
+    }
+
+    if(_chunkEditCallback) {
+        _chunkEditCallback(glm::ivec3(chunk->getX(), chunk->getY(), chunk->getZ()), chunk);
+    }
+
     chunk->setBlock(localX, localY, localZ, blockId);
+
+    // border blocks decide which faces the neighbouring chunk meshes
+    auto markNeighborDirty = [&](int dx, int dy, int dz) {
+        Chunk* neighbor = getLoadedChunk(chunk->getX() + dx, chunk->getY() + dy, chunk->getZ() + dz);
+        if(neighbor) {
+            neighbor->setDirty(true);
+        }
+    };
+
+    if(localX == 0) markNeighborDirty(-1, 0, 0);
+    if(localX == CHUNK_SIZE - 1) markNeighborDirty(1, 0, 0);
+    if(localY == 0) markNeighborDirty(0, -1, 0);
+    if(localY == CHUNK_SIZE - 1) markNeighborDirty(0, 1, 0);
+    if(localZ == 0) markNeighborDirty(0, 0, -1);
+    if(localZ == CHUNK_SIZE - 1) markNeighborDirty(0, 0, 1);
 }
 
 void World::setBlocks(const std::vector<glm::ivec3>& positions, unsigned char blockId) {
@@ -104,20 +573,298 @@ void World::setBlocks(const std::vector<glm::ivec3>& positions, unsigned char bl
     }
 }
 
-std::optional<WorldRayHit> World::findRayHitBlock(const Ray& ray, float maxDistance) const {
-    PERFORM_DDA(ray.origin, ray.direction, maxDistance, {
-        if(getBlock(voxel.x, voxel.y, voxel.z) != 0) {
-            WorldRayHit hit;
+Chunk* World::editChunk(int x, int y, int z, const std::function<void(unsigned char* blocks)>& edit) {
+    Chunk* chunk = getChunk(x, y, z);
+    if(!chunk) {
+        chunk = createChunk(x, y, z);
+    }
+
+    if(!chunk) {
+        return nullptr;
+    }
+
+    if(_chunkEditCallback) {
+        _chunkEditCallback(glm::ivec3(x, y, z), chunk);
+    }
+
+    chunk->fillBlocks(edit);
+
+    // the edit may have touched any border
+    markNeighborsDirty(x, y, z);
+
+    return chunk;
+}
+
+void World::moveSelection(const VoxelSelection& selection, const glm::ivec3& offset) {
+    if(selection.isEmpty()) {
+        return;
+    }
+
+    struct SourceChunk {
+        // shared with the chunk, which copies it on the first write below
+        std::shared_ptr<const ChunkBlocks> blocks;
+        const SelectionBits* bits;
+    };
+
+    std::unordered_map<uint64_t, SourceChunk> sources;
+    std::unordered_map<uint64_t, glm::ivec3> affected;
+
+    // rounds towards negative infinity, destinations may be left of the origin
+    auto floorDivide = [](int value) {
+        return value >= 0 ? value / CHUNK_SIZE : -((-value + CHUNK_SIZE - 1) / CHUNK_SIZE);
+    };
+
+    selection.forEachChunk([&](const glm::ivec3& coords, const SelectionBits& bits) {
+        const Chunk* chunk = getChunk(coords.x, coords.y, coords.z);
+        if(!chunk) {
+            return;
+        }
+
+        auto key = getChunkKey(coords.x, coords.y, coords.z);
+        sources[key] = { chunk->shareBlocks(), &bits };
+        affected[key] = coords;
+
+        glm::ivec3 low = coords * CHUNK_SIZE + offset;
+        glm::ivec3 high = low + CHUNK_SIZE - 1;
+
+        for(int z = floorDivide(low.z); z <= floorDivide(high.z); ++z) {
+            for(int y = floorDivide(low.y); y <= floorDivide(high.y); ++y) {
+                for(int x = floorDivide(low.x); x <= floorDivide(high.x); ++x) {
+                    if(x >= 0 && y >= 0 && z >= 0) {
+                        affected[getChunkKey(x, y, z)] = glm::ivec3(x, y, z);
+                    }
+                }
+            }
+        }
+    });
+
+    // source row y, z of a chunk with the selected solid voxels as a mask
+    auto getSourceRow = [&](int chunkX, int y, int z, const unsigned char*& outBlocks) -> uint32_t {
+        outBlocks = nullptr;
+        if(chunkX < 0 || y < 0 || z < 0) {
+            return 0;
+        }
+
+        auto it = sources.find(getChunkKey(chunkX, y / CHUNK_SIZE, z / CHUNK_SIZE));
+        if(it == sources.end()) {
+            return 0;
+        }
+
+        int localY = y % CHUNK_SIZE;
+        int localZ = z % CHUNK_SIZE;
+        int index = localZ * CHUNK_SIZE * CHUNK_SIZE + localY * CHUNK_SIZE;
+
+        outBlocks = it->second.blocks->data() + index;
+
+        uint32_t selected = static_cast<uint32_t>(((*it->second.bits)[index / 64] >> (index % 64)) & 0xFFFF);
+        uint32_t mask = 0;
+        for(uint32_t bits = selected; bits != 0; bits &= bits - 1) {
+            int x = countTrailingZeros(bits);
+            mask |= static_cast<uint32_t>(outBlocks[x] != 0) << x;
+        }
+
+        return mask;
+    };
+
+    int shift = ((-offset.x) % CHUNK_SIZE + CHUNK_SIZE) % CHUNK_SIZE;
+
+    // Writes the voxels moved into the chunk at coords to blocks. With blocks
+    // null only checks whether any voxel lands in the chunk.
+    auto moveRows = [&](const glm::ivec3& coords, unsigned char* blocks) {
+        // first source column of the chunk
+        int sourceChunkX = floorDivide(coords.x * CHUNK_SIZE - offset.x);
+        bool moved = false;
+
+        for(int z = 0; z < CHUNK_SIZE; ++z) {
+            for(int y = 0; y < CHUNK_SIZE; ++y) {
+                int sourceY = coords.y * CHUNK_SIZE + y - offset.y;
+                int sourceZ = coords.z * CHUNK_SIZE + z - offset.z;
+
+                const unsigned char* lowBlocks;
+                const unsigned char* highBlocks = nullptr;
+
+                uint32_t mask = getSourceRow(sourceChunkX, sourceY, sourceZ, lowBlocks) >> shift;
+                if(shift != 0) {
+                    mask |= getSourceRow(sourceChunkX + 1, sourceY, sourceZ, highBlocks) << (CHUNK_SIZE - shift);
+                }
+
+                mask &= (1u << CHUNK_SIZE) - 1;
+                if(mask == 0) {
+                    continue;
+                }
+
+                moved = true;
+                if(!blocks) {
+                    return true;
+                }
+
+                // the two source rows side by side, destination x is row x + shift
+                unsigned char rows[CHUNK_SIZE * 2];
+                if(lowBlocks) {
+                    std::memcpy(rows, lowBlocks, CHUNK_SIZE);
+                }
+                if(highBlocks) {
+                    std::memcpy(rows + CHUNK_SIZE, highBlocks, CHUNK_SIZE);
+                }
+
+                unsigned char* row = blocks + z * CHUNK_SIZE * CHUNK_SIZE + y * CHUNK_SIZE;
+
+                if(mask == (1u << CHUNK_SIZE) - 1) {
+                    std::memcpy(row, rows + shift, CHUNK_SIZE);
+                    continue;
+                }
+
+                for(uint32_t bits = mask; bits != 0; bits &= bits - 1) {
+                    int x = countTrailingZeros(bits);
+                    row[x] = rows[x + shift];
+                }
+            }
+        }
+
+        return moved;
+    };
+
+    for(const auto& [key, coords] : affected) {
+        auto source = sources.find(key);
+
+        // don't touch or create chunks that nothing lands in
+        if(source == sources.end() && !moveRows(coords, nullptr)) {
+            continue;
+        }
+
+        editChunk(coords.x, coords.y, coords.z, [&](unsigned char* blocks) {
+            if(source != sources.end()) {
+                const auto& bits = *source->second.bits;
+
+                for(int word = 0; word < SELECTION_CHUNK_WORDS; ++word) {
+                    for(uint64_t cleared = bits[word]; cleared != 0; cleared &= cleared - 1) {
+                        blocks[word * 64 + countTrailingZeros(cleared)] = 0;
+                    }
+                }
+            }
+
+            moveRows(coords, blocks);
+        });
+    }
+}
+
+size_t World::fillSelection(const VoxelSelection& selection, unsigned char blockId, bool solidOnly) {
+    size_t changed = 0;
+
+    selection.forEachChunk([&](const glm::ivec3& coords, const SelectionBits& selected) {
+        const Chunk* chunk = getChunk(coords.x, coords.y, coords.z);
+        if(!chunk && (blockId == 0 || solidOnly)) {
+            return;
+        }
+
+        // keep only the cells that change, unchanged chunks get no history record
+        SelectionBits bits = selected;
+        size_t chunkChanged = 0;
+        if(chunk) {
+            const unsigned char* blocks = chunk->getBlocks().data();
+            for(int word = 0; word < SELECTION_CHUNK_WORDS; ++word) {
+                for(uint64_t remaining = bits[word]; remaining != 0; remaining &= remaining - 1) {
+                    int index = word * 64 + countTrailingZeros(remaining);
+                    if(blocks[index] == blockId || (solidOnly && blocks[index] == 0)) {
+                        bits[word] &= ~(1ull << (index % 64));
+                    }
+                }
+                chunkChanged += countSetBits(bits[word]);
+            }
+        } else {
+            for(int word = 0; word < SELECTION_CHUNK_WORDS; ++word) {
+                chunkChanged += countSetBits(bits[word]);
+            }
+        }
+
+        if(chunkChanged == 0) {
+            return;
+        }
+
+        editChunk(coords.x, coords.y, coords.z, [&](unsigned char* blocks) {
+            if(chunkChanged == CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE) {
+                std::memset(blocks, blockId, CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE);
+                return;
+            }
+
+            for(int word = 0; word < SELECTION_CHUNK_WORDS; ++word) {
+                for(uint64_t remaining = bits[word]; remaining != 0; remaining &= remaining - 1) {
+                    blocks[word * 64 + countTrailingZeros(remaining)] = blockId;
+                }
+            }
+        });
+
+        changed += chunkChanged;
+    });
 
-            hit.block = voxel;
-            hit.side = side;
-            hit.distance = distance;
+    return changed;
+}
+
+// First solid block along the ray. Looks up the chunk map only when the ray
+// crosses into another chunk, getChunk(x, y, z) gives the chunk there.
+template<typename GetChunk>
+static std::optional<WorldRayHit> castRay(const Ray& ray, float maxDistance, GetChunk&& getChunk) {
+    std::optional<WorldRayHit> hit;
+
+    glm::ivec3 chunkCoords(-1);
+    const unsigned char* blocks = nullptr;
+
+    performDDA(ray.origin, ray.direction, maxDistance, [&](const glm::ivec3& voxel, const glm::ivec3& side, float distance) {
+        if(voxel.x < 0 || voxel.y < 0 || voxel.z < 0) {
+            return false;
+        }
+
+        glm::ivec3 coords(voxel.x / CHUNK_SIZE, voxel.y / CHUNK_SIZE, voxel.z / CHUNK_SIZE);
+        if(coords != chunkCoords) {
+            const Chunk* chunk = getChunk(coords.x, coords.y, coords.z);
 
-            return hit;
+            chunkCoords = coords;
+            blocks = chunk && chunk->getBlockCount() > 0 ? chunk->getBlocks().data() : nullptr;
         }
+
+        int index = (voxel.z % CHUNK_SIZE) * CHUNK_SIZE * CHUNK_SIZE + (voxel.y % CHUNK_SIZE) * CHUNK_SIZE + voxel.x % CHUNK_SIZE;
+        if(!blocks || blocks[index] == 0) {
+            return false;
+        }
+
+        hit = WorldRayHit{ voxel, side, distance };
+        return true;
+    });
+
+    return hit;
+}
+
+std::optional<WorldRayHit> World::findRayHitBlock(const Ray& ray, float maxDistance) const {
+    return castRay(ray, maxDistance, [&](int x, int y, int z) {
+        return getChunk(x, y, z);
     });
+}
+
+void World::raycastBatch(const Ray* rays, std::optional<WorldRayHit>* outHits, size_t count, float maxDistance) const {
+    auto getChunk = [&](int x, int y, int z) {
+        return getLoadedChunk(x, y, z);
+    };
+
+    for(size_t i = 0; i < count; ++i) {
+        outHits[i] = castRay(rays[i], maxDistance, getChunk);
+    }
+}
+
+void World::raycastBatch(const Ray* rays, std::optional<WorldRayHit>* outHits, size_t count, float maxDistance, core::ThreadPool& pool) const {
+    if(count < RAYCAST_PARALLEL_MIN_RAYS) {
+        raycastBatch(rays, outHits, count, maxDistance);
+        return;
+    }
 
-    return std::nullopt;
+    // the chunk map is only read
+    pool.parallelFor(count, [&](size_t begin, size_t end) {
+        raycastBatch(rays + begin, outHits + begin, end - begin, maxDistance);
+    });
+}
+
+void World::raycastBatch(const std::vector<Ray>& rays, std::vector<std::optional<WorldRayHit>>& outHits, float maxDistance, core::ThreadPool& pool) const {
+    outHits.resize(rays.size());
+    raycastBatch(rays.data(), outHits.data(), rays.size(), maxDistance, pool);
 }
 
 std::optional<WorldRayHit> World::findRayHitXPlane(const Ray& ray, float maxDistance, int x_plane) const {
@@ -266,103 +1013,188 @@ std::vector<glm::ivec3> World::getVoxelsInCube(const glm::ivec3& min, const glm:
 }
 
 void World::forVoxelsInLine(const glm::ivec3& start, const glm::ivec3& end, const std::function<void(int x, int y, int z)>& action) const {
-    glm::vec3 origin = glm::vec3(start) + glm::vec3(0.5f);
-    glm::vec3 endPos = glm::vec3(end) + glm::vec3(0.5f);
-    glm::vec3 direction = endPos - origin;
+    forEachVoxelInLine(start, end, action);
+}
 
-    float length = glm::length(direction);
-    if (length == 0.0f) {
-        action(origin.x, origin.y, origin.z);
-        return;
+std::vector<glm::ivec3> World::getConnectedVoxels(const glm::ivec3& start) const {
+    return selectConnected(start, Connectivity::CONNECTIVITY_18).toVector();
+}
+
+VoxelSelection World::selectConnected(const glm::ivec3& start, Connectivity connectivity) const {
+    VoxelSelection selection;
+
+    if(getBlock(start.x, start.y, start.z) == 0) {
+        return selection;
     }
 
-    direction = glm::normalize(direction);
-    glm::ivec3 voxel(
-        static_cast<int>(std::floor(origin.x)),
-        static_cast<int>(std::floor(origin.y)),
-        static_cast<int>(std::floor(origin.z))
-    );
+    // most rows in a row are in the same chunk
+    const Chunk* cachedChunk = nullptr;
+    glm::ivec3 cachedCoords(-1);
 
-    float distance = length;
-    while(true) {
-        action(voxel.x, voxel.y, voxel.z);
-        if (distance <= 0.0f) {
-            break;
+    // solid and not yet selected voxels of a chunk row as bits, see VoxelSelection::getRow
+    auto getOpenRow = [&](int chunkX, int y, int z) -> uint32_t {
+        glm::ivec3 coords(chunkX, y / CHUNK_SIZE, z / CHUNK_SIZE);
+        if(coords != cachedCoords) {
+            cachedChunk = getChunk(coords.x, coords.y, coords.z);
+            cachedCoords = coords;
         }
 
-        float step = distance < 1.0f ? distance : 1.0f;
-        origin += direction * step;
-        voxel = glm::ivec3(
-            static_cast<int>(std::floor(origin.x)),
-            static_cast<int>(std::floor(origin.y)),
-            static_cast<int>(std::floor(origin.z))
-        );
+        if(!cachedChunk || cachedChunk->getBlockCount() == 0) {
+            return 0;
+        }
 
-        distance -= step;
+        const unsigned char* row = cachedChunk->getBlocks().data() + (z % CHUNK_SIZE) * CHUNK_SIZE * CHUNK_SIZE + (y % CHUNK_SIZE) * CHUNK_SIZE;
+
+        uint32_t solid = 0;
+        for(int i = 0; i < CHUNK_SIZE; ++i) {
+            solid |= static_cast<uint32_t>(row[i] != 0) << i;
+        }
+
+        return solid & ~static_cast<uint32_t>(selection.getRow(chunkX, y, z));
+    };
+
+    const uint32_t fullRow = (1u << CHUNK_SIZE) - 1;
+
+    struct Neighbor {
+        int dy, dz;
+        // how far the span grows along x in this row, 1 for diagonal neighbours
+        int grow;
+    };
+
+    std::vector<Neighbor> neighbors;
+    int diagonalGrow = connectivity == Connectivity::CONNECTIVITY_26 ? 1 : 0;
+    int faceGrow = connectivity == Connectivity::CONNECTIVITY_6 ? 0 : 1;
+
+    for(int dz = -1; dz <= 1; ++dz) {
+        for(int dy = -1; dy <= 1; ++dy) {
+            if(dy == 0 && dz == 0) {
+                continue;
+            }
+
+            if(dy != 0 && dz != 0) {
+                if(connectivity != Connectivity::CONNECTIVITY_6) {
+                    neighbors.push_back({ dy, dz, diagonalGrow });
+                }
+            } else {
+                neighbors.push_back({ dy, dz, faceGrow });
+            }
+        }
     }
-}
 
-std::vector<glm::ivec3> World::getConnectedVoxels(const glm::ivec3& start) const {
-    std::vector<glm::ivec3> connectedVoxels;
-    std::unordered_map<uint64_t, bool> visited;
+    std::vector<glm::ivec3> seeds;
+    seeds.push_back(start);
 
-    std::vector<glm::ivec3> stack;
-    stack.push_back(start);
+    while(!seeds.empty()) {
+        glm::ivec3 seed = seeds.back();
+        seeds.pop_back();
 
-    while(!stack.empty()) {
-        glm::ivec3 current = stack.back();
-        stack.pop_back();
+        int chunkX = seed.x / CHUNK_SIZE;
+        int bit = seed.x % CHUNK_SIZE;
 
-        if(current.x < 0 || current.y < 0 || current.z < 0) {
+        uint32_t open = getOpenRow(chunkX, seed.y, seed.z);
+        if(!((open >> bit) & 1)) {
             continue;
         }
 
-        uint64_t key = getChunkKey(current.x, current.y, current.z);
-        if (visited.find(key) != visited.end()) {
-            continue;
+        // the run of open voxels around the seed, chunk row by chunk row
+        int lastBit = bit + countTrailingZeros(~(open >> bit));
+        int lastChunkX = chunkX;
+        while(lastBit == CHUNK_SIZE) {
+            uint32_t next = getOpenRow(lastChunkX + 1, seed.y, seed.z);
+            if(!(next & 1)) {
+                break;
+            }
+
+            lastChunkX++;
+            lastBit = countTrailingZeros(~next);
         }
 
-        visited[key] = true;
-        if (getBlock(current.x, current.y, current.z) == 0) {
-            continue;
+        uint32_t below = ~open & ((1u << bit) - 1);
+        int firstBit = below ? 64 - countLeadingZeros(below) : 0;
+        int firstChunkX = chunkX;
+        while(firstBit == 0 && firstChunkX > 0) {
+            uint32_t previous = getOpenRow(firstChunkX - 1, seed.y, seed.z);
+            if(!((previous >> (CHUNK_SIZE - 1)) & 1)) {
+                break;
+            }
+
+            firstChunkX--;
+            uint32_t closed = ~previous & fullRow;
+            firstBit = closed ? 64 - countLeadingZeros(closed) : 0;
+        }
+
+        int x0 = firstChunkX * CHUNK_SIZE + firstBit;
+        int x1 = lastChunkX * CHUNK_SIZE + lastBit - 1;
+
+        for(int currentChunkX = firstChunkX; currentChunkX <= lastChunkX; ++currentChunkX) {
+            int from = std::max(x0 - currentChunkX * CHUNK_SIZE, 0);
+            int to = std::min(x1 - currentChunkX * CHUNK_SIZE, CHUNK_SIZE - 1);
+
+            uint32_t mask = (fullRow >> (CHUNK_SIZE - 1 - to)) & ~((1u << from) - 1);
+            selection.addRow(currentChunkX, seed.y, seed.z, static_cast<uint16_t>(mask));
         }
 
-        connectedVoxels.push_back(current);
+        // one seed per run of open voxels in the neighbouring rows the span touches
+        for(const auto& neighbor : neighbors) {
+            int y = seed.y + neighbor.dy;
+            int z = seed.z + neighbor.dz;
+            if(y < 0 || z < 0) {
+                continue;
+            }
+
+            int from = std::max(x0 - neighbor.grow, 0);
+            int to = x1 + neighbor.grow;
+
+            for(int currentChunkX = from / CHUNK_SIZE; currentChunkX <= to / CHUNK_SIZE; ++currentChunkX) {
+                int fromBit = std::max(from - currentChunkX * CHUNK_SIZE, 0);
+                int toBit = std::min(to - currentChunkX * CHUNK_SIZE, CHUNK_SIZE - 1);
+
+                uint32_t range = (fullRow >> (CHUNK_SIZE - 1 - toBit)) & ~((1u << fromBit) - 1);
+                uint32_t neighborOpen = getOpenRow(currentChunkX, y, z) & range;
+
+                while(neighborOpen != 0) {
+                    int runStart = countTrailingZeros(neighborOpen);
+                    seeds.push_back(glm::ivec3(currentChunkX * CHUNK_SIZE + runStart, y, z));
 
-        stack.push_back(current + glm::ivec3(1, 0, 0));
-        stack.push_back(current + glm::ivec3(-1, 0, 0));
-        stack.push_back(current + glm::ivec3(0, 1, 0));
-        stack.push_back(current + glm::ivec3(0, -1, 0));
-        stack.push_back(current + glm::ivec3(0, 0, 1));
-        stack.push_back(current + glm::ivec3(0, 0, -1));
-        stack.push_back(current + glm::ivec3(1, 1, 0));
-        stack.push_back(current + glm::ivec3(-1, -1, 0));
-        stack.push_back(current + glm::ivec3(1, 0, 1));
-        stack.push_back(current + glm::ivec3(-1, 0, -1));
-        stack.push_back(current + glm::ivec3(0, 1, 1));
-        stack.push_back(current + glm::ivec3(0, -1, -1));
+                    // clears the lowest run of set bits
+                    neighborOpen &= neighborOpen + (neighborOpen & (~neighborOpen + 1));
+                }
+            }
+        }
     }
 
-    return connectedVoxels;
+    return selection;
 }
 
 WorldAsset World::saveToAsset(const World& world) {
     WorldAsset asset;
 
+    if (world._region) {
+        for (size_t i = 0; i < world._region->getChunkCount(); ++i) {
+            auto coords = world._region->getChunkCoords(i);
+            auto key = getChunkKey(coords.x, coords.y, coords.z);
+
+            if (world._consumedRegionChunks.find(key) != world._consumedRegionChunks.end()) {
+                continue;
+            }
+
+            ChunkData chunkData;
+            chunkData.x = coords.x;
+            chunkData.y = coords.y;
+            chunkData.z = coords.z;
+            world._region->readChunkAt(i, chunkData.data.data());
+
+            asset.chunks[key] = chunkData;
+        }
+    }
+
     for (const auto& [key, chunk] : world._chunks) {
         ChunkData chunkData;
         chunkData.x = chunk->getX();
         chunkData.y = chunk->getY();
         chunkData.z = chunk->getZ();
 
-        auto blocks = chunk->getBlocks();
-        for (int x = 0; x < CHUNK_SIZE; ++x) {
-            for (int y = 0; y < CHUNK_SIZE; ++y) {
-                for (int z = 0; z < CHUNK_SIZE; ++z) {
-                    chunkData.data[x + CHUNK_SIZE * (y + CHUNK_SIZE * z)] = blocks[x + CHUNK_SIZE * (y + CHUNK_SIZE * z)];
-                }
-            }
-        }
+        chunkData.data = chunk->getBlocks();
 
         asset.chunks[key] = chunkData;
     }
@@ -375,16 +1207,30 @@ std::unique_ptr<World> World::loadFromAsset(const WorldAsset& asset) {
 
     for (const auto& [key, chunkData] : asset.chunks) {
         Chunk* chunk = world->createChunk(chunkData.x, chunkData.y, chunkData.z);
-
-        for (int x = 0; x < CHUNK_SIZE; ++x) {
-            for (int y = 0; y < CHUNK_SIZE; ++y) {
-                for (int z = 0; z < CHUNK_SIZE; ++z) {
-                    unsigned char blockType = chunkData.data[x + CHUNK_SIZE * (y + CHUNK_SIZE * z)];
-                    chunk->setBlock(x, y, z, blockType);
-                }
-            }
+        if (!chunk) {
+            continue;
         }
+
+        chunk->assignBlocks(chunkData.data.data());
     }
 
+    world->clearChanges();
+
     return world;
-}
\ No newline at end of file
+}
+
+std::unique_ptr<World> World::loadFromFile(const std::string& filepath) {
+    return loadFromPath(core::FileSystem::getExecutablePath() + filepath);
+}
+
+std::unique_ptr<World> World::loadFromPath(const std::string& path) {
+    auto region = WorldRegion::open(path);
+    if (!region) {
+        return loadFromAsset(WorldAsset::loadFromBuffer(core::FileSystem::readFromFile(path)));
+    }
+
+    auto world = std::make_unique<World>();
+    world->setRegion(std::move(region));
+
+    return world;
+}
@@ -1,52 +1,197 @@
 #include "world_asset.hpp"
+#include "world.hpp"
 #include "engine/core/filesystem.hpp"
 
-#include <sstream>
+#include <algorithm>
 
-void WorldAsset::saveToFile(const std::string& filepath) const {
-    std::stringstream buffer;
+bool readWorldFileHeader(core::BinaryReader& reader, WorldFileHeader& outHeader) {
+    // a legacy file starts with its name length, which would have to be over 1GB to match
+    if (reader.getRemaining() < 4 || reader.read<uint32_t>() != WORLD_FILE_MAGIC) {
+        return false;
+    }
+
+    outHeader.version = reader.read<uint16_t>();
+    if (outHeader.version > WORLD_FILE_VERSION) {
+        throw std::runtime_error("World file version " + std::to_string(outHeader.version) + " is newer than supported.");
+    }
+
+    outHeader.saveId = reader.read<uint16_t>();
+
+    outHeader.name = reader.readString();
+    outHeader.chunkCount = reader.read<uint32_t>();
+    outHeader.tableOffset = reader.getPosition();
+
+    if (static_cast<uint64_t>(outHeader.chunkCount) * WORLD_FILE_CHUNK_ENTRY_SIZE > reader.getRemaining()) {
+        throw std::runtime_error("Corrupt world file: chunk table is truncated.");
+    }
+
+    return true;
+}
 
-    uint32_t nameLength = static_cast<uint32_t>(name.size());
-    buffer.write(reinterpret_cast<const char*>(&nameLength), sizeof(nameLength));
-    buffer.write(name.c_str(), nameLength);
+WorldFileChunkEntry readWorldFileChunkEntry(core::BinaryReader& reader) {
+    WorldFileChunkEntry entry;
+    entry.x = reader.read<int32_t>();
+    entry.y = reader.read<int32_t>();
+    entry.z = reader.read<int32_t>();
+    entry.payloadOffset = reader.read<uint64_t>();
+    entry.payloadSize = reader.read<uint32_t>();
+    entry.encoding = static_cast<ChunkEncoding>(reader.read<uint8_t>());
+    reader.skip(3);
 
-    uint32_t chunkCount = static_cast<uint32_t>(chunks.size());
-    buffer.write(reinterpret_cast<const char*>(&chunkCount), sizeof(chunkCount));
+    return entry;
+}
 
+size_t getWorldFileTableOffset(const std::string& name) {
+    // magic, version, save id, name length, name, chunk count
+    return 4 + 2 + 2 + 4 + name.size() + 4;
+}
+
+void writeWorldFileHeader(core::BinaryWriter& writer, const std::string& name, uint32_t chunkCount, uint16_t saveId) {
+    writer.write<uint32_t>(WORLD_FILE_MAGIC);
+    writer.write<uint16_t>(WORLD_FILE_VERSION);
+    writer.write<uint16_t>(saveId);
+    writer.writeString(name);
+    writer.write<uint32_t>(chunkCount);
+}
+
+void writeWorldFileChunkEntry(core::BinaryWriter& writer, const WorldFileChunkEntry& entry) {
+    writer.write<int32_t>(entry.x);
+    writer.write<int32_t>(entry.y);
+    writer.write<int32_t>(entry.z);
+    writer.write<uint64_t>(entry.payloadOffset);
+    writer.write<uint32_t>(entry.payloadSize);
+    writer.write<uint8_t>(static_cast<uint8_t>(entry.encoding));
+    writer.write<uint8_t>(0);
+    writer.write<uint8_t>(0);
+    writer.write<uint8_t>(0);
+}
+
+std::string WorldAsset::saveToBuffer() const {
+    std::vector<uint64_t> keys;
+    keys.reserve(chunks.size());
     for (const auto& [key, chunk] : chunks) {
-        buffer.write(reinterpret_cast<const char*>(&key), sizeof(key));
-        buffer.write(reinterpret_cast<const char*>(&chunk), sizeof(chunk));
+        keys.push_back(key);
+    }
+
+    // sorted so the table can be binary searched and files are reproducible
+    std::sort(keys.begin(), keys.end());
+
+    std::vector<WorldFileChunkEntry> entries(keys.size());
+    std::string payloads;
+
+    // identical chunks are encoded once and share the payload, by index of
+    // the entry that has it
+    std::unordered_multimap<uint64_t, size_t> encodedChunks;
+
+    uint64_t payloadStart = getWorldFileTableOffset(name) + keys.size() * WORLD_FILE_CHUNK_ENTRY_SIZE;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        const auto& chunk = chunks.at(keys[i]);
+        size_t offset = payloads.size();
+
+        auto& entry = entries[i];
+        entry.x = chunk.x;
+        entry.y = chunk.y;
+        entry.z = chunk.z;
+
+        uint64_t hash = hashBytes(chunk.data.data(), chunk.data.size());
+        auto range = encodedChunks.equal_range(hash);
+
+        auto identical = std::find_if(range.first, range.second, [&](const auto& encoded) {
+            return chunks.at(keys[encoded.second]).data == chunk.data;
+        });
+
+        if (identical != range.second) {
+            const auto& other = entries[identical->second];
+            entry.encoding = other.encoding;
+            entry.payloadOffset = other.payloadOffset;
+            entry.payloadSize = other.payloadSize;
+            continue;
+        }
+
+        encodedChunks.emplace(hash, i);
+        entry.encoding = encodeChunkBlocks(chunk.data.data(), payloads);
+        entry.payloadOffset = payloadStart + offset;
+        entry.payloadSize = static_cast<uint32_t>(payloads.size() - offset);
     }
 
+    std::string buffer;
+    core::BinaryWriter writer(buffer);
+
+    writeWorldFileHeader(writer, name, static_cast<uint32_t>(entries.size()));
+    for (const auto& entry : entries) {
+        writeWorldFileChunkEntry(writer, entry);
+    }
+
+    buffer.append(payloads);
+    return buffer;
+}
+
+void WorldAsset::saveToFile(const std::string& filepath) const {
     auto base = core::FileSystem::getDataPath();
     
     std::string fullPath = base + filepath;
-    core::FileSystem::writeToFile(fullPath, buffer.str());
+    core::FileSystem::writeToFile(fullPath, saveToBuffer());
 }
 
 WorldAsset WorldAsset::loadFromFile(const std::string& filepath) {
     auto base = core::FileSystem::getExecutablePath();
     std::string fullPath = base + filepath;
 
-    std::string buffer = core::FileSystem::readFromFile(fullPath);
-    std::istringstream file(buffer);
+    return loadFromBuffer(core::FileSystem::readFromFile(fullPath));
+}
+
+WorldAsset WorldAsset::loadFromBuffer(const std::string& buffer) {
+    core::BinaryReader reader(buffer);
+
+    WorldFileHeader header;
+    if (!readWorldFileHeader(reader, header)) {
+        reader.seek(0);
+        return loadLegacy(reader);
+    }
 
     WorldAsset worldAsset;
-    uint32_t nameLength;
-    
-    file.read(reinterpret_cast<char*>(&nameLength), sizeof(nameLength));
-    worldAsset.name.resize(nameLength);
-    file.read(&worldAsset.name[0], nameLength);
+    worldAsset.name = header.name;
+    worldAsset.chunks.reserve(header.chunkCount);
+
+    core::BinaryReader payloads(buffer);
+    for (uint32_t i = 0; i < header.chunkCount; ++i) {
+        auto entry = readWorldFileChunkEntry(reader);
+
+        if (entry.payloadOffset > buffer.size()) {
+            throw std::runtime_error("Corrupt world file: chunk payload outside of file.");
+        }
 
-    uint32_t chunkCount;
-    file.read(reinterpret_cast<char*>(&chunkCount), sizeof(chunkCount));
+        ChunkData chunk;
+        chunk.x = entry.x;
+        chunk.y = entry.y;
+        chunk.z = entry.z;
+
+        payloads.seek(static_cast<size_t>(entry.payloadOffset));
+        const char* payload = payloads.skip(entry.payloadSize);
+        decodeChunkBlocks(entry.encoding, payload, entry.payloadSize, chunk.data.data());
+
+        worldAsset.chunks[getChunkKey(chunk.x, chunk.y, chunk.z)] = chunk;
+    }
+
+    return worldAsset;
+}
+
+WorldAsset WorldAsset::loadLegacy(core::BinaryReader& reader) {
+    WorldAsset worldAsset;
+    worldAsset.name = reader.readString();
+
+    uint32_t chunkCount = reader.read<uint32_t>();
     for (uint32_t i = 0; i < chunkCount; ++i) {
-        uint64_t key;
+        uint64_t key = reader.read<uint64_t>();
+
         ChunkData chunk;
-        file.read(reinterpret_cast<char*>(&key), sizeof(key));
-        file.read(reinterpret_cast<char*>(&chunk), sizeof(chunk));
+        chunk.x = reader.read<int32_t>();
+        chunk.y = reader.read<int32_t>();
+        chunk.z = reader.read<int32_t>();
+        reader.readBytes(chunk.data.data(), chunk.data.size());
+
         worldAsset.chunks[key] = chunk;
     }
 
     return worldAsset;
-}
\ No newline at end of file
+}
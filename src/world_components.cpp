@@ -0,0 +1,345 @@
+#include "world_components.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+ConcurrentUnionFind::ConcurrentUnionFind(size_t count)
+    : _parents(new std::atomic<uint32_t>[count]) {
+    for(size_t i = 0; i < count; ++i) {
+        _parents[i].store(static_cast<uint32_t>(i), std::memory_order_relaxed);
+    }
+}
+
+uint32_t ConcurrentUnionFind::find(uint32_t element) {
+    while(true) {
+        uint32_t parent = _parents[element].load();
+        if(parent == element) {
+            return element;
+        }
+
+        uint32_t grandparent = _parents[parent].load();
+        if(parent != grandparent) {
+            // path halving, losing the race to another thread is harmless
+            _parents[element].compare_exchange_weak(parent, grandparent);
+        }
+
+        element = grandparent;
+    }
+}
+
+void ConcurrentUnionFind::unite(uint32_t a, uint32_t b) {
+    while(true) {
+        a = find(a);
+        b = find(b);
+
+        if(a == b) {
+            return;
+        }
+
+        // always linking the larger root keeps the parent pointers acyclic
+        if(a < b) {
+            std::swap(a, b);
+        }
+
+        uint32_t expected = a;
+        if(_parents[a].compare_exchange_strong(expected, b)) {
+            return;
+        }
+
+        // a stopped being a root in the meantime, start over from the new roots
+    }
+}
+
+// neighbour offsets for the connectivity, and the half of them that comes
+// later in z, y, x order, so that every pair of neighbours is visited once
+static void getNeighborOffsets(Connectivity connectivity, std::vector<glm::ivec3>& outAll, std::vector<glm::ivec3>& outForward) {
+    int maxNonZero = connectivity == Connectivity::CONNECTIVITY_6 ? 1 : connectivity == Connectivity::CONNECTIVITY_18 ? 2 : 3;
+
+    for(int dz = -1; dz <= 1; ++dz) {
+        for(int dy = -1; dy <= 1; ++dy) {
+            for(int dx = -1; dx <= 1; ++dx) {
+                int nonZero = (dx != 0) + (dy != 0) + (dz != 0);
+                if(nonZero == 0 || nonZero > maxNonZero) {
+                    continue;
+                }
+
+                outAll.push_back(glm::ivec3(dx, dy, dz));
+
+                if(dz > 0 || (dz == 0 && dy > 0) || (dz == 0 && dy == 0 && dx > 0)) {
+                    outForward.push_back(glm::ivec3(dx, dy, dz));
+                }
+            }
+        }
+    }
+}
+
+WorldComponents WorldComponents::label(const World& world, core::ThreadPool& pool, Connectivity connectivity) {
+    WorldComponents result;
+
+    std::vector<glm::ivec3> offsets;
+    std::vector<glm::ivec3> forwardOffsets;
+    getNeighborOffsets(connectivity, offsets, forwardOffsets);
+
+    std::vector<const Chunk*> chunks;
+    for(const auto& [key, chunk] : world.getChunks()) {
+        if(chunk->getBlockCount() > 0) {
+            result._chunkIndices[key] = chunks.size();
+            chunks.push_back(chunk.get());
+        }
+    }
+
+    result._chunks.resize(chunks.size());
+
+    // each chunk on its own, flood filling inside the chunk
+    pool.parallelFor(chunks.size(), [&](size_t begin, size_t end) {
+        std::vector<int> stack;
+
+        for(size_t i = begin; i < end; ++i) {
+            const auto& blocks = chunks[i]->getBlocks();
+
+            auto& labelled = result._chunks[i];
+            labelled.coords = glm::ivec3(chunks[i]->getX(), chunks[i]->getY(), chunks[i]->getZ());
+            labelled.labels.assign(CHUNK_VOLUME, 0);
+
+            glm::ivec3 base = labelled.coords * CHUNK_SIZE;
+
+            for(int start = 0; start < CHUNK_VOLUME; ++start) {
+                if(blocks[start] == 0 || labelled.labels[start] != 0) {
+                    continue;
+                }
+
+                // at most CHUNK_VOLUME / 2 components, e.g. a checkerboard
+                auto label = static_cast<uint16_t>(labelled.localComponents.size() + 1);
+
+                size_t voxelCount = 0;
+                int minX = CHUNK_SIZE, minY = CHUNK_SIZE, minZ = CHUNK_SIZE;
+                int maxX = -1, maxY = -1, maxZ = -1;
+
+                labelled.labels[start] = label;
+                stack.push_back(start);
+
+                while(!stack.empty()) {
+                    int index = stack.back();
+                    stack.pop_back();
+
+                    int x = index % CHUNK_SIZE;
+                    int y = (index / CHUNK_SIZE) % CHUNK_SIZE;
+                    int z = index / (CHUNK_SIZE * CHUNK_SIZE);
+
+                    voxelCount++;
+                    minX = std::min(minX, x);
+                    minY = std::min(minY, y);
+                    minZ = std::min(minZ, z);
+                    maxX = std::max(maxX, x);
+                    maxY = std::max(maxY, y);
+                    maxZ = std::max(maxZ, z);
+
+                    for(const auto& offset : offsets) {
+                        int nx = x + offset.x;
+                        int ny = y + offset.y;
+                        int nz = z + offset.z;
+
+                        if(nx < 0 || ny < 0 || nz < 0 || nx >= CHUNK_SIZE || ny >= CHUNK_SIZE || nz >= CHUNK_SIZE) {
+                            continue;
+                        }
+
+                        int neighbor = (nz * CHUNK_SIZE + ny) * CHUNK_SIZE + nx;
+                        if(blocks[neighbor] != 0 && labelled.labels[neighbor] == 0) {
+                            labelled.labels[neighbor] = label;
+                            stack.push_back(neighbor);
+                        }
+                    }
+                }
+
+                WorldComponent component;
+                component.voxelCount = voxelCount;
+                component.min = base + glm::ivec3(minX, minY, minZ);
+                component.max = base + glm::ivec3(maxX, maxY, maxZ);
+                labelled.localComponents.push_back(component);
+            }
+        }
+    });
+
+    uint32_t labelCount = 0;
+    for(auto& labelled : result._chunks) {
+        labelled.firstLabel = labelCount;
+        labelCount += static_cast<uint32_t>(labelled.localComponents.size());
+    }
+
+    ConcurrentUnionFind unionFind(labelCount);
+
+    // merges the labels of neighbouring voxels in different chunks
+    pool.parallelFor(chunks.size(), [&](size_t begin, size_t end) {
+        for(size_t i = begin; i < end; ++i) {
+            const auto& labelled = result._chunks[i];
+
+            // by (dz + 1) * 9 + (dy + 1) * 3 + dx + 1
+            const LabelledChunk* neighbors[27];
+            for(int n = 0; n < 27; ++n) {
+                glm::ivec3 coords = labelled.coords + glm::ivec3(n % 3 - 1, (n / 3) % 3 - 1, n / 9 - 1);
+
+                auto it = coords.x < 0 || coords.y < 0 || coords.z < 0
+                    ? result._chunkIndices.end()
+                    : result._chunkIndices.find(getChunkKey(coords.x, coords.y, coords.z));
+                neighbors[n] = it != result._chunkIndices.end() ? &result._chunks[it->second] : nullptr;
+            }
+
+            for(int index = 0; index < CHUNK_VOLUME; ++index) {
+                uint16_t label = labelled.labels[index];
+                if(label == 0) {
+                    continue;
+                }
+
+                int x = index % CHUNK_SIZE;
+                int y = (index / CHUNK_SIZE) % CHUNK_SIZE;
+                int z = index / (CHUNK_SIZE * CHUNK_SIZE);
+
+                if(x != 0 && y != 0 && z != 0 && x != CHUNK_SIZE - 1 && y != CHUNK_SIZE - 1 && z != CHUNK_SIZE - 1) {
+                    continue;
+                }
+
+                for(const auto& offset : forwardOffsets) {
+                    glm::ivec3 local(x + offset.x, y + offset.y, z + offset.z);
+
+                    glm::ivec3 chunkOffset(
+                        local.x < 0 ? -1 : local.x >= CHUNK_SIZE ? 1 : 0,
+                        local.y < 0 ? -1 : local.y >= CHUNK_SIZE ? 1 : 0,
+                        local.z < 0 ? -1 : local.z >= CHUNK_SIZE ? 1 : 0
+                    );
+
+                    // neighbours inside the chunk were merged by the first pass
+                    if(chunkOffset == glm::ivec3(0)) {
+                        continue;
+                    }
+
+                    const LabelledChunk* neighbor = neighbors[(chunkOffset.z + 1) * 9 + (chunkOffset.y + 1) * 3 + chunkOffset.x + 1];
+                    if(!neighbor) {
+                        continue;
+                    }
+
+                    local -= chunkOffset * CHUNK_SIZE;
+                    uint16_t neighborLabel = neighbor->labels[(local.z * CHUNK_SIZE + local.y) * CHUNK_SIZE + local.x];
+
+                    if(neighborLabel != 0) {
+                        unionFind.unite(labelled.firstLabel + label - 1, neighbor->firstLabel + neighborLabel - 1);
+                    }
+                }
+            }
+        }
+    });
+
+    std::vector<uint32_t> roots(labelCount);
+    pool.parallelFor(labelCount, [&](size_t begin, size_t end) {
+        for(size_t i = begin; i < end; ++i) {
+            roots[i] = unionFind.find(static_cast<uint32_t>(i));
+        }
+    });
+
+    // the root of a set is its smallest label, so it comes first
+    result._labelComponents.resize(labelCount);
+    for(uint32_t i = 0; i < labelCount; ++i) {
+        if(roots[i] == i) {
+            result._labelComponents[i] = static_cast<uint32_t>(result._components.size());
+            result._components.emplace_back();
+        } else {
+            result._labelComponents[i] = result._labelComponents[roots[i]];
+        }
+    }
+
+    std::vector<bool> hasVoxels(result._components.size(), false);
+    for(const auto& labelled : result._chunks) {
+        for(size_t local = 0; local < labelled.localComponents.size(); ++local) {
+            const auto& part = labelled.localComponents[local];
+            uint32_t index = result._labelComponents[labelled.firstLabel + local];
+            auto& component = result._components[index];
+
+            if(!hasVoxels[index]) {
+                component.min = part.min;
+                component.max = part.max;
+                hasVoxels[index] = true;
+            }
+
+            component.voxelCount += part.voxelCount;
+            component.min = glm::ivec3(std::min(component.min.x, part.min.x), std::min(component.min.y, part.min.y), std::min(component.min.z, part.min.z));
+            component.max = glm::ivec3(std::max(component.max.x, part.max.x), std::max(component.max.y, part.max.y), std::max(component.max.z, part.max.z));
+        }
+    }
+
+    std::vector<uint32_t> order(result._components.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return result._components[a].voxelCount > result._components[b].voxelCount;
+    });
+
+    std::vector<uint32_t> sortedIndices(order.size());
+    std::vector<WorldComponent> sorted(order.size());
+    for(size_t i = 0; i < order.size(); ++i) {
+        sortedIndices[order[i]] = static_cast<uint32_t>(i);
+        sorted[i] = result._components[order[i]];
+    }
+
+    for(auto& index : result._labelComponents) {
+        index = sortedIndices[index];
+    }
+
+    result._components = std::move(sorted);
+
+    return result;
+}
+
+long WorldComponents::findComponent(const glm::ivec3& voxel) const {
+    if(voxel.x < 0 || voxel.y < 0 || voxel.z < 0) {
+        return -1;
+    }
+
+    auto it = _chunkIndices.find(getChunkKey(voxel.x / CHUNK_SIZE, voxel.y / CHUNK_SIZE, voxel.z / CHUNK_SIZE));
+    if(it == _chunkIndices.end()) {
+        return -1;
+    }
+
+    const auto& labelled = _chunks[it->second];
+    glm::ivec3 local = voxel - labelled.coords * CHUNK_SIZE;
+
+    uint16_t label = labelled.labels[(local.z * CHUNK_SIZE + local.y) * CHUNK_SIZE + local.x];
+    if(label == 0) {
+        return -1;
+    }
+
+    return static_cast<long>(_labelComponents[labelled.firstLabel + label - 1]);
+}
+
+VoxelSelection WorldComponents::selectComponent(size_t index) const {
+    VoxelSelection selection;
+
+    for(const auto& labelled : _chunks) {
+        // local labels that belong to the component, most chunks have none
+        std::vector<bool> selected(labelled.localComponents.size() + 1, false);
+        bool any = false;
+
+        for(size_t local = 0; local < labelled.localComponents.size(); ++local) {
+            if(_labelComponents[labelled.firstLabel + local] == index) {
+                selected[local + 1] = true;
+                any = true;
+            }
+        }
+
+        if(!any) {
+            continue;
+        }
+
+        for(int z = 0; z < CHUNK_SIZE; ++z) {
+            for(int y = 0; y < CHUNK_SIZE; ++y) {
+                const uint16_t* row = labelled.labels.data() + (z * CHUNK_SIZE + y) * CHUNK_SIZE;
+
+                uint16_t mask = 0;
+                for(int x = 0; x < CHUNK_SIZE; ++x) {
+                    mask |= static_cast<uint16_t>(selected[row[x]]) << x;
+                }
+
+                selection.addRow(labelled.coords.x, labelled.coords.y * CHUNK_SIZE + y, labelled.coords.z * CHUNK_SIZE + z, mask);
+            }
+        }
+    }
+
+    return selection;
+}
@@ -0,0 +1,366 @@
+#include "world_generator.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// decorrelates the noise fields drawn from one seed
+const uint32_t GENERATOR_HEIGHT_SEED = 0x68bc21ebu;
+const uint32_t GENERATOR_CAVE_SEED_A = 0x02e5be93u;
+const uint32_t GENERATOR_CAVE_SEED_B = 0x967a889bu;
+const uint32_t GENERATOR_TREE_SEED = 0x3c6ef372u;
+
+// cave noise samples per axis of a chunk, both ends included
+const int CAVE_SAMPLES = CHUNK_SIZE / GENERATOR_CAVE_SPACING + 1;
+
+const float GRADIENTS_2D[8][2] = {
+    { 1.0f, 1.0f }, { -1.0f, 1.0f }, { 1.0f, -1.0f }, { -1.0f, -1.0f },
+    { 1.0f, 0.0f }, { -1.0f, 0.0f }, { 0.0f, 1.0f }, { 0.0f, -1.0f }
+};
+
+// the 12 cube edges, 4 repeated so a hash picks one with a mask
+const float GRADIENTS_3D[16][3] = {
+    { 1.0f, 1.0f, 0.0f }, { -1.0f, 1.0f, 0.0f }, { 1.0f, -1.0f, 0.0f }, { -1.0f, -1.0f, 0.0f },
+    { 1.0f, 0.0f, 1.0f }, { -1.0f, 0.0f, 1.0f }, { 1.0f, 0.0f, -1.0f }, { -1.0f, 0.0f, -1.0f },
+    { 0.0f, 1.0f, 1.0f }, { 0.0f, -1.0f, 1.0f }, { 0.0f, 1.0f, -1.0f }, { 0.0f, -1.0f, -1.0f },
+    { 1.0f, 1.0f, 0.0f }, { -1.0f, 1.0f, 0.0f }, { 0.0f, -1.0f, 1.0f }, { 0.0f, -1.0f, -1.0f }
+};
+
+static uint32_t hashPosition(int x, int y, int z, uint32_t seed) {
+    uint32_t hash = seed;
+    hash ^= static_cast<uint32_t>(x) * 0x27d4eb2du;
+    hash ^= static_cast<uint32_t>(y) * 0x165667b1u;
+    hash ^= static_cast<uint32_t>(z) * 0x9e3779b1u;
+
+    hash ^= hash >> 15;
+    hash *= 0x2c1b3c6du;
+    hash ^= hash >> 12;
+    hash *= 0x297a2d39u;
+    hash ^= hash >> 15;
+
+    return hash;
+}
+
+// 0 to 1 from the high bits of a hash
+static float hashToUnit(uint32_t hash) {
+    return static_cast<float>(hash >> 8) * (1.0f / 16777216.0f);
+}
+
+static float fade(float t) {
+    return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f);
+}
+
+static float lerp(float a, float b, float t) {
+    return a + (b - a) * t;
+}
+
+// gradient noise, about -1 to 1
+static float gradientNoise(float x, float z, uint32_t seed) {
+    int x0 = static_cast<int>(std::floor(x));
+    int z0 = static_cast<int>(std::floor(z));
+    float fx = x - x0;
+    float fz = z - z0;
+
+    auto corner = [&](int dx, int dz) {
+        const float* gradient = GRADIENTS_2D[hashPosition(x0 + dx, 0, z0 + dz, seed) & 7];
+        return gradient[0] * (fx - dx) + gradient[1] * (fz - dz);
+    };
+
+    float u = fade(fx);
+    float v = fade(fz);
+
+    return lerp(lerp(corner(0, 0), corner(1, 0), u), lerp(corner(0, 1), corner(1, 1), u), v);
+}
+
+static float gradientNoise(float x, float y, float z, uint32_t seed) {
+    int x0 = static_cast<int>(std::floor(x));
+    int y0 = static_cast<int>(std::floor(y));
+    int z0 = static_cast<int>(std::floor(z));
+    float fx = x - x0;
+    float fy = y - y0;
+    float fz = z - z0;
+
+    auto corner = [&](int dx, int dy, int dz) {
+        const float* gradient = GRADIENTS_3D[hashPosition(x0 + dx, y0 + dy, z0 + dz, seed) & 15];
+        return gradient[0] * (fx - dx) + gradient[1] * (fy - dy) + gradient[2] * (fz - dz);
+    };
+
+    float u = fade(fx);
+    float v = fade(fy);
+    float w = fade(fz);
+
+    float bottom = lerp(lerp(corner(0, 0, 0), corner(1, 0, 0), u), lerp(corner(0, 0, 1), corner(1, 0, 1), u), w);
+    float top = lerp(lerp(corner(0, 1, 0), corner(1, 1, 0), u), lerp(corner(0, 1, 1), corner(1, 1, 1), u), w);
+
+    return lerp(bottom, top, v);
+}
+
+WorldGenerator::WorldGenerator(const WorldGeneratorSettings& settings) : _settings(settings) {
+}
+
+void WorldGenerator::addPass(Pass pass) {
+    _passes.push_back(std::move(pass));
+}
+
+int WorldGenerator::getHeight(int x, int z) const {
+    float frequency = _settings.heightFrequency;
+    float amplitude = 1.0f;
+    float sum = 0.0f;
+    float total = 0.0f;
+
+    for(int octave = 0; octave < _settings.heightOctaves; ++octave) {
+        sum += amplitude * gradientNoise(x * frequency, z * frequency, _settings.seed ^ (GENERATOR_HEIGHT_SEED + octave));
+        total += amplitude;
+
+        frequency *= 2.0f;
+        amplitude *= 0.5f;
+    }
+
+    float noise = total > 0.0f ? std::clamp(sum / total, -1.0f, 1.0f) : 0.0f;
+
+    return std::max(0, static_cast<int>(std::floor(_settings.baseHeight + _settings.heightAmplitude * noise)));
+}
+
+bool WorldGenerator::generateChunk(const glm::ivec3& coords, unsigned char* blocks) const {
+    int heights[CHUNK_SIZE * CHUNK_SIZE];
+    computeHeights(coords.x, coords.z, heights);
+
+    return generateChunk(coords, heights, blocks);
+}
+
+size_t WorldGenerator::generate(World& world, const glm::ivec3& minChunk, const glm::ivec3& maxChunk, core::ThreadPool& pool) const {
+    glm::ivec3 min = glm::max(minChunk, glm::ivec3(0));
+    glm::ivec3 max = maxChunk;
+    if(min.x > max.x || min.y > max.y || min.z > max.z) {
+        return 0;
+    }
+
+    int columnsX = max.x - min.x + 1;
+    int columnsZ = max.z - min.z + 1;
+
+    // the heightmap once per column of chunks instead of once per chunk
+    std::vector<int> heights(static_cast<size_t>(columnsX) * columnsZ * CHUNK_SIZE * CHUNK_SIZE);
+    pool.parallelFor(static_cast<size_t>(columnsX) * columnsZ, [&](size_t begin, size_t end) {
+        for(size_t column = begin; column < end; ++column) {
+            int x = min.x + static_cast<int>(column % columnsX);
+            int z = min.z + static_cast<int>(column / columnsX);
+            computeHeights(x, z, &heights[column * CHUNK_SIZE * CHUNK_SIZE]);
+        }
+    });
+
+    std::vector<glm::ivec3> coords;
+    coords.reserve(heights.size() / (CHUNK_SIZE * CHUNK_SIZE) * (max.y - min.y + 1));
+    for(int z = min.z; z <= max.z; ++z) {
+        for(int x = min.x; x <= max.x; ++x) {
+            for(int y = min.y; y <= max.y; ++y) {
+                coords.emplace_back(x, y, z);
+            }
+        }
+    }
+
+    return world.fillChunks(coords, [&](const glm::ivec3& chunkCoords, unsigned char* blocks) {
+        size_t column = static_cast<size_t>(chunkCoords.z - min.z) * columnsX + (chunkCoords.x - min.x);
+        return generateChunk(chunkCoords, &heights[column * CHUNK_SIZE * CHUNK_SIZE], blocks);
+    }, pool);
+}
+
+void WorldGenerator::computeHeights(int chunkX, int chunkZ, int* outHeights) const {
+    for(int z = 0; z < CHUNK_SIZE; ++z) {
+        for(int x = 0; x < CHUNK_SIZE; ++x) {
+            outHeights[z * CHUNK_SIZE + x] = getHeight(chunkX * CHUNK_SIZE + x, chunkZ * CHUNK_SIZE + z);
+        }
+    }
+}
+
+bool WorldGenerator::generateChunk(const glm::ivec3& coords, const int* heights, unsigned char* blocks) const {
+    // highest voxel the built-in passes write, the tallest tree on the highest ground
+    int maxHeight = static_cast<int>(std::ceil(_settings.baseHeight + _settings.heightAmplitude));
+    int maxFeature = maxHeight + _settings.treeHeight + 1 + _settings.treeCrownRadius;
+
+    if(_passes.empty() && coords.y * CHUNK_SIZE > maxFeature) {
+        return false;
+    }
+
+    GeneratorChunk chunk = { coords, heights, blocks };
+
+    fillTerrain(chunk);
+    carveCaves(chunk);
+    scatterTrees(chunk);
+
+    for(const auto& pass : _passes) {
+        pass(chunk);
+    }
+
+    return countSolidBlocks(blocks, CHUNK_VOLUME) > 0;
+}
+
+void WorldGenerator::fillTerrain(const GeneratorChunk& chunk) const {
+    int baseY = chunk.coords.y * CHUNK_SIZE;
+    int topHeight = *std::max_element(chunk.heights, chunk.heights + CHUNK_SIZE * CHUNK_SIZE);
+    int rows = std::min(CHUNK_SIZE, topHeight - baseY + 1);
+
+    for(int z = 0; z < CHUNK_SIZE; ++z) {
+        const int* columnHeights = chunk.heights + z * CHUNK_SIZE;
+
+        for(int y = 0; y < rows; ++y) {
+            int worldY = baseY + y;
+            unsigned char* row = chunk.blocks + z * CHUNK_SIZE * CHUNK_SIZE + y * CHUNK_SIZE;
+
+            for(int x = 0; x < CHUNK_SIZE; ++x) {
+                int height = columnHeights[x];
+
+                unsigned char block = 0;
+                if(worldY == height) {
+                    block = _settings.grassBlock;
+                } else if(worldY < height) {
+                    block = worldY > height - _settings.dirtDepth ? _settings.dirtBlock : _settings.stoneBlock;
+                }
+
+                row[x] = block;
+            }
+        }
+    }
+}
+
+void WorldGenerator::carveCaves(const GeneratorChunk& chunk) const {
+    if(!_settings.caves) {
+        return;
+    }
+
+    int baseY = chunk.coords.y * CHUNK_SIZE;
+    int topHeight = *std::max_element(chunk.heights, chunk.heights + CHUNK_SIZE * CHUNK_SIZE);
+    int rows = std::min(CHUNK_SIZE, topHeight - _settings.caveCrust - baseY + 1);
+    if(rows <= 0) {
+        return;
+    }
+
+    // two noise fields on the lattice, tunnels run where both are near zero
+    float fieldA[CAVE_SAMPLES][CAVE_SAMPLES][CAVE_SAMPLES];
+    float fieldB[CAVE_SAMPLES][CAVE_SAMPLES][CAVE_SAMPLES];
+
+    glm::ivec3 base = chunk.coords * CHUNK_SIZE;
+    float frequency = _settings.caveFrequency;
+
+    for(int z = 0; z < CAVE_SAMPLES; ++z) {
+        for(int y = 0; y < CAVE_SAMPLES; ++y) {
+            for(int x = 0; x < CAVE_SAMPLES; ++x) {
+                float sampleX = (base.x + x * GENERATOR_CAVE_SPACING) * frequency;
+                float sampleY = (base.y + y * GENERATOR_CAVE_SPACING) * frequency;
+                float sampleZ = (base.z + z * GENERATOR_CAVE_SPACING) * frequency;
+
+                fieldA[z][y][x] = gradientNoise(sampleX, sampleY, sampleZ, _settings.seed ^ GENERATOR_CAVE_SEED_A);
+                fieldB[z][y][x] = gradientNoise(sampleX, sampleY, sampleZ, _settings.seed ^ GENERATOR_CAVE_SEED_B);
+            }
+        }
+    }
+
+    float widthSquared = _settings.caveWidth * _settings.caveWidth;
+    const float step = 1.0f / GENERATOR_CAVE_SPACING;
+
+    for(int z = 0; z < CHUNK_SIZE; ++z) {
+        int sampleZ = z / GENERATOR_CAVE_SPACING;
+        float tz = (z % GENERATOR_CAVE_SPACING) * step;
+
+        for(int y = 0; y < rows; ++y) {
+            int worldY = baseY + y;
+            if(worldY < 1) {
+                continue;
+            }
+
+            int sampleY = y / GENERATOR_CAVE_SPACING;
+            float ty = (y % GENERATOR_CAVE_SPACING) * step;
+
+            // the lattice row at this y and z, then every voxel of the row
+            float rowA[CAVE_SAMPLES];
+            float rowB[CAVE_SAMPLES];
+            for(int x = 0; x < CAVE_SAMPLES; ++x) {
+                rowA[x] = lerp(
+                    lerp(fieldA[sampleZ][sampleY][x], fieldA[sampleZ][sampleY + 1][x], ty),
+                    lerp(fieldA[sampleZ + 1][sampleY][x], fieldA[sampleZ + 1][sampleY + 1][x], ty), tz);
+                rowB[x] = lerp(
+                    lerp(fieldB[sampleZ][sampleY][x], fieldB[sampleZ][sampleY + 1][x], ty),
+                    lerp(fieldB[sampleZ + 1][sampleY][x], fieldB[sampleZ + 1][sampleY + 1][x], ty), tz);
+            }
+
+            const int* columnHeights = chunk.heights + z * CHUNK_SIZE;
+            unsigned char* row = chunk.blocks + z * CHUNK_SIZE * CHUNK_SIZE + y * CHUNK_SIZE;
+
+            for(int x = 0; x < CHUNK_SIZE; ++x) {
+                int sampleX = x / GENERATOR_CAVE_SPACING;
+                float tx = (x % GENERATOR_CAVE_SPACING) * step;
+
+                float a = lerp(rowA[sampleX], rowA[sampleX + 1], tx);
+                float b = lerp(rowB[sampleX], rowB[sampleX + 1], tx);
+
+                bool carve = a * a + b * b < widthSquared && worldY <= columnHeights[x] - _settings.caveCrust;
+                row[x] = carve ? 0 : row[x];
+            }
+        }
+    }
+}
+
+void WorldGenerator::scatterTrees(const GeneratorChunk& chunk) const {
+    if(_settings.treeDensity <= 0.0f) {
+        return;
+    }
+
+    int radius = _settings.treeCrownRadius;
+    glm::ivec3 base = chunk.coords * CHUNK_SIZE;
+
+    // no tree reaches below the lowest ground or above the highest crown
+    int minHeight = static_cast<int>(std::floor(_settings.baseHeight - _settings.heightAmplitude));
+    int maxHeight = static_cast<int>(std::ceil(_settings.baseHeight + _settings.heightAmplitude));
+    if(base.y + CHUNK_SIZE <= minHeight || base.y > maxHeight + _settings.treeHeight + 1 + radius) {
+        return;
+    }
+
+    auto write = [&](int x, int y, int z, unsigned char block, bool overAirOnly) {
+        x -= base.x;
+        y -= base.y;
+        z -= base.z;
+
+        if(x < 0 || y < 0 || z < 0 || x >= CHUNK_SIZE || y >= CHUNK_SIZE || z >= CHUNK_SIZE) {
+            return;
+        }
+
+        unsigned char& target = chunk.blocks[z * CHUNK_SIZE * CHUNK_SIZE + y * CHUNK_SIZE + x];
+        if(!overAirOnly || target == 0) {
+            target = block;
+        }
+    };
+
+    // trees standing close enough for their crowns to reach into the chunk
+    for(int anchorZ = base.z - radius; anchorZ < base.z + CHUNK_SIZE + radius; ++anchorZ) {
+        for(int anchorX = base.x - radius; anchorX < base.x + CHUNK_SIZE + radius; ++anchorX) {
+            uint32_t hash = hashPosition(anchorX, 0, anchorZ, _settings.seed ^ GENERATOR_TREE_SEED);
+            if(hashToUnit(hash) >= _settings.treeDensity) {
+                continue;
+            }
+
+            int localX = anchorX - base.x;
+            int localZ = anchorZ - base.z;
+            bool inChunk = localX >= 0 && localZ >= 0 && localX < CHUNK_SIZE && localZ < CHUNK_SIZE;
+            int ground = inChunk ? chunk.heights[localZ * CHUNK_SIZE + localX] : getHeight(anchorX, anchorZ);
+
+            // one voxel shorter or taller than the setting
+            int top = ground + _settings.treeHeight + static_cast<int>(hashPosition(anchorX, 1, anchorZ, _settings.seed ^ GENERATOR_TREE_SEED) % 3) - 1;
+
+            if(base.y > top + radius || base.y + CHUNK_SIZE <= ground) {
+                continue;
+            }
+
+            for(int dz = -radius; dz <= radius; ++dz) {
+                for(int dy = -radius; dy <= radius; ++dy) {
+                    for(int dx = -radius; dx <= radius; ++dx) {
+                        if(dx * dx + dy * dy + dz * dz <= radius * radius + 1) {
+                            write(anchorX + dx, top + dy, anchorZ + dz, _settings.leavesBlock, true);
+                        }
+                    }
+                }
+            }
+
+            for(int y = ground + 1; y <= top; ++y) {
+                write(anchorX, y, anchorZ, _settings.trunkBlock, false);
+            }
+        }
+    }
+}
@@ -0,0 +1,139 @@
+#include "world_journal.hpp"
+#include "world.hpp"
+#include "engine/core/filesystem.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+static uint32_t fnv1a(const char* data, size_t size) {
+    uint32_t hash = 2166136261u;
+    for(size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+std::string getWorldJournalPath(const std::string& worldPath) {
+    return worldPath + ".journal";
+}
+
+void writeWorldJournalHeader(core::BinaryWriter& writer, uint16_t saveId) {
+    writer.write<uint32_t>(WORLD_JOURNAL_MAGIC);
+    writer.write<uint16_t>(WORLD_JOURNAL_VERSION);
+    writer.write<uint16_t>(saveId);
+}
+
+std::optional<uint16_t> readWorldJournalSaveId(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+
+    char header[8];
+    if(!file.read(header, sizeof(header))) {
+        return std::nullopt;
+    }
+
+    core::BinaryReader reader(header, sizeof(header));
+    if(reader.read<uint32_t>() != WORLD_JOURNAL_MAGIC) {
+        return std::nullopt;
+    }
+
+    reader.read<uint16_t>(); // version
+    return reader.read<uint16_t>();
+}
+
+void writeWorldJournalRecord(
+    core::BinaryWriter& writer, WorldJournalRecordType type, const glm::ivec3& chunk,
+    ChunkEncoding encoding, const std::string& payload
+) {
+    std::string record;
+    core::BinaryWriter recordWriter(record);
+
+    recordWriter.write<uint8_t>(static_cast<uint8_t>(type));
+    recordWriter.write<uint8_t>(static_cast<uint8_t>(encoding));
+    recordWriter.write<uint16_t>(0);
+    recordWriter.write<int32_t>(chunk.x);
+    recordWriter.write<int32_t>(chunk.y);
+    recordWriter.write<int32_t>(chunk.z);
+    recordWriter.write<uint32_t>(static_cast<uint32_t>(payload.size()));
+    recordWriter.writeBytes(payload.data(), payload.size());
+
+    writer.writeBytes(record.data(), record.size());
+    writer.write<uint32_t>(fnv1a(record.data(), record.size()));
+}
+
+size_t replayWorldJournal(World& world, const std::string& path) {
+    if(!std::filesystem::exists(path)) {
+        return 0;
+    }
+
+    std::string journal = core::FileSystem::readFromFile(path);
+    core::BinaryReader reader(journal);
+
+    if(reader.getRemaining() < 8 || reader.read<uint32_t>() != WORLD_JOURNAL_MAGIC) {
+        throw std::runtime_error("Not a world journal: " + path);
+    }
+
+    uint16_t version = reader.read<uint16_t>();
+    if(version > WORLD_JOURNAL_VERSION) {
+        throw std::runtime_error("World journal version " + std::to_string(version) + " is newer than supported.");
+    }
+
+    uint16_t saveId = reader.read<uint16_t>();
+    uint16_t worldSaveId = world.getRegion() ? world.getRegion()->getSaveId() : 0;
+
+    if(saveId != worldSaveId) {
+        // appends go to a new journal instead of one that is never replayed
+        std::cout << "World journal " << path << " is older than the world file, discarded." << std::endl;
+        std::filesystem::remove(path);
+        return 0;
+    }
+
+    size_t applied = 0;
+    ChunkBlocks blocks;
+
+    while(reader.getRemaining() > 0) {
+        size_t recordStart = reader.getPosition();
+
+        try {
+            auto type = static_cast<WorldJournalRecordType>(reader.read<uint8_t>());
+            auto encoding = static_cast<ChunkEncoding>(reader.read<uint8_t>());
+            reader.read<uint16_t>();
+
+            int x = reader.read<int32_t>();
+            int y = reader.read<int32_t>();
+            int z = reader.read<int32_t>();
+
+            uint32_t payloadSize = reader.read<uint32_t>();
+            const char* payload = reader.skip(payloadSize);
+
+            size_t recordSize = reader.getPosition() - recordStart;
+            if(reader.read<uint32_t>() != fnv1a(journal.data() + recordStart, recordSize)) {
+                throw std::runtime_error("checksum mismatch");
+            }
+
+            if(type == WorldJournalRecordType::CHUNK) {
+                decodeChunkBlocks(encoding, payload, payloadSize, blocks.data());
+
+                Chunk* chunk = world.createChunk(x, y, z);
+                if(chunk) {
+                    chunk->assignBlocks(blocks.data());
+                }
+            } else if(type == WorldJournalRecordType::REMOVED) {
+                world.removeChunk(x, y, z);
+            } else {
+                throw std::runtime_error("unknown record type");
+            }
+        } catch(const std::exception& e) {
+            // the tail of a journal that was being appended to during a crash
+            std::cerr << "World journal " << path << " ends in a damaged record at byte "
+                      << recordStart << " (" << e.what() << "), " << applied << " records replayed." << std::endl;
+            break;
+        }
+
+        applied++;
+    }
+
+    return applied;
+}
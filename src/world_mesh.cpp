@@ -0,0 +1,296 @@
+#include "world_mesh.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// caps snapshot memory when a zoom out switches every chunk at once
+const int MAX_PENDING_LOD_BUILDS = 64;
+// a chunk only goes back to a finer level once it is this far past the
+// threshold, so chunks sitting right at it don't flicker between levels
+const float LOD_HYSTERESIS = 1.1f;
+// below this many dirty chunks meshing stays on the main thread
+const size_t MIN_PARALLEL_MESH_CHUNKS = 8;
+// chunks meshed per parallel batch, bounds the CPU side mesh memory held before upload
+const size_t PARALLEL_MESH_BATCH = 512;
+
+WorldMesh::WorldMesh(World* world)
+    : _world(world), _threadPool(core::ThreadPool::getDefault()) {
+    _lodBuilds = std::make_shared<LodBuildQueue>();
+}
+
+void WorldMesh::syncChunks() {
+    for (auto it = _chunkMeshes.begin(); it != _chunkMeshes.end(); ) {
+        if (_world->getChunks().find(it->first) == _world->getChunks().end()) {
+            it = _chunkMeshes.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    std::vector<ChunkMesh*> dirtyMeshes;
+
+    for (auto& [key, chunk] : _world->getChunks()) {
+        if (chunk->isDirty()) {
+            // a chunk that was unloaded or replaced and came back under the same key
+            auto it = _chunkMeshes.find(key);
+            if (it == _chunkMeshes.end() || it->second->getChunk() != chunk.get()) {
+                _chunkMeshes[key] = std::make_unique<ChunkMesh>(chunk.get());
+            }
+
+            dirtyMeshes.push_back(_chunkMeshes[key].get());
+            chunk->setDirty(false);
+        }
+    }
+
+    if (dirtyMeshes.size() < MIN_PARALLEL_MESH_CHUNKS) {
+        for (auto mesh : dirtyMeshes) {
+            mesh->updateMesh();
+        }
+
+        return;
+    }
+
+    // a whole world loading at once, build on all cores and upload from here
+    std::vector<ChunkMeshData> batch(std::min(dirtyMeshes.size(), PARALLEL_MESH_BATCH));
+
+    for (size_t batchStart = 0; batchStart < dirtyMeshes.size(); batchStart += PARALLEL_MESH_BATCH) {
+        size_t batchSize = std::min(PARALLEL_MESH_BATCH, dirtyMeshes.size() - batchStart);
+
+        // the main thread waits inside parallelFor, so the chunks can't change meanwhile
+        _threadPool.parallelFor(batchSize, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                buildChunkMeshData(getChunkBlocksView(*dirtyMeshes[batchStart + i]->getChunk()), 0, batch[i]);
+            }
+        });
+
+        for (size_t i = 0; i < batchSize; ++i) {
+            dirtyMeshes[batchStart + i]->updateMesh(batch[i]);
+        }
+    }
+}
+
+void WorldMesh::update() {
+    _frame++;
+
+    syncChunks();
+    collectLodBuilds();
+
+    for(auto& [key, mesh] : _chunkMeshes) {
+        if(!mesh->isLodCurrent(0)) {
+            mesh->restoreMesh();
+        }
+
+        mesh->setVisible(true);
+        mesh->setDrawLod(0, false);
+        mesh->markLodUsed(0, _frame);
+    }
+
+    updateMemoryStats();
+}
+
+void WorldMesh::update(const Camera& camera, float viewportHeight) {
+    _frame++;
+
+    Frustum frustum(camera.getProjectionMatrix() * camera.getViewMatrix());
+    syncChunks();
+    collectLodBuilds();
+
+    for(auto& [key, mesh] : _chunkMeshes) {
+        const Chunk& chunk = *mesh->getChunk();
+
+        glm::vec3 min = glm::vec3(chunk.getX(), chunk.getY(), chunk.getZ()) * static_cast<float>(CHUNK_SIZE);
+        glm::vec3 max = min + glm::vec3(static_cast<float>(CHUNK_SIZE));
+
+        bool visible = chunk.getBlockCount() > 0 && frustum.intersectsAABB(min, max);
+        mesh->setVisible(visible);
+
+        if(!visible) {
+            continue;
+        }
+
+        int lod = 0;
+        if(_lodSettings.enabled) {
+            lod = selectLod(getVoxelPixelSize(camera, viewportHeight, chunk), mesh->getDrawLod());
+
+            if(!mesh->isLodCurrent(lod) && !mesh->isLodPending(lod)) {
+                requestLod(key, *mesh, lod);
+            }
+
+            // until the wanted level is built, draw the closest finer one that is
+            while(lod > 0 && !mesh->isLodCurrent(lod)) {
+                lod--;
+            }
+        }
+
+        // evicted while out of view
+        if(lod == 0 && !mesh->isLodCurrent(0)) {
+            mesh->restoreMesh();
+        }
+
+        mesh->setDrawLod(lod, false);
+        mesh->markLodUsed(lod, _frame);
+    }
+
+    updateSkirts();
+    updateMemoryStats();
+    enforceGpuBudget();
+}
+
+float WorldMesh::getVoxelPixelSize(const Camera& camera, float viewportHeight, const Chunk& chunk) const {
+    if(camera.projectionType == ProjectionType::ORTHOGRAPHIC) {
+        float height = (camera.orthoSettings.top - camera.orthoSettings.bottom) * camera.orthoSettings.zoom;
+        return viewportHeight / std::max(height, 0.0001f);
+    }
+
+    glm::vec3 min = glm::vec3(chunk.getX(), chunk.getY(), chunk.getZ()) * static_cast<float>(CHUNK_SIZE);
+    glm::vec3 max = min + glm::vec3(static_cast<float>(CHUNK_SIZE));
+
+    // size at the closest point of the chunk, so a chunk never looks coarse up close
+    glm::vec3 closest = glm::clamp(camera.position, min, max);
+    float distance = std::max(glm::length(camera.position - closest), camera.near);
+
+    float height = 2.0f * distance * std::tan(glm::radians(camera.perspSettings.fov) * 0.5f);
+    return viewportHeight / height;
+}
+
+int WorldMesh::selectLod(float voxelPixelSize, int currentLod) const {
+    const float thresholds[CHUNK_LOD_COUNT] = {
+        0.0f,
+        _lodSettings.lod1PixelSize,
+        _lodSettings.lod2PixelSize
+    };
+
+    for(int lod = CHUNK_LOD_COUNT - 1; lod > 0; --lod) {
+        float threshold = thresholds[lod];
+        if(lod <= currentLod) {
+            threshold *= LOD_HYSTERESIS;
+        }
+
+        if(voxelPixelSize < threshold) {
+            return lod;
+        }
+    }
+
+    return 0;
+}
+
+void WorldMesh::requestLod(uint64_t key, ChunkMesh& mesh, int lod) {
+    if(_pendingLodBuilds >= MAX_PENDING_LOD_BUILDS) {
+        return;
+    }
+
+    auto snapshot = std::make_shared<ChunkSnapshot>(takeChunkSnapshot(*mesh.getChunk()));
+    auto builds = _lodBuilds;
+    uint64_t revision = mesh.getRevision();
+
+    mesh.setLodPending(lod);
+    _pendingLodBuilds++;
+
+    _threadPool.submit([snapshot, builds, key, lod, revision]() {
+        LodBuildResult result { key, lod, revision, {} };
+        buildChunkMeshData(snapshot->view(), lod, result.data);
+
+        std::lock_guard<std::mutex> lock(builds->mutex);
+        builds->results.push_back(std::move(result));
+    });
+}
+
+void WorldMesh::collectLodBuilds() {
+    std::vector<LodBuildResult> results;
+
+    {
+        std::lock_guard<std::mutex> lock(_lodBuilds->mutex);
+        results.swap(_lodBuilds->results);
+    }
+
+    for(auto& result : results) {
+        _pendingLodBuilds--;
+
+        auto it = _chunkMeshes.find(result.key);
+        if(it == _chunkMeshes.end()) {
+            continue;
+        }
+
+        // the chunk changed while this was building, it gets requested again
+        if(result.revision != it->second->getRevision()) {
+            it->second->clearLodPending(result.lod);
+            continue;
+        }
+
+        it->second->uploadLod(result.lod, result.data, result.revision);
+    }
+}
+
+void WorldMesh::enforceGpuBudget() {
+    if(_gpuBudget == 0 || _memoryStats.totalBytes <= _gpuBudget) {
+        return;
+    }
+
+    struct Candidate {
+        uint64_t lastUsedFrame;
+        ChunkMesh* mesh;
+        int lod;
+    };
+
+    std::vector<Candidate> candidates;
+    for(auto& [key, mesh] : _chunkMeshes) {
+        for(int lod = 0; lod < CHUNK_LOD_COUNT; ++lod) {
+            if(mesh->isLodResident(lod) && mesh->getLodLastUsedFrame(lod) != _frame) {
+                candidates.push_back({ mesh->getLodLastUsedFrame(lod), mesh.get(), lod });
+            }
+        }
+    }
+
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+        return a.lastUsedFrame < b.lastUsedFrame;
+    });
+
+    for(const auto& candidate : candidates) {
+        if(_memoryStats.totalBytes <= _gpuBudget) {
+            break;
+        }
+
+        size_t bytes = candidate.mesh->releaseLod(candidate.lod);
+
+        _memoryStats.currentBytes[candidate.lod] -= bytes;
+        _memoryStats.totalBytes -= bytes;
+        _memoryStats.evictions++;
+    }
+}
+
+void WorldMesh::updateMemoryStats() {
+    _memoryStats.currentBytes.fill(0);
+    _memoryStats.totalBytes = 0;
+
+    for(auto& [key, mesh] : _chunkMeshes) {
+        for(int lod = 0; lod < CHUNK_LOD_COUNT; ++lod) {
+            _memoryStats.currentBytes[lod] += mesh->getLodBytes(lod);
+        }
+    }
+
+    for(int lod = 0; lod < CHUNK_LOD_COUNT; ++lod) {
+        _memoryStats.totalBytes += _memoryStats.currentBytes[lod];
+        _memoryStats.peakBytes[lod] = std::max(_memoryStats.peakBytes[lod], _memoryStats.currentBytes[lod]);
+    }
+
+    _memoryStats.peakTotalBytes = std::max(_memoryStats.peakTotalBytes, _memoryStats.totalBytes);
+}
+
+void WorldMesh::updateSkirts() {
+    for(auto& [key, mesh] : _chunkMeshes) {
+        const Chunk& chunk = *mesh->getChunk();
+        bool drawSkirts = false;
+
+        for(int face = 0; face < 6 && !drawSkirts; ++face) {
+            auto it = _chunkMeshes.find(getChunkKey(
+                chunk.getX() + FACE_DIRECTIONS[face].x,
+                chunk.getY() + FACE_DIRECTIONS[face].y,
+                chunk.getZ() + FACE_DIRECTIONS[face].z
+            ));
+
+            drawSkirts = it != _chunkMeshes.end() && it->second->getDrawLod() != mesh->getDrawLod();
+        }
+
+        mesh->setDrawLod(mesh->getDrawLod(), drawSkirts);
+    }
+}
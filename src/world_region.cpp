@@ -0,0 +1,95 @@
+#include "world_region.hpp"
+#include "world.hpp"
+
+WorldRegion::WorldRegion(unique<core::MappedFile> file, const WorldFileHeader& header)
+    : _file(std::move(file)), _header(header) {
+}
+
+unique<WorldRegion> WorldRegion::open(const std::string& path) {
+    auto file = core::MappedFile::open(path);
+    core::BinaryReader reader(file->getData(), file->getSize());
+
+    WorldFileHeader header;
+    if(!readWorldFileHeader(reader, header)) {
+        return nullptr;
+    }
+
+    return unique<WorldRegion>(new WorldRegion(std::move(file), header));
+}
+
+WorldFileChunkEntry WorldRegion::getEntry(size_t index) const {
+    core::BinaryReader reader(_file->getData(), _file->getSize());
+    reader.seek(_header.tableOffset + index * WORLD_FILE_CHUNK_ENTRY_SIZE);
+
+    return readWorldFileChunkEntry(reader);
+}
+
+glm::ivec3 WorldRegion::getChunkCoords(size_t index) const {
+    auto entry = getEntry(index);
+    return glm::ivec3(entry.x, entry.y, entry.z);
+}
+
+long WorldRegion::findEntry(int x, int y, int z) const {
+    uint64_t key = getChunkKey(x, y, z);
+
+    size_t low = 0;
+    size_t high = _header.chunkCount;
+
+    while(low < high) {
+        size_t middle = low + (high - low) / 2;
+        auto entry = getEntry(middle);
+        uint64_t middleKey = getChunkKey(entry.x, entry.y, entry.z);
+
+        if(middleKey == key) {
+            return static_cast<long>(middle);
+        } else if(middleKey < key) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    return -1;
+}
+
+bool WorldRegion::contains(int x, int y, int z) const {
+    if(x < 0 || y < 0 || z < 0) {
+        return false;
+    }
+
+    return findEntry(x, y, z) >= 0;
+}
+
+bool WorldRegion::readChunk(int x, int y, int z, unsigned char* outBlocks) const {
+    if(x < 0 || y < 0 || z < 0) {
+        return false;
+    }
+
+    long index = findEntry(x, y, z);
+    if(index < 0) {
+        return false;
+    }
+
+    readChunkAt(static_cast<size_t>(index), outBlocks);
+    return true;
+}
+
+void WorldRegion::readChunkAt(size_t index, unsigned char* outBlocks) const {
+    WorldFileChunkEntry entry;
+    const char* payload = getChunkPayloadAt(index, entry);
+
+    decodeChunkBlocks(entry.encoding, payload, entry.payloadSize, outBlocks);
+}
+
+const char* WorldRegion::getChunkPayloadAt(size_t index, WorldFileChunkEntry& outEntry) const {
+    outEntry = getEntry(index);
+
+    if(outEntry.payloadOffset > _file->getSize()) {
+        throw std::runtime_error("Corrupt world file: chunk payload outside of file.");
+    }
+
+    core::BinaryReader reader(_file->getData(), _file->getSize());
+    reader.seek(static_cast<size_t>(outEntry.payloadOffset));
+
+    return reader.skip(outEntry.payloadSize);
+}
@@ -0,0 +1,367 @@
+#include "world_saver.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <unordered_set>
+
+WorldSaver::WorldSaver()
+#ifdef __EMSCRIPTEN__
+    : _pool(0) {
+#else
+    : _pool(1) {
+#endif
+}
+
+WorldSaver::~WorldSaver() {
+    wait();
+}
+
+void WorldSaver::submit(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _pendingJobs++;
+    }
+
+    _pool.submit([this, job = std::move(job)]() mutable {
+        job();
+
+        // drops the snapshot, chunks stop copying their blocks on write once it is gone
+        job = nullptr;
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _pendingJobs--;
+        }
+
+        _condition.notify_all();
+    });
+}
+
+void WorldSaver::applyCompletedSave(World& world) {
+    std::shared_ptr<const WorldSnapshot> completed;
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if(_completedSaveWorld != &world) {
+            return;
+        }
+
+        completed = std::move(_completedSave);
+        path = std::move(_completedSavePath);
+        _completedSaveWorld = nullptr;
+    }
+
+    world.markSnapshotSaved(*completed);
+
+    try {
+        auto region = WorldRegion::open(path);
+        if(region) {
+            world.adoptSavedRegion(std::move(region), *completed);
+        }
+    } catch(const std::exception& e) {
+        // the world keeps its previous region, edited chunks just stay loaded
+        std::cerr << "Failed to map saved world " << path << ": " << e.what() << std::endl;
+    }
+}
+
+uint16_t WorldSaver::getFileSaveId(const World& world) {
+    if(!_fileSaveIdKnown) {
+        _fileSaveId = world.getRegion() ? world.getRegion()->getSaveId() : 0;
+        _fileSaveIdKnown = true;
+    }
+
+    return _fileSaveId;
+}
+
+bool WorldSaver::save(World& world, const std::string& path) {
+    if(_saving.exchange(true)) {
+        return false;
+    }
+
+    applyCompletedSave(world);
+
+    std::shared_ptr<WorldSnapshot> snapshot;
+    try {
+        snapshot = std::make_shared<WorldSnapshot>(world.takeSnapshot());
+    } catch(...) {
+        _saving = false;
+        throw;
+    }
+
+    // Changes stay marked until the file is written, edits made meanwhile
+    // have newer revisions and stay marked after, see World::markSnapshotSaved
+    // 0 is left to files saved without an id
+    uint16_t saveId = static_cast<uint16_t>(getFileSaveId(world) + 1);
+    if(saveId == 0) {
+        saveId = 1;
+    }
+
+    submit([this, snapshot, path, saveId, worldPointer = &world]() {
+        try {
+            writeSnapshot(*snapshot, path, saveId);
+            _fileSaveId = saveId;
+            resetJournal(getWorldJournalPath(path), saveId);
+
+            // only revisions are needed from here, chunks stop copying their blocks on write
+            for(auto& chunk : snapshot->chunks) {
+                chunk.blocks.reset();
+            }
+            snapshot->region.reset();
+
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _completedSave = snapshot;
+                _completedSaveWorld = worldPointer;
+                _completedSavePath = path;
+            }
+
+            auto stats = getLastSaveStats();
+            std::cout << "World saved to " << path << " (" << stats.payloadCount << " of " << stats.chunkCount
+                      << " chunks stored, " << stats.savedBytes << " bytes shared)" << std::endl;
+        } catch(const std::exception& e) {
+            std::cerr << "Failed to save world: " << e.what() << std::endl;
+        }
+
+        _saving = false;
+    });
+
+    return true;
+}
+
+bool WorldSaver::appendJournal(World& world, const std::string& path) {
+    if(_saving) {
+        return false;
+    }
+
+    applyCompletedSave(world);
+    getFileSaveId(world);
+
+    auto changes = std::make_shared<WorldSnapshot>(world.takeChanges());
+    if(changes->chunks.empty() && changes->removedChunks.empty()) {
+        return false;
+    }
+
+    submit([this, changes, path]() {
+        try {
+            writeJournal(*changes, getWorldJournalPath(path));
+        } catch(const std::exception& e) {
+            // the changes are still in the world and go out with the next full save
+            std::cerr << "Failed to append to world journal: " << e.what() << std::endl;
+        }
+    });
+
+    return true;
+}
+
+WorldSaveStats WorldSaver::getLastSaveStats() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _lastSaveStats;
+}
+
+void WorldSaver::wait() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _condition.wait(lock, [this]() { return _pendingJobs == 0; });
+}
+
+const WorldSaver::EncodedChunk& WorldSaver::encodeChunk(const WorldSnapshot::ChunkEntry& chunk) {
+    auto& encoded = _encodedChunks[getChunkKey(chunk.x, chunk.y, chunk.z)];
+
+    if(encoded.payload.empty() || encoded.revision != chunk.revision) {
+        encoded.revision = chunk.revision;
+        encoded.payload.clear();
+        encoded.encoding = encodeChunkBlocks(chunk.blocks->data(), encoded.payload);
+    }
+
+    return encoded;
+}
+
+void WorldSaver::writeSnapshot(const WorldSnapshot& snapshot, const std::string& path, uint16_t saveId) {
+    struct FileChunk {
+        uint64_t key;
+        WorldFileChunkEntry entry;
+        const char* payload;
+        // the entry points at the payload of an identical chunk
+        bool shared = false;
+    };
+
+    std::vector<FileChunk> chunks;
+    chunks.reserve(snapshot.chunks.size() + snapshot.regionChunks.size());
+
+    std::unordered_set<uint64_t> snapshotKeys;
+    snapshotKeys.reserve(snapshot.chunks.size());
+
+    for(const auto& chunk : snapshot.chunks) {
+        const auto& encoded = encodeChunk(chunk);
+
+        FileChunk fileChunk;
+        fileChunk.key = getChunkKey(chunk.x, chunk.y, chunk.z);
+        fileChunk.entry = { chunk.x, chunk.y, chunk.z, 0, static_cast<uint32_t>(encoded.payload.size()), encoded.encoding };
+        fileChunk.payload = encoded.payload.data();
+
+        chunks.push_back(fileChunk);
+        snapshotKeys.insert(fileChunk.key);
+    }
+
+    // chunks removed since don't need their payloads anymore, erasing
+    // doesn't move the payloads referenced above
+    for(auto it = _encodedChunks.begin(); it != _encodedChunks.end(); ) {
+        if(snapshotKeys.find(it->first) == snapshotKeys.end()) {
+            it = _encodedChunks.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    for(size_t index : snapshot.regionChunks) {
+        FileChunk fileChunk;
+        fileChunk.payload = snapshot.region->getChunkPayloadAt(index, fileChunk.entry);
+        fileChunk.key = getChunkKey(fileChunk.entry.x, fileChunk.entry.y, fileChunk.entry.z);
+
+        chunks.push_back(fileChunk);
+    }
+
+    // same order as WorldAsset::saveToBuffer, the table is binary searched
+    std::sort(chunks.begin(), chunks.end(), [](const FileChunk& a, const FileChunk& b) {
+        return a.key < b.key;
+    });
+
+    WorldSaveStats stats;
+    stats.chunkCount = chunks.size();
+
+    // identical payloads are written once and their entries share the offset,
+    // by index of the chunk that writes them
+    std::unordered_multimap<uint64_t, size_t> payloads;
+    payloads.reserve(chunks.size());
+
+    uint64_t offset = getWorldFileTableOffset(snapshot.name) + chunks.size() * WORLD_FILE_CHUNK_ENTRY_SIZE;
+    for(size_t i = 0; i < chunks.size(); ++i) {
+        auto& chunk = chunks[i];
+        uint64_t hash = hashBytes(reinterpret_cast<const unsigned char*>(chunk.payload), chunk.entry.payloadSize);
+
+        auto range = payloads.equal_range(hash);
+        for(auto it = range.first; it != range.second; ++it) {
+            const auto& other = chunks[it->second];
+            if(other.entry.encoding == chunk.entry.encoding &&
+               other.entry.payloadSize == chunk.entry.payloadSize &&
+               std::memcmp(other.payload, chunk.payload, chunk.entry.payloadSize) == 0) {
+                chunk.entry.payloadOffset = other.entry.payloadOffset;
+                chunk.shared = true;
+                break;
+            }
+        }
+
+        if(chunk.shared) {
+            stats.savedBytes += chunk.entry.payloadSize;
+            continue;
+        }
+
+        payloads.emplace(hash, i);
+
+        chunk.entry.payloadOffset = offset;
+        offset += chunk.entry.payloadSize;
+
+        stats.payloadCount++;
+        stats.payloadBytes += chunk.entry.payloadSize;
+    }
+
+    std::string header;
+    core::BinaryWriter writer(header);
+
+    writeWorldFileHeader(writer, snapshot.name, static_cast<uint32_t>(chunks.size()), saveId);
+    for(const auto& chunk : chunks) {
+        writeWorldFileChunkEntry(writer, chunk.entry);
+    }
+
+    std::string temporaryPath = path + ".tmp";
+
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::out | std::ios::trunc);
+        if(!file) {
+            throw std::runtime_error("Failed to open file for writing: " + temporaryPath);
+        }
+
+        file.write(header.data(), header.size());
+        for(const auto& chunk : chunks) {
+            if(!chunk.shared) {
+                file.write(chunk.payload, chunk.entry.payloadSize);
+            }
+        }
+
+        file.close();
+        if(!file) {
+            std::error_code ignored;
+            std::filesystem::remove(temporaryPath, ignored);
+
+            throw std::runtime_error("Failed to write to file: " + temporaryPath);
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, path, error);
+    if(error) {
+        std::error_code ignored;
+        std::filesystem::remove(temporaryPath, ignored);
+
+        throw std::runtime_error("Failed to replace " + path + ": " + error.message());
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _lastSaveStats = stats;
+}
+
+void WorldSaver::writeJournal(const WorldSnapshot& changes, const std::string& path) {
+    std::string records;
+    core::BinaryWriter writer(records);
+
+    // a journal the last full save failed to empty holds nothing newer than the file
+    auto journalSaveId = readWorldJournalSaveId(path);
+    bool startOver = !journalSaveId.has_value() || *journalSaveId != _fileSaveId;
+    if(startOver) {
+        writeWorldJournalHeader(writer, _fileSaveId);
+    }
+
+    // removals first, a chunk removed and created again is in both lists
+    for(const auto& coords : changes.removedChunks) {
+        writeWorldJournalRecord(writer, WorldJournalRecordType::REMOVED, coords, ChunkEncoding::RAW, std::string());
+    }
+
+    for(const auto& chunk : changes.chunks) {
+        // the next full save reuses these payloads
+        const auto& encoded = encodeChunk(chunk);
+        writeWorldJournalRecord(writer, WorldJournalRecordType::CHUNK, glm::ivec3(chunk.x, chunk.y, chunk.z), encoded.encoding, encoded.payload);
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::out | (startOver ? std::ios::trunc : std::ios::app));
+    if(!file) {
+        throw std::runtime_error("Failed to open file for writing: " + path);
+    }
+
+    file.write(records.data(), records.size());
+    file.close();
+    if(!file) {
+        throw std::runtime_error("Failed to write to file: " + path);
+    }
+
+    _journalSize = static_cast<size_t>(std::filesystem::file_size(path));
+}
+
+void WorldSaver::resetJournal(const std::string& path, uint16_t saveId) {
+    std::string header;
+    core::BinaryWriter writer(header);
+    writeWorldJournalHeader(writer, saveId);
+
+    std::ofstream file(path, std::ios::binary | std::ios::out | std::ios::trunc);
+    if(!file) {
+        throw std::runtime_error("Failed to open file for writing: " + path);
+    }
+
+    file.write(header.data(), header.size());
+    if(!file) {
+        throw std::runtime_error("Failed to write to file: " + path);
+    }
+
+    _journalSize = header.size();
+}
@@ -0,0 +1,184 @@
+#include "world_streamer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// loads in flight at most, keeps a fast flight from queueing half the region
+const size_t MAX_PENDING_STREAM_LOADS = 64;
+// how far chunks behind the camera are pushed back, at 1 they count as twice as far away
+const float STREAM_VIEW_WEIGHT = 1.0f;
+// a turn of the camera past this (as the dot product of the old and new
+// forward direction) reorders the pending requests
+const float STREAM_RESCAN_DOT = 0.95f;
+
+WorldStreamer::WorldStreamer(World* world)
+    : _world(world),
+#ifdef __EMSCRIPTEN__
+    _ioPool(0) {
+#else
+    _ioPool(2) {
+#endif
+    _loads = std::make_shared<LoadQueue>();
+}
+
+void WorldStreamer::setSettings(const StreamingSettings& settings) {
+    _settings = settings;
+    _needsScan = true;
+}
+
+void WorldStreamer::update(const Camera& camera) {
+    syncRegion();
+    collectLoads();
+
+    if(!_region) {
+        return;
+    }
+
+    glm::mat4 view = camera.getViewMatrix();
+    glm::vec3 forward = -glm::vec3(view[0][2], view[1][2], view[2][2]);
+    glm::ivec3 cameraChunk = glm::ivec3(glm::floor(camera.position / static_cast<float>(CHUNK_SIZE)));
+
+    if(_needsScan || cameraChunk != _scanChunk || glm::dot(forward, _scanForward) < STREAM_RESCAN_DOT) {
+        scan(camera.position, forward);
+
+        _needsScan = false;
+        _scanChunk = cameraChunk;
+        _scanForward = forward;
+    }
+
+    submitLoads();
+}
+
+void WorldStreamer::syncRegion() {
+    if(_world->getRegion() == _region.get()) {
+        return;
+    }
+
+    _region = _world->shareRegion();
+    _regionChunks.clear();
+
+    if(_region) {
+        _regionChunks.reserve(_region->getChunkCount());
+        for(size_t i = 0; i < _region->getChunkCount(); ++i) {
+            _regionChunks.push_back(_region->getChunkCoords(i));
+        }
+    }
+
+    // loads still in flight finish, but their results are dropped
+    _requests.clear();
+    _pendingLoads.clear();
+    _failedLoads.clear();
+    _needsScan = true;
+}
+
+void WorldStreamer::collectLoads() {
+    std::vector<LoadResult> results;
+
+    {
+        std::lock_guard<std::mutex> lock(_loads->mutex);
+        results.swap(_loads->results);
+    }
+
+    for(const auto& result : results) {
+        if(result.region != _region.get()) {
+            continue;
+        }
+
+        uint64_t key = getChunkKey(result.coords.x, result.coords.y, result.coords.z);
+        _pendingLoads.erase(key);
+
+        if(result.failed) {
+            _failedLoads.insert(key);
+            continue;
+        }
+
+        // does nothing if the chunk was loaded or replaced in the meantime
+        _world->installRegionChunk(result.coords.x, result.coords.y, result.coords.z, result.blocks.data());
+    }
+}
+
+void WorldStreamer::scan(const glm::vec3& position, const glm::vec3& forward) {
+    float loadRadiusSquared = _settings.loadRadius * _settings.loadRadius;
+    float unloadRadiusSquared = _settings.unloadRadius * _settings.unloadRadius;
+
+    auto getChunkCenter = [](const glm::ivec3& coords) {
+        return (glm::vec3(coords) + glm::vec3(0.5f)) * static_cast<float>(CHUNK_SIZE);
+    };
+
+    _requests.clear();
+
+    for(size_t i = 0; i < _regionChunks.size(); ++i) {
+        const glm::ivec3& coords = _regionChunks[i];
+
+        glm::vec3 toChunk = getChunkCenter(coords) - position;
+        float distanceSquared = glm::dot(toChunk, toChunk);
+        if(distanceSquared > loadRadiusSquared) {
+            continue;
+        }
+
+        uint64_t key = getChunkKey(coords.x, coords.y, coords.z);
+        if(_pendingLoads.count(key) || _failedLoads.count(key) || !_world->isRegionChunkAvailable(coords.x, coords.y, coords.z)) {
+            continue;
+        }
+
+        float distance = std::sqrt(distanceSquared);
+        float facing = distance > 0.0f ? glm::dot(toChunk / distance, forward) : 1.0f;
+
+        _requests.push_back({ i, coords, distance * (1.0f + (1.0f - facing) * 0.5f * STREAM_VIEW_WEIGHT) });
+    }
+
+    // best request last, submitLoads pops from the back
+    std::sort(_requests.begin(), _requests.end(), [](const LoadRequest& a, const LoadRequest& b) {
+        return a.priority > b.priority;
+    });
+
+    std::vector<glm::ivec3> farChunks;
+    for(const auto& [key, chunk] : _world->getChunks()) {
+        glm::ivec3 coords(chunk->getX(), chunk->getY(), chunk->getZ());
+
+        glm::vec3 toChunk = getChunkCenter(coords) - position;
+        if(glm::dot(toChunk, toChunk) > unloadRadiusSquared) {
+            farChunks.push_back(coords);
+        }
+    }
+
+    // edited chunks refuse and stay loaded
+    for(const auto& coords : farChunks) {
+        _world->unloadChunk(coords.x, coords.y, coords.z);
+    }
+}
+
+void WorldStreamer::submitLoads() {
+    while(!_requests.empty() && _pendingLoads.size() < MAX_PENDING_STREAM_LOADS) {
+        LoadRequest request = _requests.back();
+        _requests.pop_back();
+
+        // loaded through World::getChunk since the scan
+        if(!_world->isRegionChunkAvailable(request.coords.x, request.coords.y, request.coords.z)) {
+            continue;
+        }
+
+        _pendingLoads.insert(getChunkKey(request.coords.x, request.coords.y, request.coords.z));
+
+        auto region = _region;
+        auto loads = _loads;
+
+        _ioPool.submit([region, loads, request]() {
+            LoadResult result;
+            result.region = region.get();
+            result.coords = request.coords;
+            result.failed = false;
+
+            try {
+                region->readChunkAt(request.regionIndex, result.blocks.data());
+            } catch(const std::exception& e) {
+                std::cerr << "Failed to stream chunk (" << request.coords.x << ", " << request.coords.y << ", " << request.coords.z << "): " << e.what() << std::endl;
+                result.failed = true;
+            }
+
+            std::lock_guard<std::mutex> lock(loads->mutex);
+            loads->results.push_back(std::move(result));
+        });
+    }
+}